@@ -29,6 +29,7 @@
 #include "terrain.h"
 #include "transform.h"
 #include "traps.h"
+#include "view.h"
 
 actor::~actor()
 {
@@ -143,6 +144,8 @@ void actor::set_position(const coord_def &c)
 {
     const coord_def oldpos = position;
     position = c;
+    view_mark_dirty(oldpos);
+    view_mark_dirty(c);
     los_actor_moved(this, oldpos);
     areas_actor_moved(this, oldpos);
 }
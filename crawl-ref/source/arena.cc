@@ -7,6 +7,7 @@
 
 #include "arena.h"
 
+#include <chrono>
 #include <stdexcept>
 
 #include "act-iter.h"
@@ -31,12 +32,15 @@
 #include "newgame-def.h"
 #include "ng-init.h"
 #include "prompt.h"
+#include "random.h"
 #include "spl-miscast.h"
+#include "spl-util.h"
 #include "state.h"
 #include "stringutil.h"
 #include "syscalls.h"
 #include "teleport.h"
 #include "terrain.h"
+#include "turn-profiler.h"
 #ifdef USE_TILE
  #include "tileview.h"
 #endif
@@ -184,6 +188,9 @@ namespace arena
 
     static int turns       = 0;
 
+    // -arena-bench bookkeeping; the phase times are turn profiler totals.
+    static int bench_turns = 0;
+
     static bool allow_summons       = true;
     static bool allow_animate       = true;
     static bool allow_chain_summons = true;
@@ -583,7 +590,8 @@ namespace arena
         tiles.resize();
 #endif
 
-        show_fight_banner();
+        if (!crawl_state.arena_bench)
+            show_fight_banner();
     }
 
     static void expand_mlist(int exp)
@@ -825,8 +833,12 @@ namespace arena
 
     static void do_fight()
     {
-        viewwindow();
-        update_screen();
+        const bool bench = crawl_state.arena_bench;
+        if (!bench)
+        {
+            viewwindow();
+            update_screen();
+        }
         clear_messages(true);
 
         {
@@ -837,7 +849,7 @@ namespace arena
                 mprf("---- Turn #%d ----", turns);
 #endif
 
-                if (crawl_state.terminal_resized)
+                if (crawl_state.terminal_resized && !bench)
                     show_fight_banner();
 
                 // Check the consistency of our book-keeping every 100 turns.
@@ -847,16 +859,18 @@ namespace arena
                 you.time_taken = 10;
                 //report_foes();
                 world_reacts();
+                if (bench)
+                    bench_turns++;
                 do_miscasts();
                 do_respawn(faction_a);
                 do_respawn(faction_b);
                 balance_spawners();
-                if (!contest_cancelled)
+                if (!contest_cancelled && !bench)
                     ui::delay(Options.view_delay);
                 clear_messages();
                 ASSERT(you.pet_target == MHITNOT);
             }
-            if (!contest_cancelled)
+            if (!contest_cancelled && !bench)
             {
                 viewwindow();
                 update_screen();
@@ -924,7 +938,8 @@ namespace arena
         else if (faction_a.won)
             team_a_wins++;
 
-        show_fight_banner(true);
+        if (!bench)
+            show_fight_banner(true);
 
         string msg;
         if (was_tied)
@@ -963,6 +978,13 @@ namespace arena
         // Set various options from the arena spec's tags
         parse_monster_spec(); // may throw an arena_error
 
+        if (crawl_state.arena_bench)
+        {
+            total_trials = crawl_state.arena_bench;
+            Options.use_animations = UA_NONE;
+            bench_turns = 0;
+        }
+
         crawl_view.init_geometry();
         expand_mlist(5);
 
@@ -1009,6 +1031,63 @@ namespace arena
         file = nullptr;
     }
 
+    static string bench_percent(int64_t part, int64_t whole)
+    {
+        return whole ? make_stringf("%5.1f%%", 100.0 * part / whole) : "    -";
+    }
+
+    static void write_bench_report(int64_t total_nsecs)
+    {
+        const double secs = total_nsecs / 1e9;
+        printf("Arena benchmark: %d fight%s of %s v %s (seed %" PRIu64 ")\n",
+               trials_done, trials_done == 1 ? "" : "s",
+               faction_a.desc.c_str(), faction_b.desc.c_str(), Options.seed);
+        printf("%d turns in %.3fs: %.1f turns/s\n", bench_turns, secs,
+               secs > 0 ? bench_turns / secs : 0.0);
+
+        const map<string, turn_profile_total> &phases
+            = turn_profile_phase_totals();
+        const char *phase_names[] =
+        {
+            "world_reacts", "handle_monsters", "mons_cast",
+            "enchantments",
+        };
+        for (const char *name : phase_names)
+        {
+            const int64_t nsecs = lookup(phases, name, turn_profile_total())
+                                  .nsecs;
+            printf("  %-16s %10.3fs %s\n", name, nsecs / 1e9,
+                   bench_percent(nsecs, total_nsecs).c_str());
+        }
+
+        const map<spell_type, turn_profile_total> &spell_totals
+            = turn_profile_spell_totals();
+        if (spell_totals.empty())
+            return;
+
+        // Times are inclusive, so a spell which casts another (e.g. a
+        // breath weapon via Serpent of Hell breath) counts both.
+        vector<pair<spell_type, turn_profile_total>> spells(
+            spell_totals.begin(), spell_totals.end());
+        sort(spells.begin(), spells.end(),
+             [](const pair<spell_type, turn_profile_total> &a,
+                const pair<spell_type, turn_profile_total> &b)
+             {
+                 return a.second.nsecs > b.second.nsecs;
+             });
+        const int64_t cast_nsecs
+            = lookup(phases, "mons_cast", turn_profile_total()).nsecs;
+        printf("Spells by time in mons_cast:\n");
+        for (const auto &entry : spells)
+        {
+            printf("  %-30s %7d casts %10.3fs %s %8.1fus/cast\n",
+                   spell_title(entry.first), entry.second.calls,
+                   entry.second.nsecs / 1e9,
+                   bench_percent(entry.second.nsecs, cast_nsecs).c_str(),
+                   entry.second.nsecs / 1e3 / entry.second.calls);
+        }
+    }
+
     static void simulate()
     {
         init_level_connectivity();
@@ -1038,8 +1117,18 @@ namespace arena
         auto ui = make_shared<UIArena>();
         ui::push_layout(ui);
 
+        const bool bench = crawl_state.arena_bench;
+        if (bench)
+            turn_profiler_start_totals();
+        const auto bench_start = chrono::steady_clock::now();
+
         do
         {
+            // Seed each fight separately, so that a benchmark run can be
+            // repeated (or a single slow fight picked out) exactly.
+            if (bench)
+                rng::seed(Options.seed + trials_done);
+
             try
             {
                 setup_fight();
@@ -1052,13 +1141,20 @@ namespace arena
             }
             do_fight();
 
-            if (!contest_cancelled && trials_done < total_trials)
+            if (!contest_cancelled && trials_done < total_trials && !bench)
                 ui::delay(Options.view_delay * 5);
         }
         while (!contest_cancelled && trials_done < total_trials);
 
+        if (bench)
+        {
+            turn_profiler_stop_totals();
+            write_bench_report(chrono::duration_cast<chrono::nanoseconds>(
+                chrono::steady_clock::now() - bench_start).count());
+        }
+
         // why extra delay?
-        if (!contest_cancelled)
+        if (!contest_cancelled && !bench)
             ui::delay(Options.view_delay * 5);
 
         if (trials_done > 0)
@@ -1465,6 +1561,11 @@ static void _choose_arena_teams(newgame_def& choice,
 
     if (!choice.arena_teams.empty())
         return;
+    if (crawl_state.arena_bench)
+    {
+        choice.arena_teams = "random v random";
+        return;
+    }
     arena::skipped_arena_ui = false;
     clear_message_store();
 
@@ -28,12 +28,35 @@ bit_vector::~bit_vector()
     delete[] data;
 }
 
+bit_vector& bit_vector::operator = (const bit_vector& other)
+{
+    if (this == &other)
+        return *this;
+
+    if (nwords != other.nwords)
+    {
+        delete[] data;
+        nwords = other.nwords;
+        data = new unsigned long[nwords];
+    }
+    size = other.size;
+    for (int w = 0; w < nwords; ++w)
+        data[w] = other.data[w];
+    return *this;
+}
+
 void bit_vector::reset()
 {
     for (int w = 0; w < nwords; ++w)
         data[w] = 0;
 }
 
+void bit_vector::init(bool value)
+{
+    for (int w = 0; w < nwords; ++w)
+        data[w] = value ? ULONG_MAX : 0;
+}
+
 bool bit_vector::get(unsigned long index) const
 {
     ASSERT(index < size);
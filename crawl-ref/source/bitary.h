@@ -24,7 +24,10 @@ public:
     bit_vector(const bit_vector& other);
     ~bit_vector();
 
+    bit_vector& operator = (const bit_vector& other);
+
     void reset();
+    void init(bool value);
 
     bool get(unsigned long index) const;
     void set(unsigned long index, bool value = true);
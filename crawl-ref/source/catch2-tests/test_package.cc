@@ -0,0 +1,80 @@
+#include "catch_amalgamated.hpp"
+
+#include "AppHdr.h"
+
+#include "package.h"
+#include "tags.h"
+
+// Big enough to span several blocks and several inflate calls.
+static vector<unsigned char> _test_chunk_data()
+{
+    vector<unsigned char> data;
+    uint32_t x = 12345;
+    for (int i = 0; i < 300000; i++)
+    {
+        // Mostly compressible, with some noise.
+        x = x * 1103515245 + 12345;
+        data.push_back(i % 7 ? (unsigned char)(i / 1000) : x >> 24);
+    }
+    return data;
+}
+
+static void _check_chunk(package &save, const vector<unsigned char> &data)
+{
+    {
+        reader r(&save, "test");
+
+        vector<unsigned char> got(data.size());
+        r.read(got.data(), got.size());
+        REQUIRE(got == data);
+        REQUIRE(unmarshallInt(r) == 0x12345678);
+        REQUIRE(r.valid() == false);
+
+        r.set_safe_read(true);
+        REQUIRE_THROWS_AS(r.readByte(), short_read_exception);
+    }
+
+    chunk_reader *inf = save.reader("test");
+    vector<unsigned char> got;
+    inf->read_all(got);
+    delete inf;
+
+    REQUIRE(got.size() == data.size() + 4);
+    REQUIRE(equal(data.begin(), data.end(), got.begin()));
+}
+
+TEST_CASE( "Package chunks can be read back", "[single-file]" ) {
+
+    const vector<unsigned char> data = _test_chunk_data();
+    package save;
+    {
+        writer w(&save, "test");
+        w.write(data.data(), data.size());
+        marshallInt(w, 0x12345678);
+    }
+
+    SECTION ("with mmap") {
+        save.set_mmap(true);
+        _check_chunk(save, data);
+    }
+
+    SECTION ("without mmap") {
+        save.set_mmap(false);
+        _check_chunk(save, data);
+    }
+}
+
+TEST_CASE( "Deferred chunks can be read back before deferral ends",
+           "[single-file]" ) {
+
+    const vector<unsigned char> data = _test_chunk_data();
+    package save;
+    deferred_compression defer(&save);
+    {
+        writer w(&save, "test");
+        w.write(data.data(), data.size());
+        marshallInt(w, 0x12345678);
+    }
+
+    _check_chunk(save, data);
+}
@@ -0,0 +1,128 @@
+#include "catch_amalgamated.hpp"
+
+#include "AppHdr.h"
+
+#include "pattern.h"
+
+static const vector<string> test_patterns =
+{
+    "You have reached level",
+    "You feel (a|an) (strange|odd) sense",
+    "^The .* (hits|bites) you",
+    "comes? into view",
+    "ogres?",
+    "orb of (fire|winter)",
+    "[Yy]ou (kill|destroy) the",
+    "\\+[0-9]+ short sword",
+    "lernaean hydra|juggernaut",
+    "You are engulfed in noxious fumes!",
+    "level [[:digit:]]+!$",
+    "\\bboris\\b",
+    "(?i)sigmund",
+    "a{2,}rgh",
+    ".",
+    "",
+    "\\<foo\\>",
+    "foo\\'",
+};
+
+static const vector<string> test_messages =
+{
+    "You have reached level 12!",
+    "You feel a strange sense of loss.",
+    "You feel an odd sense of loss.",
+    "The goblin hits you.",
+    "A goblin hits you.",
+    "The ogre comes into view.",
+    "Two ogres come into view.",
+    "The orb of fire casts a spell.",
+    "you kill the rat!",
+    "You see here a +2 short sword.",
+    "The juggernaut is out of view.",
+    "You are engulfed in noxious fumes!",
+    "Boris shouts!",
+    "SIGMUND shouts!",
+    "Aaaargh!",
+    "a foo b",
+    "ends with foo",
+    "",
+};
+
+TEST_CASE( "Pattern sets match like their patterns one at a time",
+           "[single-file]" ) {
+
+    const bool icase = GENERATE(false, true);
+    const bool prefilter = GENERATE(false, true);
+    CAPTURE(icase, prefilter);
+    set_pattern_prefilter(prefilter);
+
+    pattern_set set;
+    vector<text_pattern> patterns;
+    for (const string &pattern : test_patterns)
+    {
+        patterns.emplace_back(pattern, icase);
+        set.add(patterns.back());
+    }
+
+    for (const string &message : test_messages)
+    {
+        CAPTURE(message);
+        vector<size_t> expected;
+        for (size_t i = 0; i < patterns.size(); ++i)
+            if (patterns[i].matches(message))
+                expected.push_back(i);
+
+        REQUIRE(set.matches(message) == expected);
+        REQUIRE(set.first_match(message)
+                == (expected.empty() ? -1 : (int) expected[0]));
+    }
+
+    SECTION ("wanted patterns are skipped") {
+        auto odd = [](size_t i) { return i % 2 == 1; };
+        for (const string &message : test_messages)
+        {
+            CAPTURE(message);
+            int expected = -1;
+            for (size_t i = 0; i < patterns.size() && expected < 0; ++i)
+                if (odd(i) && patterns[i].matches(message))
+                    expected = i;
+            REQUIRE(set.first_match(message, odd) == expected);
+        }
+    }
+
+    SECTION ("updating only recompiles when the patterns change") {
+        auto same = [](const text_pattern &p) -> const text_pattern &
+        {
+            return p;
+        };
+        set.update(patterns, same);
+        REQUIRE(set.size() == patterns.size());
+
+        patterns.erase(patterns.begin());
+        set.update(patterns, same);
+        REQUIRE(set.size() == patterns.size());
+        REQUIRE(set.first_match("You have reached level 3") == 13);
+    }
+
+    set_pattern_prefilter(true);
+}
+
+TEST_CASE( "Required literals of a regex are found safely", "[single-file]" ) {
+
+    const vector<string> none;
+    REQUIRE(regex_required_literals("The .* hits you")
+            == vector<string>({ "the ", " hits you" }));
+    REQUIRE(regex_required_literals("comes? into")
+            == vector<string>({ "come", " into" }));
+    REQUIRE(regex_required_literals("a(b|c)de") == vector<string>({ "a", "de" }));
+    REQUIRE(regex_required_literals("\\+[0-9]+ sword")
+            == vector<string>({ "+", " sword" }));
+    REQUIRE(regex_required_literals("[[:digit:]]abc")
+            == vector<string>({ "abc" }));
+    REQUIRE(regex_required_literals("[^]x]abc") == vector<string>({ "abc" }));
+    REQUIRE(regex_required_literals("\\<foo\\>") == vector<string>({ "foo" }));
+    REQUIRE(regex_required_literals("foo\\'") == vector<string>({ "foo" }));
+    REQUIRE(regex_required_literals("ogre|troll") == none);
+    REQUIRE(regex_required_literals("(?i)sigmund") == none);
+    REQUIRE(regex_required_literals("[a\\]b") == none);
+}
@@ -0,0 +1,182 @@
+#include <random>
+
+#include "catch_amalgamated.hpp"
+
+#include "AppHdr.h"
+
+#include "coordit.h"
+#include "env.h"
+#include "feature.h"
+#include "shout.h"
+#include "terrain.h"
+
+// The noise propagation that noise_grid::wavefront() replaced, with one
+// struct per cell, kept here to check that the two agree.
+namespace old_noise
+{
+    struct noise_cell
+    {
+        coord_def neighbour_delta;
+        int16_t noise_id = -1;
+        int noise_intensity_millis = 0;
+        int noise_travel_distance = 0;
+
+        bool can_apply_noise(int intensity) const
+        {
+            return noise_intensity_millis < intensity;
+        }
+
+        bool apply_noise(int intensity, int id, int distance,
+                         const coord_def &delta)
+        {
+            if (!can_apply_noise(intensity))
+                return false;
+            noise_id = id;
+            noise_intensity_millis = intensity;
+            noise_travel_distance = distance;
+            neighbour_delta = delta;
+            return true;
+        }
+
+        int turn_angle(const coord_def &next_delta) const
+        {
+            if (neighbour_delta.origin())
+                return 0;
+            if (next_delta.x == -neighbour_delta.x
+                && next_delta.y == -neighbour_delta.y)
+            {
+                return 4;
+            }
+            return abs(neighbour_delta.x - next_delta.x)
+                   + abs(neighbour_delta.y - next_delta.y);
+        }
+    };
+
+    static int attenuation_millis(const coord_def &pos)
+    {
+        const dungeon_feature_type feat = env.grid(pos);
+        if (feat_is_permarock(feat))
+            return NOISE_ATTENUATION_COMPLETE;
+        return BASE_NOISE_ATTENUATION_MILLIS *
+                (feat_is_wall(feat)        ? 12 :
+                 feat_is_closed_door(feat) ?  8 :
+                 feat_is_tree(feat)        ?  3 :
+                 feat_is_statuelike(feat)  ?  2 :
+                                              1);
+    }
+
+    static vector<noise_heard> propagate(vector<noise_t> noises)
+    {
+        FixedArray<noise_cell, GXM, GYM> cells;
+        vector<noise_t> registered;
+        for (noise_t &noise : noises)
+        {
+            noise_cell &cell = cells(noise.noise_source);
+            if (cell.apply_noise(noise.noise_intensity_millis,
+                                 registered.size(), 0, coord_def(0, 0)))
+            {
+                noise.noise_id = registered.size();
+                registered.push_back(noise);
+            }
+        }
+
+        vector<noise_heard> heard;
+        vector<coord_def> perimeter[2];
+        int circ = 0;
+        for (const noise_t &noise : registered)
+            perimeter[circ].push_back(noise.noise_source);
+
+        int travel_distance = 0;
+        while (!perimeter[circ].empty())
+        {
+            ++travel_distance;
+            for (const coord_def &p : perimeter[circ])
+            {
+                const noise_cell &cell = cells(p);
+                if (!noise_is_audible(cell.noise_intensity_millis))
+                    continue;
+                heard.push_back({ p, cell.noise_intensity_millis,
+                                  cell.noise_id,
+                                  cell.noise_travel_distance });
+
+                const int attenuation = attenuation_millis(p);
+                if (!noise_is_audible(cell.noise_intensity_millis
+                                      - attenuation))
+                {
+                    continue;
+                }
+                for (int xi = -1; xi <= 1; ++xi)
+                    for (int yi = -1; yi <= 1; ++yi)
+                    {
+                        const coord_def d(xi, yi);
+                        const coord_def q = p + d;
+                        if (d.origin() || !in_bounds(q))
+                            continue;
+                        noise_cell &next = cells(q);
+                        if (!next.can_apply_noise(cell.noise_intensity_millis
+                                                  - attenuation))
+                        {
+                            continue;
+                        }
+                        const int angle = cell.turn_angle(d);
+                        const int intensity = cell.noise_intensity_millis
+                            - (angle ? attenuation * (100 + angle * 25) / 100
+                                     : attenuation);
+                        if (!noise_is_audible(intensity))
+                            continue;
+                        const int old_distance = next.noise_travel_distance;
+                        if (next.apply_noise(intensity, cell.noise_id,
+                                             travel_distance, d)
+                            && old_distance != travel_distance)
+                        {
+                            perimeter[!circ].push_back(q);
+                        }
+                    }
+            }
+            perimeter[circ].clear();
+            circ = !circ;
+        }
+        return heard;
+    }
+}
+
+TEST_CASE( "Noise wavefront matches the old noise propagation",
+           "[single-file]" ) {
+
+    init_show_table();
+    const int seed = GENERATE(1, 2, 3, 4, 5, 6, 7, 8);
+    CAPTURE(seed);
+    mt19937 rng(seed);
+
+    const dungeon_feature_type feats[] =
+    {
+        DNGN_FLOOR, DNGN_FLOOR, DNGN_FLOOR, DNGN_FLOOR, DNGN_FLOOR,
+        DNGN_FLOOR, DNGN_ROCK_WALL, DNGN_CLOSED_DOOR, DNGN_TREE,
+        DNGN_GRANITE_STATUE, DNGN_PERMAROCK_WALL,
+    };
+    for (rectangle_iterator ri(0); ri; ++ri)
+        env.grid(*ri) = feats[rng() % ARRAYSZ(feats)];
+
+    noise_grid grid;
+    vector<noise_t> noises;
+    const int count = 1 + rng() % 12;
+    for (int i = 0; i < count; ++i)
+    {
+        // Some noises share a source, to check that only the loudest of
+        // those is kept.
+        const coord_def where = i && rng() % 4 == 0
+                                ? noises[rng() % noises.size()].noise_source
+                                : coord_def(X_BOUND_1 + rng() % (X_WIDTH),
+                                            Y_BOUND_1 + rng() % (Y_WIDTH));
+        noises.emplace_back(where, "", (2 + rng() % 40) * 1000);
+        grid.register_noise(noises.back());
+    }
+
+    const vector<noise_heard> heard = grid.wavefront();
+    REQUIRE_FALSE(heard.empty());
+    REQUIRE(heard == old_noise::propagate(noises));
+
+    SECTION ("the wavefront is cleared between uses") {
+        REQUIRE(grid.wavefront() == heard);
+    }
+}
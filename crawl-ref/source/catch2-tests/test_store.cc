@@ -0,0 +1,70 @@
+#include "catch_amalgamated.hpp"
+
+#include "AppHdr.h"
+
+#include "store.h"
+#include "tags.h"
+
+static const prop_key test_key("test_interned");
+static const prop_key other_key("test_interned_other");
+
+TEST_CASE( "Interned keys find the same properties as strings",
+           "[single-file]" ) {
+
+    CrawlHashTable props;
+
+    SECTION ("missing keys are noticed once inserted") {
+        REQUIRE_FALSE(props.exists(test_key));
+        props["test_interned"] = 3;
+        REQUIRE(props.exists(test_key));
+        REQUIRE(props[test_key].get_int() == 3);
+    }
+
+    SECTION ("erasing forgets where a key was") {
+        props[test_key] = 4;
+        props[other_key] = 5;
+        REQUIRE(props.exists(test_key));
+        props.erase("test_interned");
+        REQUIRE_FALSE(props.exists(test_key));
+        REQUIRE(props[other_key].get_int() == 5);
+        props[test_key] = 6;
+        REQUIRE(props["test_interned"].get_int() == 6);
+        REQUIRE(props.erase(test_key) == 1);
+        REQUIRE(props.erase(test_key) == 0);
+        REQUIRE(props.size() == 1);
+    }
+
+    SECTION ("copies and clears don't share lookups") {
+        props[test_key] = 7;
+        REQUIRE(props.exists(test_key));
+
+        CrawlHashTable copy = props;
+        copy[test_key] = 8;
+        REQUIRE(props[test_key].get_int() == 7);
+        REQUIRE(copy[test_key].get_int() == 8);
+
+        props.clear();
+        REQUIRE_FALSE(props.exists(test_key));
+        REQUIRE(copy.exists(test_key));
+
+        props = copy;
+        copy.erase(test_key);
+        REQUIRE(props[test_key].get_int() == 8);
+    }
+
+    SECTION ("tables using interned keys save as before") {
+        props[test_key] = 9;
+        props["plain"] = true;
+
+        vector<unsigned char> data;
+        writer w(&data);
+        props.write(w);
+
+        CrawlHashTable loaded;
+        reader r(data);
+        loaded.read(r);
+        REQUIRE(loaded.size() == 2);
+        REQUIRE(loaded[test_key].get_int() == 9);
+        REQUIRE(loaded["plain"].get_bool());
+    }
+}
@@ -44,6 +44,7 @@
 #include "rltiles/tiledef-main.h"
 #include "traps.h"
 #include "unwind.h"
+#include "view.h"
 #include "xom.h"
 
 cloud_struct* cloud_at(coord_def pos)
@@ -403,6 +404,7 @@ static bool _killer_whose_match(kill_category whose, killer_type killer)
  */
 static void _los_cloud_changed(const coord_def& p, const cloud_type t, const cloud_type old)
 {
+    view_mark_dirty(p);
     if (is_opaque_cloud(t) || is_opaque_cloud(old))
         los_terrain_changed(p);
 }
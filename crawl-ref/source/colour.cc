@@ -679,12 +679,21 @@ void init_element_colours()
                        ));
 }
 
+static unsigned int _element_colours_evaluated = 0;
+
+unsigned int element_colours_evaluated()
+{
+    return _element_colours_evaluated;
+}
+
 int element_colour(int element, bool no_random, const coord_def& loc)
 {
     // pass regular colours through for safety.
     if (!_is_element_colour(element))
         return element;
 
+    _element_colours_evaluated++;
+
     // Strip COLFLAGs just in case.
     element &= 0x007f;
 
@@ -124,6 +124,9 @@ colour_t make_low_colour(colour_t colour) IMMUTABLE;
 colour_t make_high_colour(colour_t colour) IMMUTABLE;
 int  element_colour(int element, bool no_random = false,
                     const coord_def& loc = coord_def());
+// How many element colours have been evaluated so far. Anything drawn while
+// this changes may look different the next time it's drawn.
+unsigned int element_colours_evaluated();
 int get_disjunct_phase(const coord_def& loc);
 bool get_vortex_phase(const coord_def& loc);
 bool get_orb_phase(const coord_def& loc);
@@ -110,6 +110,23 @@ function script.simple_args()
                      args)
 end
 
+-- Levels of several kinds, for benchmark scripts.
+script.BENCH_PLACES = { "D:1", "D:8", "Lair:3", "Orc:2", "Elf:2", "Vaults:3",
+                        "Zot:2" }
+
+-- The places given as script arguments from index first on, or defaults
+-- (script.BENCH_PLACES if nil) if there are none.
+function script.place_args(args, first, defaults)
+  local places = { }
+  for i = first, #args do
+    table.insert(places, args[i])
+  end
+  if #places == 0 then
+    return defaults or script.BENCH_PLACES
+  end
+  return places
+end
+
 function script.usage(ustr)
   ustr = string.gsub(string.gsub(ustr, "^%s+", ""), "%s+$", "")
   error("\n" .. ustr)
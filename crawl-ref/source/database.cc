@@ -23,6 +23,7 @@
 #include "random.h"
 #include "stringutil.h"
 #include "syscalls.h"
+#include "textdb.h"
 #include "unicode.h"
 
 // TextDB handles dependency checking the db vs text files, creating the
@@ -37,11 +38,9 @@ public:
     ~TextDB() { shutdown(true); delete translation; }
     void init();
     void shutdown(bool recursive = false);
-    DBM* get() { return _db; }
+    const textdb_file *get() const { return _db; }
 
-    // Make it easier to migrate from raw DBM* to TextDB
     operator bool() const { return _db != 0; }
-    operator DBM*() const { return _db; }
 
  private:
     bool _needs_update() const;
@@ -52,7 +51,7 @@ public:
     const char* const _db_name;
     string _directory;
     vector<string> _input_files;
-    DBM* _db;
+    textdb_file *_db;
     string timestamp;
     TextDB *_parent;
     const char* lang() { return _parent ? Options.lang_name : 0; }
@@ -60,13 +59,12 @@ public:
     TextDB *translation;
 };
 
-// Convenience functions for (read-only) access to generic
-// berkeley DB databases.
-static void _store_text_db(const string &in, DBM *db);
+// Convenience functions for building and reading the compiled databases.
+static void _store_text_db(const string &in, map<string, string> &db);
 
 static string _query_database(TextDB &db, string key, bool canonicalise_key,
                               bool run_lua, bool untranslated = false);
-static void _add_entry(DBM *db, const string &k, string &v);
+static void _add_entry(map<string, string> &db, const string &k, string &v);
 
 static TextDB AllDBs[] =
 {
@@ -186,15 +184,16 @@ bool TextDB::open_db()
     if (_db)
         return true;
 
-    const string full_db_path = _db_cache_path(_db_name, lang());
-    _db = dbm_open(full_db_path.c_str(), O_RDONLY, 0660);
-    if (!_db)
-        return false;
-
-    timestamp = _query_database(*this, "TIMESTAMP", false, false, true);
-    if (timestamp.empty())
+    const string full_db_path = _db_cache_path(_db_name, lang()) + ".tdb";
+    _db = new textdb_file;
+    if (!_db->open(full_db_path))
+    {
+        delete _db;
+        _db = nullptr;
         return false;
+    }
 
+    timestamp = _db->timestamp();
     return true;
 }
 
@@ -223,7 +222,7 @@ void TextDB::shutdown(bool recursive)
 {
     if (_db)
     {
-        dbm_close(_db);
+        delete _db;
         _db = nullptr;
     }
     if (recursive && translation)
@@ -288,7 +287,7 @@ void TextDB::_regenerate_db()
     }
 
     string db_path = _db_cache_path(_db_name, lang());
-    string full_db_path = db_path + ".db";
+    string full_db_path = db_path + ".tdb";
 
     {
         string output_dir = get_parent_directory(db_path);
@@ -296,14 +295,12 @@ void TextDB::_regenerate_db()
             end(1, false, "Cannot create db directory '%s'.", output_dir.c_str());
     }
 
+    // The new file replaces the old one atomically, so processes that
+    // still have the old one mapped are unaffected.
     file_lock lock(db_path + ".lk", "wb");
-#ifndef DGL_REWRITE_PROTECT_DB_FILES
-    unlink_u(full_db_path.c_str());
-#endif
 
     string ts;
-    if (!(_db = dbm_open(db_path.c_str(), O_RDWR | O_CREAT, 0660)))
-        end(1, true, "Unable to open DB: %s", db_path.c_str());
+    map<string, string> entries;
     for (const string &file : _input_files)
     {
         string full_input_path = _directory + file;
@@ -315,13 +312,12 @@ void TextDB::_regenerate_db()
         {
             snprintf(buf, sizeof(buf), ":%" PRId64, (int64_t)mtime);
             ts += buf;
-            _store_text_db(full_input_path, _db);
+            _store_text_db(full_input_path, entries);
         }
     }
-    _add_entry(_db, "TIMESTAMP", ts);
 
-    dbm_close(_db);
-    _db = 0;
+    if (!textdb_file::write(full_db_path, entries, ts))
+        end(1, true, "Unable to write DB: %s", full_db_path.c_str());
 }
 
 // ----------------------------------------------------------------------
@@ -345,24 +341,16 @@ void databaseSystemShutdown()
 ////////////////////////////////////////////////////////////////////////////
 // Main DB functions
 
-static datum _database_fetch(DBM *database, const string &key)
+static string _database_fetch(const textdb_file *database,
+                              const string &key)
 {
-    datum result;
-    result.dptr = nullptr;
-    result.dsize = 0;
-    datum dbKey;
-
-    dbKey.dptr = (DPTR_COERCE) key.c_str();
-    dbKey.dsize = key.length();
-
     // Don't use the database if called from "monster".
-    if (database)
-        result = dbm_fetch(database, dbKey);
-
-    return result;
+    if (!database)
+        return "";
+    return database->find(key);
 }
 
-static vector<string> _database_find_keys(DBM *database,
+static vector<string> _database_find_keys(const textdb_file *database,
                                           const string &regex,
                                           bool ignore_case,
                                           db_find_filter filter = nullptr)
@@ -370,11 +358,13 @@ static vector<string> _database_find_keys(DBM *database,
     text_pattern             tpat(regex, ignore_case);
     vector<string> matches;
 
-    datum dbKey = dbm_firstkey(database);
-
-    while (dbKey.dptr != nullptr)
+    // The index is over lowercased text, so only use it when the case of
+    // the match doesn't matter.
+    const vector<unsigned int> entries = ignore_case
+        ? database->candidates(regex) : database->candidates("");
+    for (unsigned int entry : entries)
     {
-        string key((const char *)dbKey.dptr, dbKey.dsize);
+        const string key = database->key(entry);
 
         if (tpat.matches(key)
             && key.find("__") == string::npos
@@ -382,14 +372,12 @@ static vector<string> _database_find_keys(DBM *database,
         {
             matches.push_back(key);
         }
-
-        dbKey = dbm_nextkey(database);
     }
 
     return matches;
 }
 
-static vector<string> _database_find_bodies(DBM *database,
+static vector<string> _database_find_bodies(const textdb_file *database,
                                             const string &regex,
                                             bool ignore_case,
                                             db_find_filter filter = nullptr)
@@ -397,14 +385,12 @@ static vector<string> _database_find_bodies(DBM *database,
     text_pattern             tpat(regex, ignore_case);
     vector<string> matches;
 
-    datum dbKey = dbm_firstkey(database);
-
-    while (dbKey.dptr != nullptr)
+    const vector<unsigned int> entries = ignore_case
+        ? database->candidates(regex) : database->candidates("");
+    for (unsigned int entry : entries)
     {
-        string key((const char *)dbKey.dptr, dbKey.dsize);
-
-        datum dbBody = dbm_fetch(database, dbKey);
-        string body((const char *)dbBody.dptr, dbBody.dsize);
+        const string key = database->key(entry);
+        const string body = database->body(entry);
 
         if (tpat.matches(body)
             && key.find("__") == string::npos
@@ -412,8 +398,6 @@ static vector<string> _database_find_bodies(DBM *database,
         {
             matches.push_back(key);
         }
-
-        dbKey = dbm_nextkey(database);
     }
 
     return matches;
@@ -485,21 +469,14 @@ static void _trim_leading_newlines(string &s)
     s.erase(0, s.find_first_not_of("\n"));
 }
 
-static void _add_entry(DBM *db, const string &k, string &v)
+static void _add_entry(map<string, string> &db, const string &k, string &v)
 {
     _trim_leading_newlines(v);
-    datum key, value;
-    key.dptr = (char *) k.c_str();
-    key.dsize = k.length();
-
-    value.dptr = (char *) v.c_str();
-    value.dsize = v.length();
-
-    if (dbm_store(db, key, value, DBM_REPLACE))
-        end(1, true, "Error storing %s", k.c_str());
+    // Later entries replace earlier ones.
+    db[k] = v;
 }
 
-static void _parse_text_db(LineInput &inf, DBM *db)
+static void _parse_text_db(LineInput &inf, map<string, string> &db)
 {
     string key;
     string value;
@@ -542,7 +519,7 @@ static void _parse_text_db(LineInput &inf, DBM *db)
         _add_entry(db, key, value);
 }
 
-static void _store_text_db(const string &in, DBM *db)
+static void _store_text_db(const string &in, map<string, string> &db)
 {
     UTF8FileLineInput inf(in.c_str());
     if (inf.error())
@@ -622,14 +599,14 @@ static string _getWeightedString(TextDB &db, const string &key,
     lowercase(canonical_key);
 
     // Query the DB.
-    datum result;
+    string result;
 
     if (db.translation)
         result = _database_fetch(db.translation->get(), canonical_key);
-    if (result.dsize <= 0)
+    if (result.empty())
         result = _database_fetch(db.get(), canonical_key);
 
-    if (result.dsize <= 0)
+    if (result.empty())
     {
         // Try ignoring the suffix.
         canonical_key = key;
@@ -638,17 +615,14 @@ static string _getWeightedString(TextDB &db, const string &key,
         // Query the DB.
         if (db.translation)
             result = _database_fetch(db.translation->get(), canonical_key);
-        if (result.dsize <= 0)
+        if (result.empty())
             result = _database_fetch(db.get(), canonical_key);
 
-        if (result.dsize <= 0)
+        if (result.empty())
             return "";
     }
 
-    // Cons up a (C++) string to return. The caller must release it.
-    string str = string((const char *)result.dptr, result.dsize);
-
-    return _chooseStrByWeight(str, fixed_weight);
+    return _chooseStrByWeight(result, fixed_weight);
 }
 
 static void _call_recursive_replacement(string &str, TextDB &db,
@@ -736,18 +710,16 @@ static string _query_database(TextDB &db, string key, bool canonicalise_key,
     }
 
     // Query the DB.
-    datum result;
+    string str;
 
     if (db.translation && !untranslated)
-        result = _database_fetch(db.translation->get(), key);
-    if (result.dsize <= 0)
-        result = _database_fetch(db.get(), key);
+        str = _database_fetch(db.translation->get(), key);
+    if (str.empty())
+        str = _database_fetch(db.get(), key);
 
-    if (result.dsize <= 0)
+    if (str.empty())
         return "";
 
-    string str((const char *)result.dptr, result.dsize);
-
     // <foo> is an alias to key foo
     if (str[0] == '<' && str[str.size() - 2] == '>'
         && str.find('<', 1) == str.npos
@@ -807,8 +779,7 @@ vector<string> getLongDescBodiesByRegex(const string &regex,
     // On partial translations, this will match only translated descriptions.
     // Not good, but otherwise we'd have to check hundreds of keys, with
     // two queries for each.
-    // SQL can do this in one go, DBM can't.
-    DBM *database = DescriptionDB.translation ?
+    const textdb_file *database = DescriptionDB.translation ?
         DescriptionDB.translation->get() : DescriptionDB.get();
     return _database_find_bodies(database, regex, true, filter);
 }
@@ -7,10 +7,13 @@
 
 #include "dbg-maps.h"
 
+#include <cerrno>
+
 #include "branch.h"
 #include "chardump.h"
 #include "crash.h"
 #include "dbg-objstat.h"
+#include "dbg-shard.h"
 #include "dungeon.h"
 #include "env.h"
 #include "initfile.h"
@@ -19,12 +22,15 @@
 #include "message.h"
 #include "ng-init.h"
 #include "ng-setup.h"
+#include "options.h"
 #include "player.h"
+#include "random.h"
 #include "shopping.h"
 #include "state.h"
 #include "stringutil.h"
 #include "syscalls.h"
 #include "tag-version.h"
+#include "version.h"
 #include "view.h"
 
 #ifdef DEBUG_STATISTICS
@@ -220,11 +226,20 @@ static bool _build_dungeon()
     return true;
 }
 
+static bool _iteration_in_shard(int iter)
+{
+    return !SysEnv.map_gen_shards
+           || iter % SysEnv.map_gen_shards == SysEnv.map_gen_shard - 1;
+}
+
 /**
  * Build dungeon levels for mapstat or objstat.
  *
  * The exact branches/levels built and number of build iterations is set by the
- * command-line options for mapstat/objstat.
+ * command-line options for mapstat/objstat. With -shard k/N, only every Nth
+ * iteration is built, starting from the kth. Each iteration is built from its
+ * own seed, so a run split into shards builds the same levels as one that
+ * isn't.
 
  * @returns True if all iterations built successfully. For mapstat, this can
  * return false if an iteration produced a disconnected level, since for
@@ -241,6 +256,9 @@ bool mapstat_build_levels()
     fflush(stdout);
     for (int i = 0; i < SysEnv.map_gen_iters; ++i)
     {
+        if (!_iteration_in_shard(i))
+            continue;
+
         clear_messages();
         mprf("On %d of %d; %d g, %d fail, %u err%s, %u uniq, "
              "%d try, %d (%.2f%%) vetoes",
@@ -252,6 +270,7 @@ bool mapstat_build_levels()
         printf("%d..", i + 1);
         fflush(stdout);
 
+        rng::seed(crawl_state.seed + i);
         dgn_reset_player_data();
         initial_dungeon_setup();
 
@@ -327,6 +346,7 @@ static void _write_map_stats()
     fprintf(outf, "Levels attempted: %d, built: %d, failed: %d\n",
             levels_tried, levels_tried - levels_failed,
             levels_failed);
+    mapstat_report_map_index(outf);
     if (!errors.empty())
     {
         fprintf(outf, "\n\nMap errors:\n");
@@ -494,6 +514,203 @@ bool mapstat_find_forced_map()
     return true;
 }
 
+/**
+ * Choose the seed that mapstat and objstat iterations are built from:
+ * iteration i is built from the seed plus i.
+ *
+ * @returns False if this is a shard of a run that wasn't given a seed, since
+ * the shards would then not share out the same iterations.
+ */
+bool mapstat_choose_seed()
+{
+    crawl_state.seed = Options.seed;
+    if (!crawl_state.seed && SysEnv.map_gen_shards)
+    {
+        printf("-shard requires -seed, and the same seed for every shard.\n");
+        return false;
+    }
+    while (!crawl_state.seed)
+        crawl_state.seed = rng::get_uint64();
+    you.game_seed = crawl_state.seed;
+
+    if (SysEnv.map_gen_shards)
+    {
+        printf("Building shard %d of %d from seed %" PRIu64 ".\n",
+               SysEnv.map_gen_shard, SysEnv.map_gen_shards, crawl_state.seed);
+    }
+    else
+        printf("Building from seed %" PRIu64 ".\n", crawl_state.seed);
+    return true;
+}
+
+// Bump this whenever what goes into a shard file changes.
+static const int SHARD_FORMAT = 1;
+
+static string _shard_file(const char *kind, int shard)
+{
+    return make_stringf("%s-%d-of-%d.shard", kind, shard,
+                        SysEnv.map_gen_shards);
+}
+
+/**
+ * Write the stats of a -shard run, for -merge-shards to add up later.
+ *
+ * @param kind        "mapstat" or "objstat", for the file name and to check
+ *                    the right kind of file is merged.
+ * @param write_stats Writes the stat tables themselves.
+ * @returns True if the file was written.
+ */
+bool mapstat_write_shard(const char *kind, void (*write_stats)(writer &))
+{
+    const string out_file = _shard_file(kind, SysEnv.map_gen_shard);
+    FILE *outf = fopen_u(out_file.c_str(), "wb");
+    if (!outf)
+    {
+        printf("Couldn't open %s: %s\n", out_file.c_str(), strerror(errno));
+        return false;
+    }
+
+    writer th(out_file, outf);
+    marshallString(th, kind);
+    marshallInt(th, SHARD_FORMAT);
+    marshallString(th, Version::Long);
+    marshallInt(th, SysEnv.map_gen_shard);
+    marshallInt(th, SysEnv.map_gen_shards);
+    marshallInt(th, SysEnv.map_gen_iters);
+    marshallUnsigned(th, crawl_state.seed);
+    marshallString(th, crawl_state.force_map);
+    marshallInt(th, generated_levels.size());
+    for (const level_id &lid : generated_levels)
+        marshall_level_id(th, lid);
+    write_stats(th);
+    fclose(outf);
+
+    printf("Wrote shard %d of %d to %s.\n", SysEnv.map_gen_shard,
+           SysEnv.map_gen_shards, out_file.c_str());
+    return true;
+}
+
+// Check that a shard file is the given shard of the same run as the shards
+// before it, returning what's wrong if it isn't.
+static string _read_shard_header(reader &th, const char *kind, int shard,
+                                 int &iters, uint64_t &seed)
+{
+    if (unmarshallString(th) != kind || unmarshallInt(th) != SHARD_FORMAT)
+        return make_stringf("not a %s shard", kind);
+    if (unmarshallString(th) != Version::Long)
+        return "written by a different version of crawl";
+    if (unmarshallInt(th) != shard
+        || unmarshallInt(th) != SysEnv.map_gen_shards)
+    {
+        return make_stringf("not shard %d of %d", shard,
+                            SysEnv.map_gen_shards);
+    }
+
+    const int shard_iters = unmarshallInt(th);
+    const uint64_t shard_seed = unmarshallUnsigned(th);
+    if (shard == 1)
+    {
+        iters = shard_iters;
+        seed = shard_seed;
+    }
+    else if (shard_iters != iters || shard_seed != seed)
+        return "built with a different -iters or -seed from shard 1";
+
+    if (unmarshallString(th) != crawl_state.force_map)
+        return "built with a different -force-map";
+    if (unmarshallInt(th) != (int) generated_levels.size())
+        return "built for different levels";
+    for (const level_id &lid : generated_levels)
+        if (unmarshall_level_id(th) != lid)
+            return "built for different levels";
+    return "";
+}
+
+/**
+ * Add up the stats of all the shards of a -shard run.
+ *
+ * @param kind        "mapstat" or "objstat".
+ * @param merge_stats Reads the stat tables written by the shard's
+ *                    write_stats and adds them to the current ones.
+ * @returns True if every shard was read. The iteration count and seed are
+ * then those of the whole run.
+ */
+bool mapstat_merge_shards(const char *kind, void (*merge_stats)(reader &))
+{
+    if (!generated_levels.size())
+        _dungeon_places();
+
+    int iters = 0;
+    uint64_t seed = 0;
+    for (int shard = 1; shard <= SysEnv.map_gen_shards; ++shard)
+    {
+        const string in_file = _shard_file(kind, shard);
+        reader th(in_file);
+        if (!th.valid())
+        {
+            printf("Couldn't read %s.\n", in_file.c_str());
+            return false;
+        }
+
+        th.set_safe_read(true);
+        try
+        {
+            const string err = _read_shard_header(th, kind, shard, iters,
+                                                  seed);
+            if (!err.empty())
+            {
+                printf("%s is %s.\n", in_file.c_str(), err.c_str());
+                return false;
+            }
+            merge_stats(th);
+        }
+        catch (short_read_exception &)
+        {
+            printf("%s is truncated.\n", in_file.c_str());
+            return false;
+        }
+        printf("Merged %s.\n", in_file.c_str());
+    }
+
+    SysEnv.map_gen_iters = iters;
+    crawl_state.seed = seed;
+    return true;
+}
+
+static void _write_map_tables(writer &th)
+{
+    shard_write(th, try_count);
+    shard_write(th, use_count);
+    shard_write(th, success_count);
+    shard_write(th, level_mapcounts);
+    shard_write(th, map_builds);
+    shard_write(th, level_mapsused);
+    shard_write(th, map_levelsused);
+    shard_write(th, errors);
+    shard_write(th, levels_tried);
+    shard_write(th, levels_failed);
+    shard_write(th, build_attempts);
+    shard_write(th, level_vetoes);
+    shard_write(th, veto_messages);
+}
+
+static void _merge_map_tables(reader &th)
+{
+    shard_merge(th, try_count);
+    shard_merge(th, use_count);
+    shard_merge(th, success_count);
+    shard_merge(th, level_mapcounts);
+    shard_merge(th, map_builds);
+    shard_merge(th, level_mapsused);
+    shard_merge(th, map_levelsused);
+    shard_merge(th, errors);
+    shard_merge(th, levels_tried);
+    shard_merge(th, levels_failed);
+    shard_merge(th, build_attempts);
+    shard_merge(th, level_vetoes);
+    shard_merge(th, veto_messages);
+}
+
 void mapstat_generate_stats()
 {
     // Warn assertions about possible oddities like the artefact list being
@@ -515,14 +732,36 @@ void mapstat_generate_stats()
 
     _dungeon_places();
 
-    clear_messages();
-    mpr("Generating dungeon map stats");
-    printf("Generating map stats for %d iteration(s) of %d level(s) over "
-           "%d branch(es).\n", SysEnv.map_gen_iters,
-           (int) generated_levels.size(), branch_count);
-    fflush(stdout);
+    if (SysEnv.map_gen_merge)
+    {
+        if (!mapstat_merge_shards("mapstat", _merge_map_tables))
+            return;
+    }
+    else
+    {
+        if (!mapstat_choose_seed())
+            return;
+
+        clear_messages();
+        mpr("Generating dungeon map stats");
+        printf("Generating map stats for %d iteration(s) of %d level(s) over "
+               "%d branch(es).\n", SysEnv.map_gen_iters,
+               (int) generated_levels.size(), branch_count);
+        fflush(stdout);
 
-    mapstat_build_levels();
+        const bool built = mapstat_build_levels();
+
+        // A shard missing some of its iterations would throw off the
+        // merged stats.
+        if (SysEnv.map_gen_shards)
+        {
+            if (built)
+                mapstat_write_shard("mapstat", _write_map_tables);
+            else
+                printf("Not writing an incomplete shard.\n");
+            return;
+        }
+    }
 
     _write_map_stats();
     printf("Map stats complete.\n");
@@ -8,6 +8,8 @@
 #ifdef DEBUG_STATISTICS
 
 class map_def;
+class reader;
+class writer;
 void mapstat_report_map_try(const map_def &map);
 void mapstat_report_map_use(const map_def &map);
 void mapstat_report_map_success(const string &map_name);
@@ -17,4 +19,7 @@ void mapstat_report_map_veto(const string &message);
 void mapstat_generate_stats();
 bool mapstat_build_levels();
 bool mapstat_find_forced_map();
+bool mapstat_choose_seed();
+bool mapstat_write_shard(const char *kind, void (*write_stats)(writer &));
+bool mapstat_merge_shards(const char *kind, void (*merge_stats)(reader &));
 #endif
@@ -15,6 +15,7 @@
 #include "branch.h"
 #include "corpse.h"
 #include "dbg-maps.h"
+#include "dbg-shard.h"
 #include "dbg-util.h"
 #include "dungeon.h"
 #include "end.h"
@@ -1333,6 +1334,24 @@ static void _write_object_stats()
     printf("Wrote Feature stats to %s.\n", out_file.c_str());
 }
 
+static void _write_object_tables(writer &th)
+{
+    shard_write(th, item_recs);
+    shard_write(th, brand_recs);
+    shard_write(th, monster_recs);
+    shard_write(th, feature_recs);
+    shard_write(th, spell_recs);
+}
+
+static void _merge_object_tables(reader &th)
+{
+    shard_merge(th, item_recs);
+    shard_merge(th, brand_recs);
+    shard_merge(th, monster_recs);
+    shard_merge(th, feature_recs);
+    shard_merge(th, spell_recs);
+}
+
 void objstat_generate_stats()
 {
     // Warn assertions about possible oddities like the artefact list being
@@ -1392,20 +1411,37 @@ void objstat_generate_stats()
     if (num_branches > 1)
         stat_levels.insert(all_lev);
 
-    printf("Generating object statistics for %d iteration(s) of %d "
-           "level(s) over %d branch(es).\n", SysEnv.map_gen_iters,
-           num_levels, num_branches);
-
     _init_spells();
     _init_features();
     _init_monsters();
 
     _init_stats();
 
-    if (mapstat_build_levels())
+    if (SysEnv.map_gen_merge)
+    {
+        if (!mapstat_merge_shards("objstat", _merge_object_tables))
+            return;
+    }
+    else
     {
-        _write_object_stats();
-        printf("Object statistics complete.\n");
+        if (!mapstat_choose_seed())
+            return;
+
+        printf("Generating object statistics for %d iteration(s) of %d "
+               "level(s) over %d branch(es).\n", SysEnv.map_gen_iters,
+               num_levels, num_branches);
+
+        if (!mapstat_build_levels())
+            return;
+
+        if (SysEnv.map_gen_shards)
+        {
+            mapstat_write_shard("objstat", _write_object_tables);
+            return;
+        }
     }
+
+    _write_object_stats();
+    printf("Object statistics complete.\n");
 }
 #endif // DEBUG_STATISTICS
@@ -0,0 +1,155 @@
+/**
+ * @file
+ * @brief Reading and writing the stat tables of sharded mapstat and objstat
+ *        runs.
+**/
+
+#pragma once
+
+#ifdef DEBUG_STATISTICS
+
+#include <map>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "tags.h"
+
+// The stat tables are nested maps and sets keyed by ints, enums, strings and
+// level_ids. Merging a table from a shard file adds it to the one in memory:
+// counts are summed and sets joined, except that the NumMin and NumMax
+// fields of objstat keep the smallest and largest values.
+
+inline void shard_write(writer &th, int value)
+{
+    marshallInt(th, value);
+}
+
+inline void shard_write(writer &th, const string &str)
+{
+    marshallString(th, str);
+}
+
+inline void shard_write(writer &th, const level_id &lid)
+{
+    marshall_level_id(th, lid);
+}
+
+template<typename E,
+         typename = typename enable_if<is_enum<E>::value>::type>
+void shard_write(writer &th, E value)
+{
+    marshallInt(th, static_cast<int>(value));
+}
+
+template<typename A, typename B>
+void shard_write(writer &th, const pair<A, B> &entry)
+{
+    shard_write(th, entry.first);
+    shard_write(th, entry.second);
+}
+
+template<typename T>
+void shard_write(writer &th, const set<T> &elts)
+{
+    marshallInt(th, elts.size());
+    for (const T &elt : elts)
+        shard_write(th, elt);
+}
+
+template<typename K, typename V>
+void shard_write(writer &th, const map<K, V> &table)
+{
+    marshallInt(th, table.size());
+    for (const auto &entry : table)
+    {
+        shard_write(th, entry.first);
+        shard_write(th, entry.second);
+    }
+}
+
+inline void shard_read(reader &th, int &value)
+{
+    value = unmarshallInt(th);
+}
+
+inline void shard_read(reader &th, string &str)
+{
+    str = unmarshallString(th);
+}
+
+inline void shard_read(reader &th, level_id &lid)
+{
+    lid = unmarshall_level_id(th);
+}
+
+template<typename E,
+         typename = typename enable_if<is_enum<E>::value>::type>
+void shard_read(reader &th, E &value)
+{
+    value = static_cast<E>(unmarshallInt(th));
+}
+
+inline void shard_merge(reader &th, int &count)
+{
+    count += unmarshallInt(th);
+}
+
+inline void shard_merge(reader &th, string &str)
+{
+    str = unmarshallString(th);
+}
+
+// Objstat's per-field stats, and mapstat's per-map counts.
+inline void shard_merge(reader &th, map<string, int> &stats)
+{
+    const int size = unmarshallInt(th);
+    for (int i = 0; i < size; ++i)
+    {
+        const string field = unmarshallString(th);
+        const int value = unmarshallInt(th);
+        auto it = stats.find(field);
+        if (it == stats.end())
+            stats[field] = value;
+        else if (field == "NumMin")
+            it->second = min(it->second, value);
+        else if (field == "NumMax")
+            it->second = max(it->second, value);
+        else
+            it->second += value;
+    }
+}
+
+template<typename A, typename B>
+void shard_merge(reader &th, pair<A, B> &entry)
+{
+    shard_merge(th, entry.first);
+    shard_merge(th, entry.second);
+}
+
+template<typename T>
+void shard_merge(reader &th, set<T> &elts)
+{
+    const int size = unmarshallInt(th);
+    for (int i = 0; i < size; ++i)
+    {
+        T elt;
+        shard_read(th, elt);
+        elts.insert(elt);
+    }
+}
+
+template<typename K, typename V>
+void shard_merge(reader &th, map<K, V> &table)
+{
+    const int size = unmarshallInt(th);
+    for (int i = 0; i < size; ++i)
+    {
+        K key;
+        shard_read(th, key);
+        shard_merge(th, table[key]);
+    }
+}
+
+#endif
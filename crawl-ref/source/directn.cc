@@ -1625,7 +1625,7 @@ bool direction_chooser::pickup_item()
 {
     item_def *ii = nullptr;
     if (in_bounds(target()))
-        ii = env.map_knowledge(target()).item();
+        ii = env.map_knowledge(target()).mutable_item();
     if (!ii || !ii->is_valid(true))
     {
         mprf(MSGCH_EXAMINE_FILTER, "You can't see any item there.");
@@ -24,7 +24,6 @@
 #include "initfile.h"
 #include "invent.h"
 #include "item-prop.h"
-#include "los.h"
 #include "macro.h"
 #include "message.h"
 #include "misc.h"
@@ -35,6 +34,7 @@
 #include "stringutil.h"
 #include "tag-version.h"
 #include "tilepick.h"
+#include "turn-profiler.h"
 #include "view.h"
 #include "xom.h"
 #include "ui.h"
@@ -86,7 +86,6 @@ void cio_cleanup()
 // Clear some globally defined variables.
 static void _clear_globals_on_exit()
 {
-    clear_rays_on_exit();
     clear_zap_info_on_exit();
     destroy_abyss();
 }
@@ -173,6 +172,9 @@ NORETURN void end(int exit_code, bool print_error, const char *format, ...)
 #endif
 
         cio_cleanup();
+#ifdef TURN_PROFILER
+        turn_profiler_exit();
+#endif
         msg::deinitialise_mpr_streams();
         _clear_globals_on_exit();
         databaseSystemShutdown();
@@ -108,6 +108,11 @@ struct crawl_environment
     // Volatile level flags, not saved.
     uint32_t level_state;
 
+    // Cells whose terrain, clouds, monsters or items have changed since the
+    // view was last drawn; see view_mark_dirty().
+    map_bitmask map_dirty;
+    bool map_all_dirty;
+
     // Mapping mid->mindex until the transition is finished.
     map<mid_t, unsigned short> mid_cache;
 
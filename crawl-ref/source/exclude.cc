@@ -343,6 +343,8 @@ void update_exclusion_los(vector<coord_def> changed)
         _mark_excludes_non_updated(c);
 
     curr_excludes.update_excluded_points(true);
+    if (!curr_excludes.empty())
+        view_mark_all_dirty();
 }
 
 bool is_excluded(const coord_def &p, const exclude_set &exc)
@@ -389,6 +391,7 @@ static void _tile_exclude_gmap_update(const coord_def &p)
 
 static void _exclude_update()
 {
+    view_mark_all_dirty();
     set_level_exclusion_annotation(curr_excludes.get_exclusion_desc());
     travel_cache.update_excludes();
 }
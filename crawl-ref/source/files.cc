@@ -1939,6 +1939,8 @@ bool pregen_dungeon(const level_id &stopping_point)
     {
         // be sure that AK start doesn't interfere with the builder
         unwind_var<game_chapter> chapter(you.chapter, CHAPTER_ORB_HUNTING);
+        // compress each saved level while the next one is being built
+        deferred_compression defer(you.save);
 
         ui::progress_popup progress("Generating dungeon...\n\n", 35);
         progress.advance_progress();
@@ -3344,6 +3346,42 @@ bool is_existing_level(const level_id &level)
     return you.save && you.save->has_chunk(level.describe());
 }
 
+/**
+ * Load every level stored in a save file into env, one after the other,
+ * for benchmarking level loads. The current level is lost.
+ *
+ * @param filename     The save file to read levels from.
+ * @param use_mmap     Whether the save file may be memory mapped.
+ * @param[out] bytes   The compressed size of the levels that were read.
+ * @return             The number of levels read.
+ */
+int bench_load_levels(const string &filename, bool use_mmap, int64_t &bytes)
+{
+    package save(filename.c_str(), false);
+    save.set_mmap(use_mmap);
+
+    int levels = 0;
+    bytes = 0;
+    for (const string &name : save.list_chunks())
+    {
+        try
+        {
+            level_id::parse_level_id(name);
+        }
+        catch (const bad_level_id &err)
+        {
+            continue; // not a level
+        }
+
+        _generic_level_reset();
+        if (!_restore_tagged_chunk(&save, name, TAG_LEVEL, nullptr))
+            continue;
+        levels++;
+        bytes += save.get_chunk_compressed_length(name);
+    }
+    return levels;
+}
+
 void delete_level(const level_id &level)
 {
     travel_cache.erase_level_info(level);
@@ -108,6 +108,8 @@ bool save_exists(const string& filename);
 bool restore_game(const string& filename);
 
 bool is_existing_level(const level_id &level);
+int bench_load_levels(const string &filename, bool use_mmap,
+                      int64_t &bytes);
 
 class level_excursion
 {
@@ -69,6 +69,7 @@
 #include "tag-version.h"
 #include "throw.h"
 #include "travel.h"
+#include "turn-profiler.h"
 #include "unwind.h"
 #include "version.h"
 #include "viewchar.h"
@@ -936,6 +937,7 @@ const vector<GameOption*> game_options::build_options_list()
         new MultipleChoiceGameOption<string>(
             SIMPLE_NAME(tile_web_mobile_input_helper), "auto",
             {{"auto", "auto"}, {"true", "true"}, {"false", "false"}}),
+        new BoolGameOption(SIMPLE_NAME(tile_web_compact_map), false),
         new StringGameOption(SIMPLE_NAME(tile_font_crt_family), "monospace", true),
         new StringGameOption(SIMPLE_NAME(tile_font_msg_family), "monospace", true),
         new StringGameOption(SIMPLE_NAME(tile_font_stat_family), "monospace", true),
@@ -4585,11 +4587,16 @@ enum commandline_option_type
     CLO_OBJSTAT,
     CLO_ITERATIONS,
     CLO_FORCE_MAP,
+    CLO_SHARD,
+    CLO_MERGE_SHARDS,
     CLO_ARENA,
+    CLO_ARENA_BENCH,
+    CLO_PROFILE_TURNS,
     CLO_DUMP_MAPS,
     CLO_TEST,
     CLO_SCRIPT,
     CLO_BUILDDB,
+    CLO_BUILDDES,
     CLO_HELP,
     CLO_VERSION,
     CLO_SEED,
@@ -4635,6 +4642,7 @@ static set<commandline_option_type> clo_headless_ok = {
 // ok in all builds
     CLO_SCORES,
     CLO_BUILDDB,
+    CLO_BUILDDES,
     CLO_RESET_CACHE,
     CLO_HELP,
     CLO_VERSION,
@@ -4649,6 +4657,7 @@ static set<commandline_option_type> clo_headless_ok = {
     CLO_RC,
 #endif
     CLO_ARENA,
+    CLO_ARENA_BENCH,
     CLO_TEST,
     CLO_SCRIPT,
 #ifdef USE_TILE_WEB
@@ -4664,8 +4673,11 @@ static const char *cmd_ops[] =
 {
     "scores", "name", "species", "background", "dir", "rc", "rcdir", "tscores",
     "vscores", "scorefile", "morgue", "macro", "mapstat", "dump-disconnect",
-    "objstat", "iters", "force-map", "arena", "dump-maps", "test", "script",
-    "builddb", "help", "version", "seed", "pregen", "save-version", "sprint",
+    "objstat", "iters", "force-map", "shard", "merge-shards", "arena",
+    "arena-bench",
+    "profile-turns", "dump-maps",
+    "test", "script", "builddb", "builddes", "help", "version", "seed",
+    "pregen", "save-version", "sprint",
     "extra-opt-first", "extra-opt-last", "sprint-map", "edit-save",
     "print-charset", "tutorial", "wizard", "explore", "no-save",
     "no-player-bones", "gdb", "no-gdb", "nogdb", "throttle", "no-throttle",
@@ -5342,6 +5354,7 @@ void game_options::write_webtiles_options(const string& name)
             tile_level_map_hide_sidebar);
     tiles.json_write_bool("tile_web_mouse_control", tile_web_mouse_control);
     tiles.json_write_string("tile_web_mobile_input_helper", tile_web_mobile_input_helper);
+    tiles.json_write_bool("tile_web_compact_map", tile_web_compact_map);
     tiles.json_write_bool("tile_menu_icons", tile_menu_icons);
 
     tiles.json_write_string("tile_font_crt_family",
@@ -5496,6 +5509,8 @@ bool parse_args(int argc, char **argv, bool rc_only)
 
     SysEnv.rcdirs.clear();
     SysEnv.map_gen_iters = 0;
+    SysEnv.map_gen_shard = SysEnv.map_gen_shards = 0;
+    SysEnv.map_gen_merge = false;
 
     if (argc < 2)           // no args!
         return true;
@@ -5690,6 +5705,39 @@ bool parse_args(int argc, char **argv, bool rc_only)
 #endif
             break;
 
+        case CLO_SHARD:
+#ifdef DEBUG_STATISTICS
+            if (!next_is_param
+                || sscanf(next_arg, "%d/%d", &SysEnv.map_gen_shard,
+                          &SysEnv.map_gen_shards) != 2
+                || SysEnv.map_gen_shards < 1
+                || SysEnv.map_gen_shard < 1
+                || SysEnv.map_gen_shard > SysEnv.map_gen_shards)
+            {
+                end(1, false, "Argument of the form k/N, with k from 1 to N, "
+                              "required for -%s\n", arg);
+            }
+            SysEnv.map_gen_merge = false;
+            nextUsed = true;
+#else
+            end(1, false, "%s", dbg_stat_err);
+#endif
+            break;
+
+        case CLO_MERGE_SHARDS:
+#ifdef DEBUG_STATISTICS
+            if (!next_is_param || !isadigit(*next_arg) || atoi(next_arg) < 1)
+                end(1, false, "Positive integer argument required for -%s\n",
+                    arg);
+            SysEnv.map_gen_shard = 0;
+            SysEnv.map_gen_shards = atoi(next_arg);
+            SysEnv.map_gen_merge = true;
+            nextUsed = true;
+#else
+            end(1, false, "%s", dbg_stat_err);
+#endif
+            break;
+
         case CLO_ARENA:
             if (!rc_only)
             {
@@ -5704,6 +5752,32 @@ bool parse_args(int argc, char **argv, bool rc_only)
             }
             break;
 
+        case CLO_ARENA_BENCH:
+            if (!next_is_param || !isadigit(*next_arg))
+                end(1, false, "Integer argument required for -%s\n", arg);
+            if (!rc_only)
+            {
+                Options.game.type = GAME_TYPE_ARENA;
+                Options.restart_after_game = false;
+                crawl_state.arena_bench = max(1, atoi(next_arg));
+                enter_headless_mode();
+            }
+            nextUsed = true;
+            break;
+
+        case CLO_PROFILE_TURNS:
+            if (!next_is_param)
+                return false;
+            if (!turn_profiler_available())
+            {
+                end(1, false, "-%s needs a build with TURN_PROFILER=y\n",
+                    arg);
+            }
+            if (!rc_only)
+                turn_profiler_start(next_arg);
+            nextUsed = true;
+            break;
+
         case CLO_DUMP_MAPS:
             crawl_state.dump_maps = true;
             break;
@@ -5773,6 +5847,19 @@ bool parse_args(int argc, char **argv, bool rc_only)
             enter_headless_mode();
             break;
 
+        case CLO_BUILDDES:
+            if (next_is_param)
+            {
+                if (!isadigit(*next_arg))
+                    end(1, false, "Integer argument required for -%s\n", arg);
+                crawl_state.build_des_jobs = atoi(next_arg);
+                nextUsed = true;
+            }
+            crawl_state.build_db = true;
+            crawl_state.build_des = true;
+            enter_headless_mode();
+            break;
+
         case CLO_RESET_CACHE:
             if (next_is_param)
                 return false;
@@ -62,6 +62,9 @@ public:
 
     int map_gen_iters;
     unique_ptr<depth_ranges> map_gen_range;
+    int map_gen_shard;             // For -shard k/N, k (from 1) and N;
+    int map_gen_shards;            // no shards if N is 0.
+    bool map_gen_merge;            // -merge-shards N: merge the N shards.
 
     vector<string> extra_opts_first;
     vector<string> extra_opts_last;
@@ -58,6 +58,7 @@
 #include "options.h"
 #include "orb.h"
 #include "output.h"
+#include "pattern.h"
 #include "place.h"
 #include "player-equip.h"
 #include "player.h"
@@ -541,6 +542,7 @@ void unlink_item(int dest)
         {
             // link env.igrid to the second item
             env.igrid(env.item[dest].pos) = env.item[dest].link;
+            view_mark_dirty(env.item[dest].pos);
 
             env.item[dest].pos.reset();
             env.item[dest].link = NON_ITEM;
@@ -679,6 +681,7 @@ void lose_item_stack(const coord_def& where)
         }
     }
     env.igrid(where) = NON_ITEM;
+    view_mark_dirty(where);
 }
 
 /**
@@ -2430,6 +2433,7 @@ bool move_item_to_grid(int *const obj, const coord_def& p, bool silent)
         item.link = env.igrid(p);
         env.igrid(p) = ob;
     }
+    view_mark_dirty(p);
 
     if (item_is_orb(item))
         env.orb_pos = p;
@@ -2469,6 +2473,8 @@ void move_item_stack_to_grid(const coord_def& from, const coord_def& to)
 
     env.igrid(to) = env.igrid(from);
     env.igrid(from) = NON_ITEM;
+    view_mark_dirty(from);
+    view_mark_dirty(to);
 }
 
 // Returns the mitm index of the item. If the item was copied but destroyed,
@@ -2994,9 +3000,15 @@ static bool _is_option_autopickup(const item_def &item, bool ignore_force)
         return bool(res);
 
     // Check for initial settings
-    for (const pair<text_pattern, bool>& option : Options.force_autopickup)
-        if (option.first.matches(iname))
-            return option.second;
+    static pattern_set autopickup_patterns;
+    autopickup_patterns.update(Options.force_autopickup,
+        [](const pair<text_pattern, bool> &option) -> const text_pattern &
+        {
+            return option.first;
+        });
+    const int option = autopickup_patterns.first_match(iname);
+    if (option >= 0)
+        return Options.force_autopickup[option].second;
 
     return Options.autopickups[item.base_type];
 }
@@ -4582,6 +4594,8 @@ void move_items(const coord_def r, const coord_def p)
     // Move entire stack over to p.
     env.igrid(p) = env.igrid(r);
     env.igrid(r) = NON_ITEM;
+    view_mark_dirty(p);
+    view_mark_dirty(r);
 }
 
 int runes_in_pack()
@@ -15,18 +15,23 @@
 #include "files.h"
 #include "god-wrath.h"
 #include "los.h"
+#include "map-cell.h"
 #include "maps.h"
 #include "message.h"
 #include "mon-act.h"
 #include "mon-cast.h"
 #include "mon-death.h"
+#include "mon-pathfind.h"
 #include "mon-poly.h"
 #include "ng-setup.h"
+#include "pattern.h"
 #include "religion.h"
 #include "stairs.h"
 #include "state.h"
 #include "stringutil.h"
+#include "tiles-build-specific.h"
 #include "tileview.h"
+#include "travel.h"
 #include "unique-creature-list-type.h"
 #include "unwind.h"
 #include "view.h"
@@ -354,6 +359,206 @@ LUAFN(debug_viewwindow)
 
 LUAWRAP(debug_seen_monsters_react, seen_monsters_react())
 
+#ifdef USE_TILE_WEB
+LUAWRAP(debug_webtiles_record_map, tiles.record_map_frame())
+LUAWRAP(debug_webtiles_clear_map, tiles.clear_map_frames())
+
+// Usage: messages, bytes, deflated, usecs = webtiles_bench_map(compact)
+// Encodes the frames recorded so far as webtiles map messages.
+LUAFN(debug_webtiles_bench_map)
+{
+    const auto result = tiles.bench_map_frames(lua_toboolean(ls, 1));
+    lua_pushnumber(ls, result.messages);
+    lua_pushnumber(ls, result.bytes);
+    lua_pushnumber(ls, result.deflated_bytes);
+    lua_pushnumber(ls, result.usecs);
+    return 4;
+}
+#endif
+
+// Usage: levels, bytes = load_save_levels(filename, use_mmap)
+// Loads every level from another save file in turn, for benchmarking.
+LUAFN(debug_load_save_levels)
+{
+    const string filename = luaL_checkstring(ls, 1);
+    if (!file_exists(filename))
+        luaL_error(ls, "No such save file: %s", filename.c_str());
+
+    int64_t bytes;
+    const int levels = bench_load_levels(filename, lua_toboolean(ls, 2),
+                                         bytes);
+    lua_pushnumber(ls, levels);
+    lua_pushnumber(ls, bytes);
+    return 2;
+}
+
+static void _push_pool_stats(lua_State *ls, const char *name,
+                             const payload_pool_stats &stats)
+{
+    lua_newtable(ls);
+    lua_pushnumber(ls, stats.created);
+    lua_setfield(ls, -2, "created");
+    lua_pushnumber(ls, stats.shared);
+    lua_setfield(ls, -2, "shared");
+    lua_pushnumber(ls, stats.unshared);
+    lua_setfield(ls, -2, "unshared");
+    lua_pushnumber(ls, stats.live);
+    lua_setfield(ls, -2, "live");
+    lua_pushnumber(ls, stats.slabs);
+    lua_setfield(ls, -2, "slabs");
+    lua_setfield(ls, -2, name);
+}
+
+// Usage: stats = map_cell_pools()
+// Counters for the pooled monsters, items and clouds of map_cells, as
+// stats.monster.created etc.
+LUAFN(debug_map_cell_pools)
+{
+    lua_newtable(ls);
+    _push_pool_stats(ls, "monster",
+                     payload_pool<monster_info>::get().stats);
+    _push_pool_stats(ls, "item", payload_pool<item_def>::get().stats);
+    _push_pool_stats(ls, "cloud", payload_pool<cloud_info>::get().stats);
+    return 1;
+}
+
+// Usage: incremental_view(bool)
+// Whether the view may reuse the cells that haven't changed since it was
+// last drawn. For benchmarking.
+LUAFN(debug_incremental_view)
+{
+    set_incremental_view(lua_toboolean(ls, 1));
+    return 0;
+}
+
+// Usage: drawn, reused = redraw_stats()
+// How many view cells have been drawn, and how many reused from the last
+// view.
+LUAFN(debug_redraw_stats)
+{
+    uint64_t drawn, reused;
+    view_redraw_stats(drawn, reused);
+    lua_pushnumber(ls, drawn);
+    lua_pushnumber(ls, reused);
+    return 2;
+}
+
+// Usage: share_paths(bool)
+// Whether monsters heading to the same place may share pathfinding. For
+// benchmarking.
+LUAFN(debug_share_paths)
+{
+    set_shared_pathfinding(lua_toboolean(ls, 1));
+    return 0;
+}
+
+// Usage: found, tried = path_monsters()
+// Finds a path to the player for every monster that can move, as
+// try_pathfind() would on a new turn. For benchmarking.
+LUAFN(debug_path_monsters)
+{
+    forget_shared_paths();
+    int found = 0, tried = 0;
+    for (monster_iterator mi; mi; ++mi)
+    {
+        if (mi->is_stationary())
+            continue;
+        const int range = mi->friendly() ? 1000 : mons_tracking_range(*mi);
+        if (!mons_find_waypoints(*mi, you.pos(), range).empty())
+            found++;
+        tried++;
+    }
+    lua_pushnumber(ls, found);
+    lua_pushnumber(ls, tried);
+    return 2;
+}
+
+// Usage: bitboard_travel(bool)
+// Whether stair distances are filled a row of squares at a time. For
+// benchmarking.
+LUAFN(debug_bitboard_travel)
+{
+    set_bitboard_travel(lua_toboolean(ls, 1));
+    return 0;
+}
+
+// Usage: mismatches = check_travel_flood(x, y)
+// Fills travel distances from (x, y) a row at a time and a square at a
+// time, and counts the squares where they differ.
+LUAFN(debug_check_travel_flood)
+{
+    const coord_def start(luaL_checkint(ls, 1), luaL_checkint(ls, 2));
+    lua_pushnumber(ls, bitboard_travel_mismatches(start));
+    return 1;
+}
+
+// Usage: mismatches = check_layout_distances([place])
+// Counts the distances between the stairs of a level, by default the
+// current one, that differ when worked out from what interlevel travel
+// recorded of its layout rather than from the level itself. -1 if there is
+// no recorded layout.
+LUAFN(debug_check_layout_distances)
+{
+    try
+    {
+        const level_id lid = lua_isstring(ls, 1)
+            ? level_id::parse_level_id(lua_tostring(ls, 1))
+            : level_id::current();
+        lua_pushnumber(ls, layout_distance_mismatches(lid));
+        return 1;
+    }
+    catch (const bad_level_id &err)
+    {
+        luaL_error(ls, err.what());
+    }
+    return 0;
+}
+
+// Usage: update_level_info()
+// Updates what interlevel travel knows of the current level, including the
+// distances between its stairs.
+LUAFN(debug_update_level_info)
+{
+    UNUSED(ls);
+    travel_cache.get_level_info(level_id::current()).update();
+    return 0;
+}
+
+// Usage: incremental_explore(bool)
+// Whether explore floods only as far as the nearest unexplored square and
+// keeps its route between steps. For benchmarking.
+LUAFN(debug_incremental_explore)
+{
+    set_incremental_explore(lua_toboolean(ls, 1));
+    return 0;
+}
+
+// Usage: pattern_prefilter(bool)
+// Whether option pattern lists such as force_more_message only try the
+// patterns whose literal text is in a string, rather than every pattern. For
+// benchmarking.
+LUAFN(debug_pattern_prefilter)
+{
+    set_pattern_prefilter(lua_toboolean(ls, 1));
+    return 0;
+}
+
+// Usage: more, flash, colour = check_message(msg)
+// Checks a message against force_more_message, flash_screen_message and
+// message_colour without printing it. colour is the index of the
+// message_colour entry that applies, or -1.
+LUAFN(debug_check_message)
+{
+    bool more, flash;
+    int colour;
+    check_message_options(luaL_checkstring(ls, 1), MSGCH_PLAIN, more, flash,
+                          colour);
+    lua_pushboolean(ls, more);
+    lua_pushboolean(ls, flash);
+    lua_pushnumber(ls, colour);
+    return 3;
+}
+
 static const char* disablements[] =
 {
     "spawns",
@@ -494,6 +699,24 @@ const struct luaL_reg debug_dlib[] =
 { "check_uniques", debug_check_uniques },
 { "viewwindow", debug_viewwindow },
 { "seen_monsters_react", debug_seen_monsters_react },
+#ifdef USE_TILE_WEB
+{ "webtiles_record_map", debug_webtiles_record_map },
+{ "webtiles_clear_map", debug_webtiles_clear_map },
+{ "webtiles_bench_map", debug_webtiles_bench_map },
+#endif
+{ "load_save_levels", debug_load_save_levels },
+{ "map_cell_pools", debug_map_cell_pools },
+{ "incremental_view", debug_incremental_view },
+{ "redraw_stats", debug_redraw_stats },
+{ "share_paths", debug_share_paths },
+{ "path_monsters", debug_path_monsters },
+{ "bitboard_travel", debug_bitboard_travel },
+{ "check_travel_flood", debug_check_travel_flood },
+{ "update_level_info", debug_update_level_info },
+{ "check_layout_distances", debug_check_layout_distances },
+{ "incremental_explore", debug_incremental_explore },
+{ "pattern_prefilter", debug_pattern_prefilter },
+{ "check_message", debug_check_message },
 { "disable", debug_disable },
 { "cpp_assert", debug_cpp_assert },
 { "reset_rng", debug_reset_rng },
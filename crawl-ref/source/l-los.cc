@@ -57,11 +57,27 @@ LUAFN(los_cell_see_cell)
     PLUARET(number, cell_see_cell(p, q, LOS_DEFAULT));
 }
 
+// Recalculates LOS around a point, bypassing the LOS cache, and returns
+// the number of visible cells. Used by scripts/bench-los.lua.
+LUAFN(los_losight_count)
+{
+    COORDS(p, 1, 2);
+    los_grid sh;
+    losight(sh, p, opc_default);
+    int count = 0;
+    for (int x = -LOS_MAX_RANGE; x <= LOS_MAX_RANGE; ++x)
+        for (int y = -LOS_MAX_RANGE; y <= LOS_MAX_RANGE; ++y)
+            if (sh(coord_def(x, y)))
+                ++count;
+    PLUARET(number, count);
+}
+
 const struct luaL_reg los_dlib[] =
 {
     { "findray", los_find_ray },
     { "make_ray", los_make_ray },
     { "cell_see_cell", los_cell_see_cell },
+    { "losight_count", los_losight_count },
     { nullptr, nullptr }
 };
 
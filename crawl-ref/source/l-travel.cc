@@ -12,6 +12,7 @@
 #include "player.h"
 #include "terrain.h"
 #include "travel.h"
+#include "view.h"
 #include "map-knowledge.h"
 
 /*** Set an exclusion.
@@ -187,6 +188,7 @@ LUAFN(l_set_travel_trail)
     if (!in_known_map_bounds(p))
         return luaL_error(ls, "Coordinates out of bounds: (%d, %d)", s.x, s.y);
     env.travel_trail.push_back(p);
+    view_mark_dirty(p);
     return 0;
 }
 
@@ -918,9 +918,46 @@ void cprintf(const char *format, ...)
     }
 }
 
+// What puttext() last wrote to each cell of the screen, so that it can skip
+// the cells that haven't changed. Anything else written to the screen
+// forgets what was there.
+struct puttext_cell
+{
+    char32_t glyph;
+    COLOURS colour;
+};
+
+static const char32_t PUTTEXT_UNKNOWN = (char32_t)-1;
+static vector<puttext_cell> _puttext_shadow;
+static coord_def _puttext_size;
+static bool _in_puttext = false;
+
+static puttext_cell *_puttext_cell_at(int x, int y)
+{
+    if (x < 1 || y < 1 || x > _puttext_size.x || y > _puttext_size.y)
+        return nullptr;
+    return &_puttext_shadow[(y - 1) * _puttext_size.x + x - 1];
+}
+
+// Forget what puttext() wrote to width cells starting at (x, y).
+static void _puttext_forget(int x, int y, int width)
+{
+    for (int i = 0; i < width; ++i)
+        if (puttext_cell *cell = _puttext_cell_at(x + i, y))
+            cell->glyph = PUTTEXT_UNKNOWN;
+}
+
+static void _puttext_forget_all()
+{
+    for (puttext_cell &cell : _puttext_shadow)
+        cell.glyph = PUTTEXT_UNKNOWN;
+}
+
 void putwch(char32_t chr)
 {
     wchar_t c = chr; // ??
+    if (!_in_puttext)
+        _puttext_forget(wherex(), wherey(), max(1, wcwidth(chr)));
     if (_headless_mode)
     {
         // simulate cursor movement and wrapping
@@ -954,16 +991,61 @@ void putwch(char32_t chr)
 
 void puttext(int x1, int y1, const crawl_view_buffer &vbuf)
 {
+    const coord_def screen(get_number_of_cols(), get_number_of_lines());
+    if (screen != _puttext_size)
+    {
+        _puttext_size = screen;
+        _puttext_shadow.assign(screen.x * screen.y,
+                               { PUTTEXT_UNKNOWN, BLACK });
+    }
+
+    // Find where (x1, y1) is on the screen.
+    cgotoxy(x1, y1);
+    const int sx = wherex();
+    const int sy = wherey();
+
+#ifdef USE_TILE_WEB
+    // Webtiles has its own copy of the text, which can be cleared without
+    // us knowing.
+    const bool can_skip = false;
+#else
+    const bool can_skip = true;
+#endif
+
+    unwind_bool in_puttext(_in_puttext, true);
     const screen_cell_t *cell = vbuf;
     const coord_def size = vbuf.size();
     for (int y = 0; y < size.y; ++y)
     {
-        cgotoxy(x1, y1 + y);
-        for (int x = 0; x < size.x; ++x)
+        // Only move the cursor at the start of a run of changed cells.
+        bool in_run = false;
+        for (int x = 0; x < size.x; ++x, ++cell)
         {
+            puttext_cell *old = _puttext_cell_at(sx + x, sy + y);
+            const COLOURS colour = static_cast<COLOURS>(cell->colour);
+            // Wide glyphs cover the next cell, so always write those.
+            const bool wide = wcwidth(cell->glyph) > 1;
+            if (can_skip && old && !wide && old->glyph == cell->glyph
+                && old->colour == colour)
+            {
+                in_run = false;
+                continue;
+            }
+
+            if (!in_run)
+            {
+                gotoxy_sys(sx + x, sy + y);
+                in_run = true;
+            }
             // headless check handled in putwch, which this calls
             put_colour_ch(cell->colour, cell->glyph);
-            cell++;
+            if (old)
+            {
+                old->glyph = wide ? PUTTEXT_UNKNOWN : cell->glyph;
+                old->colour = colour;
+            }
+            if (wide)
+                _puttext_forget(sx + x + 1, sy + y, 1);
         }
     }
 }
@@ -990,6 +1072,7 @@ void update_screen()
 
 void clear_to_end_of_line()
 {
+    _puttext_forget(wherex(), wherey(), _puttext_size.x);
     if (!_headless_mode)
     {
         textcolour(LIGHTGREY);
@@ -1043,6 +1126,7 @@ suppress_dgl_clrscr::~suppress_dgl_clrscr()
 
 void clrscr_sys()
 {
+    _puttext_forget_all();
     if (_headless_mode)
     {
         headless_x = 1;
@@ -1667,6 +1751,7 @@ static void write_char_at(int y, int x, const cchar_t &ch)
 
     attr_set(attr, color_pair, nullptr);
     mvadd_wchnstr(y, x, &ch, 1);
+    _puttext_forget(x + 1, y + 1, 1);
 }
 
 static void init_pair_safe(short pair, short f, short b)
@@ -54,6 +54,7 @@
 #include "losglobal.h"
 #include "mon-act.h"
 #include "mpr.h"
+#include "raymask.h"
 
 // These determine what rays are cast in the precomputation,
 // and affect start-up time significantly.
@@ -76,7 +77,7 @@ static vector<coord_def> ray_coords;
 // words, blockrays(p)[i] is set iff an opaque cell p blocks
 // the cellray with index i.
 static vector<coord_def> cellray_ends;
-typedef FixedArray<bit_vector*, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> blockrays_t;
+typedef FixedArray<ray_mask, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> blockrays_t;
 static blockrays_t blockrays;
 
 // We also store the minimal cellrays by target position
@@ -87,9 +88,8 @@ static FixedArray<vector<cellray>, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> min_cellray
 
 // Temporary arrays used in losight() to track which rays
 // are blocked or have seen a smoke cloud.
-// Allocated when doing the precomputations.
-static bit_vector *dead_rays     = nullptr;
-static bit_vector *smoke_rays    = nullptr;
+static ray_mask dead_rays;
+static ray_mask smoke_rays;
 
 class quadrant_iterator : public rectangle_iterator
 {
@@ -101,14 +101,6 @@ public:
     }
 };
 
-void clear_rays_on_exit()
-{
-    delete dead_rays;
-    delete smoke_rays;
-    for (quadrant_iterator qi; qi; ++qi)
-        delete blockrays(*qi);
-}
-
 // LOS radius.
 int los_radius = LOS_DEFAULT_RANGE;
 
@@ -388,7 +380,7 @@ static void _create_blockrays()
     // Cellrays are numbered according to the index of their end
     // cell in ray_coords.
     const int n_cellrays = ray_coords.size();
-    blockrays_t all_blockrays;
+    FixedArray<bit_vector*, LOS_MAX_RANGE+1, LOS_MAX_RANGE+1> all_blockrays;
     for (quadrant_iterator qi; qi; ++qi)
         all_blockrays(*qi) = new bit_vector(n_cellrays);
 
@@ -409,6 +401,7 @@ static void _create_blockrays()
     // Determine minimal cellrays and store their indices in ray_coords.
     vector<int> min_indices = _find_minimal_cellrays();
     const int n_min_rays    = min_indices.size();
+    ASSERT(n_min_rays <= RAY_MASK_BITS);
     cellray_ends.resize(n_min_rays);
     for (int i = 0; i < n_min_rays; ++i)
         cellray_ends[i] = ray_coords[min_indices[i]];
@@ -416,11 +409,11 @@ static void _create_blockrays()
     // Compress blockrays accordingly.
     for (quadrant_iterator qi; qi; ++qi)
     {
-        blockrays(*qi) = new bit_vector(n_min_rays);
+        blockrays(*qi).reset();
         for (int i = 0; i < n_min_rays; ++i)
         {
-            blockrays(*qi)->set(i, all_blockrays(*qi)
-                                   ->get(min_indices[i]));
+            blockrays(*qi).set(i, all_blockrays(*qi)
+                                  ->get(min_indices[i]));
         }
     }
 
@@ -428,9 +421,6 @@ static void _create_blockrays()
     for (quadrant_iterator qi; qi; ++qi)
         delete all_blockrays(*qi);
 
-    dead_rays  = new bit_vector(n_min_rays);
-    smoke_rays = new bit_vector(n_min_rays);
-
     dprf("Cellrays: %d Fullrays: %u Minimal cellrays: %u",
           n_cellrays, (unsigned int)fullrays.size(), n_min_rays);
 }
@@ -736,8 +726,8 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
 {
     const unsigned int num_cellrays = cellray_ends.size();
 
-    dead_rays->reset();
-    smoke_rays->reset();
+    dead_rays.reset();
+    smoke_rays.reset();
 
     for (quadrant_iterator qi; qi; ++qi)
     {
@@ -749,12 +739,12 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
         {
         case OPC_OPAQUE:
             // Block the appropriate rays.
-            *dead_rays |= *blockrays(*qi);
+            dead_rays.merge(blockrays(*qi));
             break;
         case OPC_HALF:
             // Block rays which have already seen a cloud.
-            *dead_rays  |= (*smoke_rays & *blockrays(*qi));
-            *smoke_rays |= *blockrays(*qi);
+            dead_rays.merge_and(smoke_rays, blockrays(*qi));
+            smoke_rays.merge(blockrays(*qi));
             break;
         default:
             break;
@@ -762,19 +752,44 @@ static void _losight_quadrant(los_grid& sh, const los_param& dat, int sx, int sy
     }
 
     // Ray calculation done. Now work out which cells in this
-    // quadrant are visible.
-    for (unsigned int rayidx = 0; rayidx < num_cellrays; ++rayidx)
+    // quadrant are visible: the end cell of each live ray.
+    dead_rays.for_each_clear(num_cellrays, [&](unsigned int rayidx)
     {
-        // make the cells seen by this ray at this point visible
-        if (!dead_rays->get(rayidx))
+        const coord_def p = coord_def(sx * cellray_ends[rayidx].x,
+                                      sy * cellray_ends[rayidx].y);
+        if (dat.los_bounds(p))
+            sh(p) = true;
+    });
+}
+
+// The cells (as offsets in the first quadrant) whose opacity can affect
+// whether the cell at offset target is visible from the origin: exactly
+// those that block some minimal cellray ending at target.
+vector<coord_def> los_ray_blockers(const coord_def& target)
+{
+    ASSERT(target.x >= 0 && target.y >= 0);
+    ASSERT(target.x <= LOS_MAX_RANGE && target.y <= LOS_MAX_RANGE);
+
+    raycast();
+
+    vector<unsigned int> rays;
+    for (unsigned int rayidx = 0; rayidx < cellray_ends.size(); ++rayidx)
+        if (cellray_ends[rayidx] == target)
+            rays.push_back(rayidx);
+
+    vector<coord_def> blockers;
+    for (quadrant_iterator qi; qi; ++qi)
+    {
+        for (unsigned int rayidx : rays)
         {
-            // This ray is alive, thus the end cell is visible.
-            const coord_def p = coord_def(sx * cellray_ends[rayidx].x,
-                                          sy * cellray_ends[rayidx].y);
-            if (dat.los_bounds(p))
-                sh(p) = true;
+            if (blockrays(*qi).get(rayidx))
+            {
+                blockers.push_back(*qi);
+                break;
+            }
         }
     }
+    return blockers;
 }
 
 struct los_param_funcs : public los_param
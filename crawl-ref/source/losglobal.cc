@@ -5,6 +5,7 @@
 #include "coord.h"
 #include "coordit.h"
 #include "libutil.h"
+#include "los.h"
 #include "los-def.h"
 
 #define LOS_KNOWN 4
@@ -17,6 +18,14 @@ typedef halflos_t globallos_t[GXM][GYM];
 
 static globallos_t globallos;
 
+static los_cache_stats globallos_stats;
+
+// affected_pairs[e.x + LOS_MAX_RANGE][e.y + LOS_MAX_RANGE] lists the half
+// offsets d for which the entry (p, p + d) depends on the opacity of p + e.
+typedef vector<coord_def> offset_list;
+static offset_list affected_pairs[2*LOS_MAX_RANGE+1][2*LOS_MAX_RANGE+1];
+static bool affected_pairs_ready = false;
+
 static losfield_t* _lookup_globallos(const coord_def& p, const coord_def& q)
 {
     COMPILE_CHECK(LOS_KNOWN * 2 <= sizeof(losfield_t) * 8);
@@ -58,22 +67,90 @@ static void _save_los(los_def* los, los_type l)
         }
 }
 
-// Opacity at p has changed.
+// Add the offsets (relative to a LOS center) of all cells that can block
+// the view of the cell at offset target, in any quadrant containing it.
+static void _add_blockers(set<coord_def> &blockers, const coord_def& target)
+{
+    const coord_def quad(abs(target.x), abs(target.y));
+    const vector<coord_def> quad_blockers = los_ray_blockers(quad);
+    for (int sx = -1; sx <= 1; sx += 2)
+        for (int sy = -1; sy <= 1; sy += 2)
+        {
+            if (sx * target.x < 0 || sy * target.y < 0)
+                continue;
+            for (const coord_def &b : quad_blockers)
+                blockers.insert(coord_def(sx * b.x, sy * b.y));
+        }
+}
+
+static void _init_affected_pairs()
+{
+    if (affected_pairs_ready)
+        return;
+
+    for (int dx = 0; dx <= LOS_MAX_RANGE; ++dx)
+        for (int dy = -LOS_MAX_RANGE; dy <= LOS_MAX_RANGE; ++dy)
+        {
+            const coord_def d(dx, dy);
+            // Only the lower cell of a pair stores it; see _lookup_globallos.
+            if (d < coord_def(0, 0) || d.origin())
+                continue;
+
+            // The entry may have been filled from either end.
+            set<coord_def> from_p, from_q;
+            _add_blockers(from_p, d);
+            _add_blockers(from_q, -d);
+            for (const coord_def &b : from_q)
+                from_p.insert(d + b);
+
+            for (const coord_def &e : from_p)
+            {
+                ASSERT(e.rdist() <= LOS_MAX_RANGE);
+                affected_pairs[e.x + LOS_MAX_RANGE][e.y + LOS_MAX_RANGE]
+                    .push_back(d);
+            }
+        }
+
+    affected_pairs_ready = true;
+}
+
+// Opacity at p has changed. Forget only those pairs of cells that have
+// some cellray between them passing through p.
 void invalidate_los_around(const coord_def& p)
 {
-    int x1 = max(p.x - LOS_MAX_RANGE, 0);
-    int y1 = max(p.y - LOS_MAX_RANGE, 0);
-    int x2 = min(p.x, GXM - 1);
-    int y2 = min(p.y + LOS_MAX_RANGE, GYM - 1);
-    for (int y = y1; y <= y2; y++)
-        for (int x = x1; x <= x2; x++)
-            memset(globallos[x][y], 0, sizeof(halflos_t));
+    _init_affected_pairs();
+
+    for (int ex = -LOS_MAX_RANGE; ex <= LOS_MAX_RANGE; ++ex)
+        for (int ey = -LOS_MAX_RANGE; ey <= LOS_MAX_RANGE; ++ey)
+        {
+            const coord_def lower = p - coord_def(ex, ey);
+            if (!map_bounds(lower))
+                continue;
+
+            halflos_t &half = globallos[lower.x][lower.y];
+            for (const coord_def &d : affected_pairs[ex + LOS_MAX_RANGE]
+                                                    [ey + LOS_MAX_RANGE])
+            {
+                losfield_t &flags = half[d.x + o_half_x][d.y + o_half_y];
+                if (flags)
+                {
+                    flags = 0;
+                    globallos_stats.invalidated++;
+                }
+            }
+        }
 }
 
 void invalidate_los()
 {
     for (rectangle_iterator ri(0); ri; ++ri)
         memset(globallos[ri->x][ri->y], 0, sizeof(halflos_t));
+    globallos_stats.full_invalidations++;
+}
+
+const los_cache_stats &get_los_cache_stats()
+{
+    return globallos_stats;
 }
 
 static void _update_globallos_at(const coord_def& p, los_type l)
@@ -113,6 +190,35 @@ static void _update_globallos_at(const coord_def& p, los_type l)
     }
 }
 
+// Whether every pair (p, q) within range of p is known for l.
+static bool _known_from(const coord_def& p, los_type l)
+{
+    for (int x = -LOS_MAX_RANGE; x <= LOS_MAX_RANGE; ++x)
+        for (int y = -LOS_MAX_RANGE; y <= LOS_MAX_RANGE; ++y)
+        {
+            const losfield_t* flags = _lookup_globallos(p, p + coord_def(x, y));
+            if (flags && !(*flags & (l << LOS_KNOWN)))
+                return false;
+        }
+    return true;
+}
+
+// Compute LOS for l from each of centres at once, so that later queries
+// between any of them and anything in range are answered from the cache.
+// Entries invalidated after this are refilled on demand as usual.
+void fill_los_from(vector<coord_def> centres, los_type l)
+{
+    sort(centres.begin(), centres.end());
+    centres.erase(unique(centres.begin(), centres.end()), centres.end());
+    for (const coord_def &p : centres)
+    {
+        if (!in_bounds(p) || _known_from(p, l))
+            continue;
+        _update_globallos_at(p, l);
+        globallos_stats.prefilled++;
+    }
+}
+
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
 {
     if (l == LOS_NONE)
@@ -124,7 +230,12 @@ bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l)
         return false; // outside range
 
     if (!(*flags & (l << LOS_KNOWN)))
+    {
+        globallos_stats.misses++;
         _update_globallos_at(p, l);
+    }
+    else
+        globallos_stats.hits++;
 
     ASSERT(*flags & (l << LOS_KNOWN));
     return *flags & l;
@@ -2,7 +2,21 @@
 
 #include "los-type.h"
 
+struct los_cache_stats
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    // Entries cleared by invalidate_los_around.
+    uint64_t invalidated = 0;
+    // Calls to invalidate_los, which clears everything.
+    uint64_t full_invalidations = 0;
+    // LOS computed ahead of queries by fill_los_from.
+    uint64_t prefilled = 0;
+};
+
 void invalidate_los_around(const coord_def& p);
 void invalidate_los();
+const los_cache_stats &get_los_cache_stats();
+void fill_los_from(vector<coord_def> centres, los_type l);
 
 bool cell_see_cell(const coord_def& p, const coord_def& q, los_type l);
@@ -141,6 +141,7 @@
 #include "transform.h"
 #include "traps.h"
 #include "travel.h"
+#include "turn-profiler.h"
 #include "uncancel.h"
 #include "version.h"
 #include "viewchar.h"
@@ -558,6 +559,10 @@ static void _show_commandline_options_help()
     puts("");
     puts("Arena options: (Stage a tournament between various monsters.)");
     puts("  -arena \"<monster list> v <monster list> arena:<arena map>\"");
+    puts("  -arena-bench <num>  run <num> seeded fights headlessly and report timings");
+    puts("");
+    puts("  -profile-turns <file>  time each phase of every turn, and write a Chrome");
+    puts("                         trace to <file> on exit (TURN_PROFILER builds)");
 #ifdef DEBUG_DIAGNOSTICS
     puts("");
     puts("Diagnostic options:");
@@ -587,10 +592,19 @@ static void _show_commandline_options_help()
          "iterations");
     puts("  -force-map <map>    For -mapstat and -objstat, always choose the "
          "      given map on every level.");
+    puts("  -shard <k>/<N>      For -mapstat and -objstat, build only the kth "
+         "of every N");
+    puts("      iterations and write the stats to <mode>-<k>-of-<N>.shard; "
+         "needs -seed");
+    puts("  -merge-shards <N>   For -mapstat and -objstat, write the stats of "
+         "shards 1 to N");
+    puts("      of a run instead of building levels");
 #endif
     puts("");
     puts("Miscellaneous options:");
     puts("  -builddb         don't start the game; rebuild the .des cache and exit");
+    puts("  -builddes [<n>]  like -builddb, but compile .des files with <n> processes");
+    puts("                   (default: one per CPU) and report the time taken");
     puts("  -reset-cache     force a full rebuild of the .des cache");
     puts("  -dump-maps       write map Lua to stderr when parsing .des files");
 #ifndef TARGET_OS_WINDOWS
@@ -2563,12 +2577,17 @@ static void _update_still_winds()
 
 void world_reacts()
 {
+    TURN_PROFILE_ALWAYS("world_reacts");
+
     // All markers should be activated at this point.
     ASSERT(!env.markers.need_activate());
 
     you.rampage_hints.clear(); // only draw on your turn
 
-    fire_final_effects();
+    {
+        TURN_PROFILE("fire_final_effects");
+        fire_final_effects();
+    }
 
     if (crawl_state.viewport_monster_hp || crawl_state.viewport_weapons)
     {
@@ -2581,7 +2600,10 @@ void world_reacts()
     // prevent monsters wandering into view and picking up an item before
     // our next prep_input
     maybe_update_stashes();
-    update_monsters_in_view();
+    {
+        TURN_PROFILE("update_monsters_in_view");
+        update_monsters_in_view();
+    }
 
     reset_show_terrain();
 
@@ -2610,18 +2632,30 @@ void world_reacts()
     _check_trapped();
     check_spectral_weapon(you);
 
-    run_environment_effects();
+    {
+        TURN_PROFILE("run_environment_effects");
+        run_environment_effects();
+    }
 
     if (!crawl_state.game_is_arena())
+    {
+        TURN_PROFILE("player_reacts");
         player_reacts();
+    }
 
     abyss_morph();
-    apply_noises();
+    {
+        TURN_PROFILE("apply_noises");
+        apply_noises();
+    }
     handle_monsters(true);
 
     // Monsters can schedule final effects, too!
     // (mostly by exploding)
-    fire_final_effects();
+    {
+        TURN_PROFILE("fire_final_effects");
+        fire_final_effects();
+    }
 
     _check_banished();
 
@@ -2646,8 +2680,14 @@ void world_reacts()
         ouch(INSTANT_DEATH, KILLED_BY_QUITTING);
     }
 
-    handle_time();
-    manage_clouds();
+    {
+        TURN_PROFILE("handle_time");
+        handle_time();
+    }
+    {
+        TURN_PROFILE("manage_clouds");
+        manage_clouds();
+    }
     if (env.level_state & LSTATE_GOLUBRIA)
         _update_golubria_traps(you.time_taken);
     if (env.level_state & LSTATE_STILL_WINDS)
@@ -2659,8 +2699,11 @@ void world_reacts()
 
     add_auto_excludes();
 
-    viewwindow();
-    update_screen();
+    {
+        TURN_PROFILE("viewwindow");
+        viewwindow();
+        update_screen();
+    }
 
     if (you.cannot_act() && any_messages()
         && crawl_state.repeat_cmd != CMD_WIZARD)
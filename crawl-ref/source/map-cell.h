@@ -2,6 +2,7 @@
 
 #include "enum.h"
 #include "mon-info.h"
+#include "payload-pool.h"
 #include "tag-version.h"
 #include "trap-type.h"
 
@@ -63,59 +64,26 @@ struct cloud_info
 struct map_cell
 {
     map_cell() : flags(0), _feat(DNGN_UNSEEN), _feat_colour(0),
-                 _trap(TRAP_UNASSIGNED), _cloud(0), _item(0), _mons(0)
+                 _trap(TRAP_UNASSIGNED)
     {
     }
 
-    map_cell(const map_cell& c)
-    {
-        memcpy(this, &c, sizeof(map_cell));
-        if (_cloud)
-            _cloud = new cloud_info(*_cloud);
-        if (_mons)
-            _mons = new monster_info(*_mons);
-        if (_item)
-            _item = new item_def(*_item);
-    }
-
-    ~map_cell()
-    {
-        if (_cloud)
-            delete _cloud;
-        if (!(flags & MAP_DETECTED_MONSTER) && _mons)
-            delete _mons;
-        if (_item)
-            delete _item;
-    }
-
-    map_cell& operator=(const map_cell& c)
-    {
-        if (&c == this)
-            return *this;
-        if (_cloud)
-            delete _cloud;
-        if (_mons)
-            delete _mons;
-        if (_item)
-            delete _item;
-        memcpy(this, &c, sizeof(map_cell));
-        if (_cloud)
-            _cloud = new cloud_info(*_cloud);
-        if (_mons)
-            _mons = new monster_info(*_mons);
-        if (_item)
-            _item = new item_def(*_item);
-        return *this;
-    }
-
+    // Copies share the cloud, item and monster, so copying the knowledge
+    // grid doesn't allocate.
     bool operator ==(const map_cell &other) const
     {
-        return memcmp(this, &other, sizeof(map_cell)) == 0;
+        return flags == other.flags
+               && _feat == other._feat
+               && _feat_colour == other._feat_colour
+               && _trap == other._trap
+               && _cloud == other._cloud
+               && _item == other._item
+               && _mons == other._mons;
     }
 
     bool operator !=(const map_cell &other) const
     {
-        return memcmp(this, &other, sizeof(map_cell)) != 0;
+        return !(*this == other);
     }
 
     void clear()
@@ -153,9 +121,14 @@ struct map_cell
         _trap = tr;
     }
 
-    item_def* item() const
+    const item_def* item() const
     {
-        return _item;
+        return _item.get();
+    }
+
+    item_def* mutable_item()
+    {
+        return _item.get_mutable();
     }
 
     bool detected_item() const
@@ -173,7 +146,7 @@ struct map_cell
     void set_item(const item_def& ii, bool more_items)
     {
         clear_item();
-        _item = new item_def(ii);
+        _item = pooled_ptr<item_def>(ii);
         if (more_items)
             flags |= MAP_MORE_ITEMS;
     }
@@ -182,11 +155,7 @@ struct map_cell
 
     void clear_item()
     {
-        if (_item)
-        {
-            delete _item;
-            _item = 0;
-        }
+        _item.reset();
         flags &= ~(MAP_DETECTED_ITEM | MAP_MORE_ITEMS);
     }
 
@@ -198,15 +167,22 @@ struct map_cell
             return MONS_NO_MONSTER;
     }
 
-    monster_info* monsterinfo() const
+    const monster_info* monsterinfo() const
+    {
+        return _mons.get();
+    }
+
+    // Unshares the monster_info first, so that copies of this cell don't
+    // see the change.
+    monster_info* mutable_monsterinfo()
     {
-        return _mons;
+        return _mons.get_mutable();
     }
 
     void set_monster(const monster_info& mi)
     {
         clear_monster();
-        _mons = new monster_info(mi);
+        _mons = pooled_ptr<monster_info>(mi);
     }
 
     bool detected_monster() const
@@ -222,8 +198,9 @@ struct map_cell
     void set_detected_monster(monster_type mons)
     {
         clear_monster();
-        _mons = new monster_info(MONS_SENSED);
-        _mons->base_type = mons;
+        monster_info mi(MONS_SENSED);
+        mi.base_type = mons;
+        _mons = pooled_ptr<monster_info>(mi);
         flags |= MAP_DETECTED_MONSTER;
     }
 
@@ -235,10 +212,8 @@ struct map_cell
 
     void clear_monster()
     {
-        if (_mons)
-            delete _mons;
+        _mons.reset();
         flags &= ~(MAP_DETECTED_MONSTER | MAP_INVISIBLE_MONSTER);
-        _mons = 0;
     }
 
     cloud_type cloud() const
@@ -257,25 +232,24 @@ struct map_cell
             return 0;
     }
 
-    cloud_info* cloudinfo() const
+    const cloud_info* cloudinfo() const
+    {
+        return _cloud.get();
+    }
+
+    cloud_info* mutable_cloudinfo()
     {
-        return _cloud;
+        return _cloud.get_mutable();
     }
 
     void set_cloud(const cloud_info& ci)
     {
-        if (_cloud)
-            delete _cloud;
-        _cloud = new cloud_info(ci);
+        _cloud = pooled_ptr<cloud_info>(ci);
     }
 
     void clear_cloud()
     {
-        if (_cloud)
-        {
-            delete _cloud;
-            _cloud = 0;
-        }
+        _cloud.reset();
     }
 
     bool update_cloud_state();
@@ -316,7 +290,7 @@ private:
     dungeon_feature_type _feat:8;
     colour_t _feat_colour;
     trap_type _trap:8;
-    cloud_info* _cloud;
-    item_def* _item;
-    monster_info* _mons;
+    pooled_ptr<cloud_info> _cloud;
+    pooled_ptr<item_def> _item;
+    pooled_ptr<monster_info> _mons;
 };
@@ -167,9 +167,10 @@ void map_cell::set_detected_item()
 {
     clear_item();
     flags |= MAP_DETECTED_ITEM;
-    _item = new item_def();
-    _item->base_type = OBJ_DETECTED;
-    _item->rnd       = 1;
+    item_def item;
+    item.base_type = OBJ_DETECTED;
+    item.rnd       = 1;
+    _item = pooled_ptr<item_def>(item);
 }
 
 static bool _floor_mf(map_feature mf)
@@ -2183,6 +2183,16 @@ bool depth_ranges::is_usable_in(const level_id &lid) const
     return any_matched;
 }
 
+// Could any level in the branch satisfy is_usable_in? Ranges given by
+// absolute depth are not tied to a branch and so match every branch.
+bool depth_ranges::may_match_branch(branch_type br) const
+{
+    for (const level_range &lr : depths)
+        if (!lr.deny && (lr.branch == br || lr.branch == NUM_BRANCHES))
+            return true;
+    return false;
+}
+
 void depth_ranges::add_depths(const depth_ranges &other_depths)
 {
     depths.insert(depths.end(),
@@ -977,6 +977,7 @@ public:
     void clear() { depths.clear(); }
     bool empty() const { return depths.empty(); }
     bool is_usable_in(const level_id &lid) const;
+    bool may_match_branch(branch_type br) const;
     void add_depth(const level_range &range) { depths.push_back(range); }
     void add_depths(const depth_ranges &other_ranges);
     string describe() const;
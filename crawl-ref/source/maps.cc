@@ -8,14 +8,20 @@
 #include "maps.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <sys/param.h>
+#include <sys/stat.h>
 #include <sys/types.h>
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
 #include <unistd.h>
 #endif
+#ifdef UNIX
+#include <sys/wait.h>
+#endif
 
+#include "bitary.h"
 #include "branch.h"
 #include "coord.h"
 #include "coordit.h"
@@ -68,6 +74,30 @@ point_vector map_anchor_points;
 
 static map_vector vdefs;
 
+// Index over vdefs, so that selecting a vault only has to run
+// map_selector::accept on maps that could possibly match. Every bit_vector
+// has one bit per entry in vdefs. The index is rebuilt on demand whenever
+// vdefs changes.
+struct map_index
+{
+    bool valid = false;
+    map<string, bit_vector> by_tag;
+    // Maps whose DEPTH: (resp. PLACE:) could allow some level in the branch.
+    vector<bit_vector> depth_by_branch;
+    vector<bit_vector> place_by_branch;
+    // Maps with no DEPTH: at all.
+    bit_vector no_depth;
+};
+
+static map_index vindex;
+
+#ifdef DEBUG_STATISTICS
+static int map_index_selections = 0;
+static int map_index_builds = 0;
+static long long map_index_accepts = 0;
+static long long map_index_total = 0;
+#endif
+
 // Parameter array that vault code can use.
 string_vector map_parameters;
 
@@ -761,6 +791,93 @@ vector<string> find_map_matches(const string &name)
     return matches;
 }
 
+static void _invalidate_map_index()
+{
+    vindex.valid = false;
+}
+
+static void _build_map_index()
+{
+    if (vindex.valid)
+        return;
+
+    const unsigned nmaps = vdefs.size();
+    vindex.by_tag.clear();
+    vindex.depth_by_branch.clear();
+    vindex.place_by_branch.clear();
+    vindex.depth_by_branch.reserve(NUM_BRANCHES);
+    vindex.place_by_branch.reserve(NUM_BRANCHES);
+    for (int i = 0; i < NUM_BRANCHES; ++i)
+    {
+        vindex.depth_by_branch.emplace_back(nmaps);
+        vindex.place_by_branch.emplace_back(nmaps);
+    }
+    vindex.no_depth = bit_vector(nmaps);
+
+    for (unsigned i = 0; i < nmaps; ++i)
+    {
+        const map_def &mapdef = vdefs[i];
+        for (const string &tag : mapdef.get_tags_unsorted())
+        {
+            auto entry = vindex.by_tag.find(tag);
+            if (entry == vindex.by_tag.end())
+                entry = vindex.by_tag.emplace(tag, bit_vector(nmaps)).first;
+            entry->second.set(i);
+        }
+
+        if (!mapdef.has_depth())
+            vindex.no_depth.set(i);
+
+        for (int br = 0; br < NUM_BRANCHES; ++br)
+        {
+            if (mapdef.depths.may_match_branch(static_cast<branch_type>(br)))
+                vindex.depth_by_branch[br].set(i);
+            if (mapdef.place.may_match_branch(static_cast<branch_type>(br)))
+                vindex.place_by_branch[br].set(i);
+        }
+    }
+
+    vindex.valid = true;
+#ifdef DEBUG_STATISTICS
+    ++map_index_builds;
+#endif
+}
+
+// Restricts candidates to maps with every tag in tag_set. As with
+// map_def::has_all_tags, an empty tag set matches nothing.
+static void _index_filter_tags(bit_vector &candidates,
+                               const unordered_set<string> &tag_set)
+{
+    if (tag_set.empty())
+    {
+        candidates.reset();
+        return;
+    }
+
+    for (const string &tag : tag_set)
+    {
+        auto entry = vindex.by_tag.find(tag);
+        if (entry == vindex.by_tag.end())
+        {
+            candidates.reset();
+            return;
+        }
+        candidates &= entry->second;
+    }
+}
+
+// Restricts candidates to maps that have no DEPTH:, or whose DEPTH: may
+// allow some level in the given branch.
+static void _index_filter_depth(bit_vector &candidates, const level_id &place)
+{
+    if (!place.is_valid())
+        return;
+
+    bit_vector usable(vindex.no_depth);
+    usable |= vindex.depth_by_branch[place.branch];
+    candidates &= usable;
+}
+
 mapref_vector find_maps_for_tag(const string &tag,
                                 bool check_depth,
                                 bool check_used)
@@ -769,8 +886,17 @@ mapref_vector find_maps_for_tag(const string &tag,
     level_id place = level_id::current();
     unordered_set<string> tag_set = parse_tags(tag);
 
-    for (const map_def &mapdef : vdefs)
+    _build_map_index();
+    bit_vector candidates(vdefs.size());
+    candidates.init(true);
+    _index_filter_tags(candidates, tag_set);
+
+    for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
     {
+        if (!candidates.get(i))
+            continue;
+
+        const map_def &mapdef = vdefs[i];
         if (mapdef.has_all_tags(tag_set.begin(), tag_set.end())
             && !mapdef.has_tag("dummy")
             && (!check_depth || _debug_ignore_depth
@@ -797,6 +923,7 @@ private:
 
 public:
     bool accept(const map_def &md) const;
+    void filter_candidates(bit_vector &candidates) const;
     void announce(const map_def *map) const;
 
     bool valid() const
@@ -952,6 +1079,32 @@ bool map_selector::accept(const map_def &mapdef) const
     }
 }
 
+// Narrows candidates to the maps that accept() could possibly allow, using
+// the tag and branch index. accept() must still be checked for each one.
+void map_selector::filter_candidates(bit_vector &candidates) const
+{
+    switch (sel)
+    {
+    case PLACE:
+        candidates &= vindex.place_by_branch[place.branch];
+        break;
+
+    case DEPTH:
+    case DEPTH_AND_CHANCE:
+        candidates &= vindex.depth_by_branch[place.branch];
+        break;
+
+    case TAG:
+        _index_filter_tags(candidates, parse_tags(tag));
+        if (check_depth && !_debug_ignore_depth)
+            _index_filter_depth(candidates, place);
+        break;
+
+    default:
+        break;
+    }
+}
+
 void map_selector::announce(const map_def *vault) const
 {
 #ifdef DEBUG_DIAGNOSTICS
@@ -1000,9 +1153,26 @@ static vault_indices _eligible_maps_for_selector(const map_selector &sel)
 
     if (sel.valid())
     {
+        _build_map_index();
+        bit_vector candidates(vdefs.size());
+        candidates.init(true);
+        sel.filter_candidates(candidates);
+
+        // Keep vdefs order, so that the weighted rolls are unaffected.
         for (unsigned i = 0, size = vdefs.size(); i < size; ++i)
+        {
+            if (!candidates.get(i))
+                continue;
+#ifdef DEBUG_STATISTICS
+            ++map_index_accepts;
+#endif
             if (sel.accept(vdefs[i]))
                 eligible.push_back(i);
+        }
+#ifdef DEBUG_STATISTICS
+        ++map_index_selections;
+        map_index_total += vdefs.size();
+#endif
     }
 
     return eligible;
@@ -1360,6 +1530,7 @@ static bool _load_map_index(const string& cache, const string &base,
 
     const int nmaps = unmarshallShort(inf);
     const int nexist = vdefs.size();
+    _invalidate_map_index();
     vdefs.resize(nexist + nmaps, map_def());
     for (int i = 0; i < nmaps; ++i)
     {
@@ -1388,10 +1559,7 @@ static bool _load_map_cache(const string &filename, const string &cachename)
     file_lock deslock(descache_base + ".lk", "rb", false);
 
     time_t mtime = file_modtime(filename);
-    string file_idx = descache_base + ".idx";
-    string file_dsc = descache_base + ".dsc";
 
-    // What's the point in checking these twice (here and in load_ma_index)?
     if (!_verify_map_index(descache_base, mtime)
         || !_verify_map_full(descache_base, mtime))
     {
@@ -1511,6 +1679,116 @@ static void _parse_maps(const string &s)
     _write_map_cache(cache_name, file_start, vdefs.size(), mtime);
 }
 
+#ifdef UNIX
+// Whether the cache for a des file needs to be regenerated.
+static bool _des_cache_stale(const string &file)
+{
+    if (!crawl_state.use_des_cache)
+        return true;
+
+    const string base = get_descache_path(get_cache_name(file), "");
+    const time_t mtime = file_modtime(file);
+    return !_verify_map_index(base, mtime) || !_verify_map_full(base, mtime);
+}
+
+static off_t _des_file_size(const string &file)
+{
+    struct stat st;
+    return stat(file.c_str(), &st) ? 0 : st.st_size;
+}
+#endif
+
+/**
+ * Regenerate the caches of any out-of-date des files using several worker
+ * processes, so that read_maps() then only has to load the caches. The
+ * level compiler keeps all its state in globals, so each worker is a
+ * fork()ed copy of this process that compiles its share of the files and
+ * exits.
+ *
+ * @param jobs  The number of workers to use; 0 for one per CPU.
+ * @return      Whether all caches were successfully regenerated. If not,
+ *              read_maps() compiles whatever is left as usual.
+ */
+static bool _precompile_des_files(int jobs)
+{
+#ifdef UNIX
+    const string desdir = datafile_path("dat/des", false, false, dir_exists);
+    if (desdir.empty())
+        return false;
+
+    vector<pair<off_t, string>> stale;
+    int total = 0;
+    for (const string &file : get_dir_files_recursive(desdir, ".des"))
+    {
+        // The same path that read_map() will use for it.
+        const string path = datafile_path("des/" + file);
+        total++;
+        if (_des_cache_stale(path))
+            stale.emplace_back(_des_file_size(path), path);
+    }
+
+    if (jobs <= 0)
+        jobs = max(1L, sysconf(_SC_NPROCESSORS_ONLN));
+    jobs = min<int>(jobs, stale.size());
+
+    // Deal out the biggest files first, each to the least loaded worker.
+    sort(stale.begin(), stale.end(), greater<pair<off_t, string>>());
+    vector<vector<string>> shares(jobs);
+    vector<off_t> load(jobs, 0);
+    for (const auto &entry : stale)
+    {
+        const int w = min_element(load.begin(), load.end()) - load.begin();
+        shares[w].push_back(entry.second);
+        load[w] += entry.first;
+    }
+
+    _check_des_index_dir();
+    fflush(stdout);
+    fflush(stderr);
+
+    vector<pid_t> workers;
+    bool ok = true;
+    for (const vector<string> &share : shares)
+    {
+        const pid_t pid = fork();
+        if (pid == -1)
+        {
+            ok = false;
+            break;
+        }
+        if (!pid)
+        {
+            for (const string &file : share)
+                _parse_maps(lc_desfile = file);
+            // Skip the exit handlers, the parent still owns everything.
+            fflush(stdout);
+            _exit(0);
+        }
+        workers.push_back(pid);
+    }
+
+    for (pid_t pid : workers)
+    {
+        int status;
+        if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status)
+            || WEXITSTATUS(status))
+        {
+            ok = false;
+        }
+    }
+
+    printf("Compiled %d of %d des files with %d worker%s.\n",
+           (int)stale.size(), total, jobs, jobs == 1 ? "" : "s");
+    if (!ok)
+        printf("Some des files failed to compile, retrying serially.\n");
+    return ok;
+#else
+    UNUSED(jobs);
+    printf("Parallel des compilation is not supported on this platform.\n");
+    return false;
+#endif
+}
+
 void read_map(const string &file)
 {
     _parse_maps(lc_desfile = datafile_path(file));
@@ -1521,9 +1799,27 @@ void read_map(const string &file)
 
 void read_maps()
 {
+    const auto start = chrono::steady_clock::now();
+    if (crawl_state.build_des)
+    {
+        // -reset-cache is done with, so don't compile everything again.
+        if (_precompile_des_files(crawl_state.build_des_jobs))
+            crawl_state.use_des_cache = true;
+        printf("Compiling took %.2fs.\n", chrono::duration<double>(
+                   chrono::steady_clock::now() - start).count());
+    }
+
+    const auto load_start = chrono::steady_clock::now();
     if (dlua.execfile("dlua/loadmaps.lua", true, true, true))
         end(1, false, "Lua error: %s", dlua.error.c_str());
 
+    if (crawl_state.build_des)
+    {
+        printf("Loading %d maps took %.2fs.\n", map_count(),
+               chrono::duration<double>(
+                   chrono::steady_clock::now() - load_start).count());
+    }
+
     lc_loaded_maps.clear();
 
     {
@@ -1547,6 +1843,7 @@ void reread_maps()
 
     // BOOM!
     vdefs.clear();
+    _invalidate_map_index();
     map_files_read.clear();
     read_maps();
 }
@@ -1566,6 +1863,7 @@ void add_parsed_map(const map_def &md)
 
     map.fixup();
     vdefs.push_back(map);
+    _invalidate_map_index();
 }
 
 void run_map_global_preludes()
@@ -1582,6 +1880,8 @@ void run_map_global_preludes()
 
 void run_map_local_preludes()
 {
+    // Preludes may change a map's tags.
+    _invalidate_map_index();
     for (map_def &vdef : vdefs)
     {
         if (!vdef.prelude.empty())
@@ -1673,6 +1973,17 @@ static void _report_random_vaults(
         fprintf(outf, "%s\n", line.c_str());
 }
 
+void mapstat_report_map_index(FILE *outf)
+{
+    fprintf(outf, "\n\nVault selection index:\n");
+    fprintf(outf, "Selections: %d, index builds: %d\n",
+            map_index_selections, map_index_builds);
+    fprintf(outf, "Maps checked: %lld of %lld (%.2f%%)\n",
+            map_index_accepts, map_index_total,
+            map_index_total ? map_index_accepts * 100.0 / map_index_total
+                            : 0.0);
+}
+
 void mapstat_report_random_maps(FILE *outf, const level_id &place)
 {
     fprintf(outf, "---------------- Mini\n");
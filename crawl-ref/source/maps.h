@@ -94,4 +94,5 @@ private:
 
 #ifdef DEBUG_STATISTICS
 void mapstat_report_random_maps(FILE *outf, const level_id &place);
+void mapstat_report_map_index(FILE *outf);
 #endif
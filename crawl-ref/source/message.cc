@@ -22,6 +22,7 @@
 #include "mon-util.h"
 #include "notes.h"
 #include "output.h"
+#include "pattern.h"
 #include "religion.h"
 #include "scroller.h"
 #include "sound.h"
@@ -1363,15 +1364,71 @@ void dprf(diag_type param, const char *format, ...)
 
 static bool _updating_view = false;
 
+// The patterns of the message options, each option's compiled as one set.
+static pattern_set _more_patterns;
+static pattern_set _flash_screen_patterns;
+static pattern_set _colour_patterns;
+static pattern_set _note_patterns;
+
+static const message_filter &_option_filter(const message_filter &filter)
+{
+    return filter;
+}
+
+static const message_filter &_option_filter(const message_colour_mapping &mcm)
+{
+    return mcm.message;
+}
+
+static bool _option_usable(const message_filter &/*filter*/)
+{
+    return true;
+}
+
+static bool _option_usable(const message_colour_mapping &mcm)
+{
+    return mcm.valid();
+}
+
+/**
+ * Find the first entry of a message option that matches a message.
+ *
+ * @param option   A list of message_filters, or of things containing one.
+ * @param patterns Kept holding the patterns of the option, so that they're
+ *                 matched together.
+ * @returns The index of the entry, or -1 if there's none.
+ */
+template<typename T>
+static int _first_option_match(const vector<T> &option, pattern_set &patterns,
+                               const string& line, msg_channel_type channel)
+{
+    patterns.update(option, [](const T &entry) -> const text_pattern &
+                            {
+                                return _option_filter(entry).pattern;
+                            });
+    auto wanted = [&](size_t i)
+    {
+        const message_filter &filter = _option_filter(option[i]);
+        return _option_usable(option[i])
+               && (filter.channel == channel || filter.channel == -1);
+    };
+    const int matched = patterns.first_match(line, wanted);
+
+    // Filters without a pattern match any message on their channel.
+    const size_t before = matched < 0 ? option.size() : matched;
+    for (size_t i = 0; i < before; ++i)
+        if (_option_filter(option[i]).pattern.empty() && wanted(i))
+            return i;
+    return matched;
+}
+
 static bool _check_option(const string& line, msg_channel_type channel,
-                          const vector<message_filter>& option)
+                          const vector<message_filter>& option,
+                          pattern_set &patterns)
 {
     if (crawl_state.generating_level)
         return false;
-    return any_of(begin(option),
-                  end(option),
-                  bind(mem_fn(&message_filter::is_filtered),
-                       placeholders::_1, channel, line));
+    return _first_option_match(option, patterns, line, channel) >= 0;
 }
 
 static bool _check_more(const string& line, msg_channel_type channel)
@@ -1381,7 +1438,8 @@ static bool _check_more(const string& line, msg_channel_type channel)
     // crash here in order to find the real bug?
     if (!you.on_current_level)
         return false;
-    return _check_option(line, channel, Options.force_more_message);
+    return _check_option(line, channel, Options.force_more_message,
+                         _more_patterns);
 }
 
 static bool _check_flash_screen(const string& line, msg_channel_type channel)
@@ -1391,7 +1449,24 @@ static bool _check_flash_screen(const string& line, msg_channel_type channel)
     // crash here in order to find the real bug?
     if (!you.on_current_level)
         return false;
-    return _check_option(line, channel, Options.flash_screen_message);
+    return _check_option(line, channel, Options.flash_screen_message,
+                         _flash_screen_patterns);
+}
+
+/**
+ * Check a message against force_more_message, flash_screen_message and
+ * message_colour, without printing it.
+ *
+ * @param[out] colour The index of the message_colour entry that applies, or
+ *                    -1 if there's none.
+ */
+void check_message_options(const string &line, msg_channel_type channel,
+                           bool &more, bool &flash, int &colour)
+{
+    more = _check_more(line, channel);
+    flash = _check_flash_screen(line, channel);
+    colour = _first_option_match(Options.message_colour_mappings,
+                                 _colour_patterns, line, channel);
 }
 
 static bool _check_join(const string& /*line*/, msg_channel_type channel)
@@ -1767,6 +1842,11 @@ void mpr_comma_separated_list(const string &prefix,
     _mpr(out, channel, param);
 }
 
+static const text_pattern &_note_pattern(const text_pattern &pat)
+{
+    return pat;
+}
+
 // Checks whether a given message contains patterns relevant for
 // notes, stop_running or sounds and handles these cases.
 static void mpr_check_patterns(const string& message,
@@ -1775,21 +1855,14 @@ static void mpr_check_patterns(const string& message,
 {
     if (crawl_state.generating_level)
         return;
-    for (const text_pattern &pat : Options.note_messages)
+    if (channel != MSGCH_EQUIPMENT && channel != MSGCH_FLOOR_ITEMS
+        && channel != MSGCH_MULTITURN_ACTION
+        && channel != MSGCH_EXAMINE && channel != MSGCH_EXAMINE_FILTER
+        && channel != MSGCH_TUTORIAL && channel != MSGCH_DGL_MESSAGE)
     {
-        if (channel == MSGCH_EQUIPMENT || channel == MSGCH_FLOOR_ITEMS
-            || channel == MSGCH_MULTITURN_ACTION
-            || channel == MSGCH_EXAMINE || channel == MSGCH_EXAMINE_FILTER
-            || channel == MSGCH_TUTORIAL || channel == MSGCH_DGL_MESSAGE)
-        {
-            continue;
-        }
-
-        if (pat.matches(message))
-        {
+        _note_patterns.update(Options.note_messages, _note_pattern);
+        if (_note_patterns.first_match(message) >= 0)
             take_note(Note(NOTE_MESSAGE, channel, param, message));
-            break;
-        }
     }
 
     if (channel != MSGCH_DIAGNOSTICS && channel != MSGCH_EQUIPMENT)
@@ -1835,14 +1908,11 @@ static msg_colour_type prepare_message(const string& imsg,
 
     if (!crawl_state.generating_level)
     {
-        for (const message_colour_mapping &mcm : Options.message_colour_mappings)
-        {
-            if (mcm.valid() && mcm.message.is_filtered(channel, imsg))
-            {
-                colour = mcm.colour;
-                break;
-            }
-        }
+        const int mapping = _first_option_match(Options.message_colour_mappings,
+                                                _colour_patterns, imsg,
+                                                channel);
+        if (mapping >= 0)
+            colour = Options.message_colour_mappings[mapping].colour;
     }
 
     return colour;
@@ -171,6 +171,8 @@ string get_last_messages(int mcount, bool full = false);
 bool recent_error_messages();
 
 int channel_to_colour(msg_channel_type channel, int param = 0);
+void check_message_options(const string &line, msg_channel_type channel,
+                           bool &more, bool &flash, int &colour);
 bool strip_channel_prefix(string &text, msg_channel_type &channel,
                           bool silence = false);
 
@@ -147,15 +147,15 @@ static bool _should_share_ench(enchant_type type)
 // leaving durations unchanged, I guess. -cao
 static void _split_ench_durations(monster* initial_slime, monster* split_off)
 {
-    for (const auto &entry : initial_slime->enchantments)
+    for (const mon_enchant &me : initial_slime->enchantments)
     {
-        if (_should_share_ench(entry.second.ench))
+        if (_should_share_ench(me.ench))
         {
-            split_off->add_ench(entry.second);
+            split_off->add_ench(me);
 
             // The newly split slime will also be vengeance marked, so we need
             // to increment the total number of monsters the player has to kill
-            if (entry.second.ench == ENCH_VENGEANCE_TARGET)
+            if (me.ench == ENCH_VENGEANCE_TARGET)
                 you.duration[DUR_BEOGH_SEEKING_VENGEANCE] += 1;
         }
     }
@@ -172,38 +172,36 @@ void merge_ench_durations(monster& initial, monster& merge_to, bool usehd)
 
     mon_enchant_list &from_ench = initial.enchantments;
 
-    for (auto &entry : from_ench)
+    for (mon_enchant &me : from_ench)
     {
-        if (!_should_share_ench(entry.second.ench))
+        if (!_should_share_ench(me.ench))
             continue;
 
         // Does the other creature have this enchantment as well?
-        const mon_enchant temp = merge_to.get_ench(entry.first);
+        const mon_enchant temp = merge_to.get_ench(me.ench);
         // If not, use duration 0 for their part of the average.
         const bool no_initial = temp.ench == ENCH_NONE;
         const int duration = no_initial ? 0 : temp.duration;
 
-        entry.second.duration = (entry.second.duration * initial_count
-                                 + duration * merge_to_count)/total_count;
+        me.duration = (me.duration * initial_count
+                       + duration * merge_to_count)/total_count;
 
-        if (!entry.second.duration)
-            entry.second.duration = 1;
+        if (!me.duration)
+            me.duration = 1;
 
         if (no_initial)
-            merge_to.add_ench(entry.second);
+            merge_to.add_ench(me);
         else
-            merge_to.update_ench(entry.second);
+            merge_to.update_ench(me);
     }
 
-    for (auto &entry : merge_to.enchantments)
+    for (mon_enchant &me : merge_to.enchantments)
     {
-        if (from_ench.find(entry.first) == from_ench.end()
-            && entry.second.duration > 1)
+        if (!from_ench.has(me.ench) && me.duration > 1)
         {
-            entry.second.duration = (merge_to_count * entry.second.duration)
-                                    / total_count;
+            me.duration = (merge_to_count * me.duration) / total_count;
 
-            merge_to.update_ench(entry.second);
+            merge_to.update_ench(me);
         }
     }
 }
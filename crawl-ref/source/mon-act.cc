@@ -68,6 +68,7 @@
 #include "throw.h"
 #include "timed-effects.h"
 #include "traps.h"
+#include "turn-profiler.h"
 #include "viewchar.h"
 #include "view.h"
 
@@ -2643,6 +2644,21 @@ static void _display_just_seen()
     mons_reset_just_seen();
 }
 
+// Most sight checks during monster moves are between actors, or from an
+// actor to somewhere near it, so work out what every actor can see before
+// anyone moves rather than piecemeal on the first query from each.
+static void _fill_actor_los()
+{
+    TURN_PROFILE("fill LOS");
+
+    vector<coord_def> centres;
+    centres.push_back(you.pos());
+    for (monster_iterator mi; mi; ++mi)
+        centres.push_back(mi->pos());
+    fill_los_from(centres, LOS_DEFAULT);
+    fill_los_from(centres, LOS_NO_TRANS);
+}
+
 /**
  * Get all monsters to make an action, if they can/want to.
  *
@@ -2650,6 +2666,10 @@ static void _display_just_seen()
  */
 void handle_monsters(bool with_noise)
 {
+    TURN_PROFILE_ALWAYS("handle_monsters");
+
+    _fill_actor_los();
+
     for (monster_iterator mi; mi; ++mi)
     {
         _pre_monster_move(**mi);
@@ -2683,6 +2703,7 @@ void handle_monsters(bool with_noise)
         // the queue just after this.
         if (oldspeed == mon->speed_increment)
         {
+            TURN_PROFILE_MONSTER(mon);
             handle_monster_move(mon);
             _post_monster_move(mon);
             fire_final_effects();
@@ -82,6 +82,7 @@
 #include "timed-effects.h"
 #include "traps.h"
 #include "travel.h"
+#include "turn-profiler.h"
 #include "unwind.h"
 #include "view.h"
 #include "viewchar.h"
@@ -6769,6 +6770,8 @@ static bool _mons_cast_hellfire_mortar(monster& caster, actor& foe, int pow, boo
 void mons_cast(monster* mons, bolt pbolt, spell_type spell_cast,
                mon_spell_slot_flags slot_flags, bool do_noise)
 {
+    TURN_PROFILE_SPELL(spell_cast);
+
     // check sputtercast state for e.g. orb spiders. assumption: all
     // sputtercasting monsters have one charge status and use it for all of
     // their spells.
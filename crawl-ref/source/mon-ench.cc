@@ -12,6 +12,7 @@
 
 #include "act-iter.h"
 #include "areas.h"
+#include "arena.h"
 #include "attitude-change.h"
 #include "bloodspatter.h"
 #include "cloud.h"
@@ -52,6 +53,7 @@
 #include "terrain.h"
 #include "timed-effects.h"
 #include "traps.h"
+#include "turn-profiler.h"
 #include "unwind.h"
 #include "view.h"
 
@@ -92,38 +94,6 @@ void update_mons_cloud_ring(monster* mons)
     }
 }
 
-#ifdef DEBUG_ENCH_CACHE_DIAGNOSTICS
-bool monster::has_ench(enchant_type ench) const
-{
-    mon_enchant e = get_ench(ench);
-    if (e.ench == ench)
-    {
-        if (!ench_cache[ench])
-        {
-            die("monster %s has ench '%s' not in cache",
-                name(DESC_PLAIN).c_str(),
-                string(e).c_str());
-        }
-    }
-    else if (e.ench == ENCH_NONE)
-    {
-        if (ench_cache[ench])
-        {
-            die("monster %s has no ench '%s' but cache says it does",
-                name(DESC_PLAIN).c_str(),
-                string(mon_enchant(ench)).c_str());
-        }
-    }
-    else
-    {
-        die("get_ench returned '%s' when asked for '%s'",
-            string(e).c_str(),
-            string(mon_enchant(ench)).c_str());
-    }
-    return ench_cache[ench];
-}
-#endif
-
 bool monster::has_ench(enchant_type ench, enchant_type ench2) const
 {
     if (ench2 == ENCH_NONE)
@@ -144,10 +114,9 @@ mon_enchant monster::get_ench(enchant_type ench1,
 
     for (int e = ench1; e <= ench2; ++e)
     {
-        auto i = enchantments.find(static_cast<enchant_type>(e));
-
-        if (i != enchantments.end())
-            return i->second;
+        const mon_enchant *me = enchantments.find(static_cast<enchant_type>(e));
+        if (me)
+            return *me;
     }
 
     return mon_enchant();
@@ -157,7 +126,7 @@ void monster::update_ench(const mon_enchant &ench)
 {
     if (ench.ench != ENCH_NONE)
     {
-        if (mon_enchant *curr_ench = map_find(enchantments, ench.ench))
+        if (mon_enchant *curr_ench = enchantments.find(ench.ench))
             *curr_ench = ench;
     }
 }
@@ -188,14 +157,13 @@ bool monster::add_ench(const mon_enchant &ench)
     }
 
     bool new_enchantment = false;
-    mon_enchant *added = map_find(enchantments, ench.ench);
+    mon_enchant *added = enchantments.find(ench.ench);
     if (added)
         *added += ench;
     else
     {
         new_enchantment = true;
-        added = &(enchantments[ench.ench] = ench);
-        ench_cache.set(ench.ench, true);
+        added = &enchantments.insert(ench);
     }
 
     // If the duration is not set, we must calculate it (depending on the
@@ -277,7 +245,6 @@ void monster::add_enchantment_effect(const mon_enchant &ench, bool quiet)
         {
             // temporarily change our attitude back (XXX: scary code...)
             unwind_var<mon_enchant_list> enchants(enchantments, mon_enchant_list{});
-            unwind_var<FixedBitVector<NUM_ENCHANTMENTS>> ecache(ench_cache, {});
             end_flayed_effect(this);
         }
         del_ench(ENCH_STILL_WINDS);
@@ -377,15 +344,13 @@ void monster::add_enchantment_effect(const mon_enchant &ench, bool quiet)
 
 bool monster::del_ench(enchant_type ench, bool quiet, bool effect)
 {
-    auto i = enchantments.find(ench);
-    if (i == enchantments.end())
+    const mon_enchant *found = enchantments.find(ench);
+    if (!found)
         return false;
 
-    const mon_enchant me = i->second;
-    const enchant_type et = i->first;
+    const mon_enchant me = *found;
 
-    enchantments.erase(et);
-    ench_cache.set(et, false);
+    enchantments.erase(ench);
     if (effect)
         remove_enchantment_effect(me, quiet);
     return true;
@@ -1051,7 +1016,7 @@ string monster::describe_enchantments() const
     {
         if (i != enchantments.begin())
             oss << ", ";
-        oss << string(i->second);
+        oss << string(*i);
     }
     return oss.str();
 }
@@ -1992,16 +1957,18 @@ void monster::apply_enchantments()
     if (enchantments.empty())
         return;
 
+    TURN_PROFILE_ALWAYS("enchantments");
+
     // We process an enchantment only if it existed both at the start of this
     // function and when getting to it in order; any enchantment can add, modify
     // or remove others -- or even itself.
-    FixedBitVector<NUM_ENCHANTMENTS> ec = ench_cache;
+    const mon_enchant_list ec = enchantments;
 
     // The ordering in enchant_type makes sure that "super-enchantments"
     // like berserk time out before their parts.
-    for (int i = 0; i < NUM_ENCHANTMENTS; ++i)
-        if (ec[i] && has_ench(static_cast<enchant_type>(i)))
-            apply_enchantment(enchantments.find(static_cast<enchant_type>(i))->second);
+    for (const mon_enchant &me : ec)
+        if (const mon_enchant *current = enchantments.find(me.ench))
+            apply_enchantment(*current);
 }
 
 // Used to adjust time durations in calc_duration() for monster speed.
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
 #include "enchant-type.h"
 #include "externs.h"
 #include "kill-category.h"
@@ -65,5 +70,188 @@ private:
     int calc_duration(const monster* mons, const mon_enchant *added) const;
 };
 
+// A monster's enchantments, at most one of each type. Each type has its
+// own slot, so finding one is an index rather than a tree walk, and
+// copying a list copies only the slots in use. Pointers to an enchantment
+// stay valid until that enchantment is erased. Iteration is in
+// enchant_type order.
+class mon_enchant_list
+{
+public:
+    class iterator
+    {
+    public:
+        iterator(mon_enchant_list *_list, int _i) : list(_list), i(_i) { }
+
+        mon_enchant &operator*() const { return list->slot(i); }
+        mon_enchant *operator->() const { return &list->slot(i); }
+        iterator &operator++()
+        {
+            i = list->next_type(i + 1);
+            return *this;
+        }
+        bool operator==(const iterator &other) const { return i == other.i; }
+        bool operator!=(const iterator &other) const { return i != other.i; }
+
+    private:
+        mon_enchant_list *list;
+        int i;
+    };
+
+    class const_iterator
+    {
+    public:
+        const_iterator(const mon_enchant_list *_list, int _i)
+            : list(_list), i(_i)
+        {
+        }
+
+        const mon_enchant &operator*() const { return list->slot(i); }
+        const mon_enchant *operator->() const { return &list->slot(i); }
+        const_iterator &operator++()
+        {
+            i = list->next_type(i + 1);
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const
+        {
+            return i == other.i;
+        }
+        bool operator!=(const const_iterator &other) const
+        {
+            return i != other.i;
+        }
+
+    private:
+        const mon_enchant_list *list;
+        int i;
+    };
+
+    mon_enchant_list() : types(), count(0) { }
+
+    mon_enchant_list(const mon_enchant_list &other) : types(), count(0)
+    {
+        *this = other;
+    }
+
+    mon_enchant_list &operator=(const mon_enchant_list &other)
+    {
+        if (&other == this)
+            return *this;
+        memcpy(types, other.types, sizeof(types));
+        count = other.count;
+        for (const mon_enchant &me : other)
+            new (&slots[me.ench]) mon_enchant(me);
+        return *this;
+    }
+
+    bool has(enchant_type ench) const
+    {
+        return types[ench / 64] & (uint64_t(1) << (ench % 64));
+    }
+
+    mon_enchant *find(enchant_type ench)
+    {
+        return has(ench) ? &slot(ench) : nullptr;
+    }
+
+    const mon_enchant *find(enchant_type ench) const
+    {
+        return has(ench) ? &slot(ench) : nullptr;
+    }
+
+    // Adds an enchantment, replacing any of the same type.
+    mon_enchant &insert(const mon_enchant &me)
+    {
+        ASSERT_RANGE(me.ench, ENCH_NONE + 1, NUM_ENCHANTMENTS);
+        if (!has(me.ench))
+        {
+            types[me.ench / 64] |= uint64_t(1) << (me.ench % 64);
+            count++;
+        }
+        return *new (&slots[me.ench]) mon_enchant(me);
+    }
+
+    bool erase(enchant_type ench)
+    {
+        if (!has(ench))
+            return false;
+        types[ench / 64] &= ~(uint64_t(1) << (ench % 64));
+        count--;
+        return true;
+    }
+
+    void clear()
+    {
+        memset(types, 0, sizeof(types));
+        count = 0;
+    }
+
+    bool empty() const { return !count; }
+    size_t size() const { return count; }
+
+    // Lists the types present in order into out, which must have room for
+    // NUM_ENCHANTMENTS, and returns how many there were. For loops that
+    // add or remove enchantments as they go, without copying the list.
+    int list_types(enchant_type *out) const
+    {
+        int n = 0;
+        for (int i = next_type(0); i < NUM_ENCHANTMENTS; i = next_type(i + 1))
+            out[n++] = static_cast<enchant_type>(i);
+        return n;
+    }
+
+    iterator begin() { return iterator(this, next_type(0)); }
+    iterator end() { return iterator(this, NUM_ENCHANTMENTS); }
+    const_iterator begin() const
+    {
+        return const_iterator(this, next_type(0));
+    }
+    const_iterator end() const
+    {
+        return const_iterator(this, NUM_ENCHANTMENTS);
+    }
+
+private:
+    static const int TYPE_WORDS = (NUM_ENCHANTMENTS + 63) / 64;
+
+    mon_enchant &slot(int ench)
+    {
+        return reinterpret_cast<mon_enchant &>(slots[ench]);
+    }
+
+    const mon_enchant &slot(int ench) const
+    {
+        return reinterpret_cast<const mon_enchant &>(slots[ench]);
+    }
+
+    // The first type at or after i that's present, or NUM_ENCHANTMENTS.
+    int next_type(int i) const
+    {
+        while (i < NUM_ENCHANTMENTS)
+        {
+            uint64_t word = types[i / 64] >> (i % 64);
+            if (!word)
+            {
+                i = (i / 64 + 1) * 64;
+                continue;
+            }
+            while (!(word & 1))
+            {
+                word >>= 1;
+                i++;
+            }
+            return i;
+        }
+        return NUM_ENCHANTMENTS;
+    }
+
+    uint64_t types[TYPE_WORDS];
+    size_t count;
+    // Only the slots of present types are constructed.
+    std::aligned_storage<sizeof(mon_enchant), alignof(mon_enchant)>::type
+        slots[NUM_ENCHANTMENTS];
+};
+
 enchant_type name_to_ench(const char *name);
 int summ_dur(int degree);
@@ -211,19 +211,14 @@ bool try_pathfind(monster* mon)
          mon->name(DESC_PLAIN).c_str(), mon->pos().x, mon->pos().y,
          targpos.x, targpos.y, range);
 #endif
-    monster_pathfind mp;
-    mp.set_range(range);
-
-    if (mp.init_pathfind(mon, targpos))
+    vector<coord_def> path = mons_find_waypoints(mon, targpos, range);
+    if (!path.empty())
     {
-        mon->travel_path = mp.calc_waypoints();
-        if (!mon->travel_path.empty())
-        {
-            // Okay then, we found a path. Let's use it!
-            mon->target = mon->travel_path[0];
-            mon->travel_target = MTRAV_FOE;
-            return true;
-        }
+        // Okay then, we found a path. Let's use it!
+        mon->travel_path = move(path);
+        mon->target = mon->travel_path[0];
+        mon->travel_target = MTRAV_FOE;
+        return true;
     }
 
     // We didn't find a path.
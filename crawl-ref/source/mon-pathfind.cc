@@ -2,12 +2,20 @@
 
 #include "mon-pathfind.h"
 
+#include <cstring>
+#include <memory>
+
+#include "coordit.h"
 #include "directn.h"
 #include "env.h"
+#include "god-abil.h"
+#include "level-id.h"
 #include "los.h"
+#include "losparam.h"
 #include "misc.h"
 #include "mon-movetarget.h"
 #include "mon-place.h"
+#include "mon-util.h"
 #include "religion.h"
 #include "state.h"
 #include "terrain.h"
@@ -60,6 +68,89 @@ int mons_tracking_range(const monster* mon)
     return range;
 }
 
+// The cost for mons to step onto npos.
+static int _mons_step_cost(const monster* mons, coord_def npos)
+{
+    // Doors need to be opened.
+    if (feat_is_closed_door(env.grid(npos)))
+        return 2;
+
+    // Travelling through water, entering or leaving water is more expensive
+    // for non-amphibious monsters, so they'll avoid it where possible.
+    // (The resulting path might not be optimal but it will lead to a path
+    // a monster of such habits is likely to prefer.)
+    if (mons->floundering_at(npos))
+        return 2;
+
+    // Try to avoid traps.
+    const trap_def* ptrap = trap_at(npos);
+    if (ptrap)
+    {
+        if (ptrap->is_bad_for_player())
+        {
+            // Your allies take extra precautions to avoid traps that are bad
+            // for you (elsewhere further checks are made to mark Zot traps as
+            // impassible).
+            if (mons->friendly())
+                return 3;
+
+            // To hostile monsters, these traps are completely harmless.
+            return 1;
+        }
+
+        return 2;
+    }
+
+    return 1;
+}
+
+// Reduces the path coordinates to only a couple of key waypoints needed
+// to reach the target. Waypoints are chosen such that from one waypoint you
+// can see (and, more importantly, reach) the next one. Note that
+// can_go_straight() is probably rather too conservative in these estimates.
+// This is done because Crawl's pathfinding - once a target is in sight and easy
+// reach - is both very robust and natural, especially if we want to flexibly
+// avoid plants and other monsters in the way.
+static vector<coord_def> _path_waypoints(const monster* mons, bool in_sight,
+                                         const vector<coord_def> &path)
+{
+    vector<coord_def> waypoints;
+
+    // If no path found, nothing to be done.
+    if (path.empty())
+        return waypoints;
+
+    coord_def pos = path[0];
+
+#ifdef DEBUG_PATHFIND
+    mpr("\nWaypoints:");
+#endif
+    for (unsigned int i = 1; i < path.size(); i++)
+    {
+        if (can_go_straight(mons, pos, path[i])
+            && mons_can_traverse(*mons, path[i], in_sight))
+        {
+            continue;
+        }
+        else
+        {
+            pos = path[i-1];
+            waypoints.push_back(pos);
+#ifdef DEBUG_PATHFIND
+            mprf("waypoint: (%d, %d)", pos.x, pos.y);
+#endif
+        }
+    }
+
+    // Add the actual target to the list of waypoints, so we can later check
+    // whether a tracked enemy has moved too much, in case we have to update
+    // the path.
+    if (pos != path[path.size() - 1])
+        waypoints.push_back(path[path.size() - 1]);
+
+    return waypoints;
+}
+
 //#define DEBUG_PATHFIND
 monster_pathfind::monster_pathfind()
     : mons(nullptr), start(), target(), pos(), allow_diagonals(true),
@@ -375,48 +466,9 @@ vector<coord_def> monster_pathfind::backtrack()
     return path;
 }
 
-// Reduces the path coordinates to only a couple of key waypoints needed
-// to reach the target. Waypoints are chosen such that from one waypoint you
-// can see (and, more importantly, reach) the next one. Note that
-// can_go_straight() is probably rather too conservative in these estimates.
-// This is done because Crawl's pathfinding - once a target is in sight and easy
-// reach - is both very robust and natural, especially if we want to flexibly
-// avoid plants and other monsters in the way.
 vector<coord_def> monster_pathfind::calc_waypoints()
 {
-    vector<coord_def> path = backtrack();
-
-    // If no path found, nothing to be done.
-    if (path.empty())
-        return path;
-
-    vector<coord_def> waypoints;
-    pos = path[0];
-
-#ifdef DEBUG_PATHFIND
-    mpr("\nWaypoints:");
-#endif
-    for (unsigned int i = 1; i < path.size(); i++)
-    {
-        if (can_go_straight(mons, pos, path[i]) && mons_traversable(path[i]))
-            continue;
-        else
-        {
-            pos = path[i-1];
-            waypoints.push_back(pos);
-#ifdef DEBUG_PATHFIND
-            mprf("waypoint: (%d, %d)", pos.x, pos.y);
-#endif
-        }
-    }
-
-    // Add the actual target to the list of waypoints, so we can later check
-    // whether a tracked enemy has moved too much, in case we have to update
-    // the path.
-    if (pos != path[path.size() - 1])
-        waypoints.push_back(path[path.size() - 1]);
-
-    return waypoints;
+    return _path_waypoints(mons, traverse_in_sight, backtrack());
 }
 
 bool monster_pathfind::traversable_memoized(const coord_def& p)
@@ -493,40 +545,10 @@ int monster_pathfind::travel_cost(coord_def npos)
 int monster_pathfind::mons_travel_cost(coord_def npos)
 {
     ASSERT(grid_distance(pos, npos) <= 1);
-
-    // Doors need to be opened.
-    if (feat_is_closed_door(env.grid(npos)))
-        return 2;
-
-    // Travelling through water, entering or leaving water is more expensive
-    // for non-amphibious monsters, so they'll avoid it where possible.
-    // (The resulting path might not be optimal but it will lead to a path
-    // a monster of such habits is likely to prefer.)
-    if (mons->floundering_at(npos))
-        return 2;
-
-    // Try to avoid traps.
-    const trap_def* ptrap = trap_at(npos);
-    if (ptrap)
-    {
-        if (ptrap->is_bad_for_player())
-        {
-            // Your allies take extra precautions to avoid traps that are bad
-            // for you (elsewhere further checks are made to mark Zot traps as
-            // impassible).
-            if (mons->friendly())
-                return 3;
-
-            // To hostile monsters, these traps are completely harmless.
-            return 1;
-        }
-
-        return 2;
-    }
-
-    return 1;
+    return _mons_step_cost(mons, npos);
 }
 
+
 // The estimated cost to reach a grid is simply max(dx, dy).
 int monster_pathfind::estimated_cost(coord_def p)
 {
@@ -556,3 +578,295 @@ void monster_pathfind::update_pos(coord_def npos, int total)
 
     add_new_pos(npos, total);
 }
+
+/////////////////////////////////////////////////////////////////////////////
+// Shared distance fields
+//
+// A pack chasing the player would otherwise run one near-identical search
+// per monster. Instead, once a second monster needs a path to somewhere
+// this turn, the distance from every cell to there is filled in for
+// monsters that move the way it does, and the rest of the pack follow the
+// same field. The first monster searches for itself, since a field covers
+// the whole level where its own search would stop at its range; most
+// monsters are alone in heading where they are. Fields last until the turn
+// changes, the player changes level or the terrain changes.
+
+// Everything about a monster that mons_can_traverse() and _mons_step_cost()
+// look at. Monsters with ghosts, and thorn hunters, aren't covered by this
+// and always search for themselves.
+struct mons_path_class
+{
+    coord_def target;
+    monster_type type;      // habitat, size and doors
+    monster_type base;      // zombies and draconians
+    bool airborne;
+    bool friendly;          // doors and traps
+    bool wont_attack;       // traps bad for the player
+    bool sees_you;          // friendlies avoid teleport traps while they do
+    bool eats_items;        // jellies eat doors
+    bool blood_for_blood;   // can open doors while friendly
+
+    bool operator==(const mons_path_class &other) const
+    {
+        return target == other.target
+               && type == other.type
+               && base == other.base
+               && airborne == other.airborne
+               && friendly == other.friendly
+               && wont_attack == other.wont_attack
+               && sees_you == other.sees_you
+               && eats_items == other.eats_items
+               && blood_for_blood == other.blood_for_blood;
+    }
+};
+
+static const uint8_t UNKNOWN_COST = 0xff;
+
+struct mons_distance_field
+{
+    mons_path_class cls;
+    // The least total cost of a path from each cell to the target.
+    uint16_t dist[GXM][GYM];
+    // The cost to step onto each cell, 0 if it can't be, or UNKNOWN_COST
+    // if the search didn't need to know.
+    uint8_t cost[GXM][GYM];
+};
+
+static const int MAX_SHARED_FIELDS = 8;
+static vector<unique_ptr<mons_distance_field>> _shared_fields;
+static int _num_shared_fields = 0;
+// Searches this turn that have no field yet.
+static vector<mons_path_class> _path_requests;
+static int _next_shared_field = 0;
+static int _shared_fields_time = -1;
+static level_id _shared_fields_level;
+static bool _share_paths = true;
+
+static bool _can_share_path(const monster* mon)
+{
+    return _share_paths
+           && !mon->ghost
+           && mon->type != MONS_THORN_HUNTER
+           // See init_pathfind(): these can't path out of the player's sight.
+           && (crawl_state.game_is_arena()
+               || !mon->friendly() || !mon->is_summoned()
+               || !you.see_cell_no_trans(mon->pos()));
+}
+
+static mons_path_class _path_class(const monster* mon, coord_def target)
+{
+    mons_path_class cls;
+    cls.target = target;
+    cls.type = mon->type;
+    cls.base = mons_base_type(*mon);
+    cls.airborne = mon->airborne();
+    cls.friendly = mon->friendly();
+    cls.wont_attack = mon->wont_attack();
+    cls.sees_you = cls.friendly && mon->can_see(you);
+    cls.eats_items = mons_eats_items(*mon);
+    cls.blood_for_blood = cls.friendly && mons_is_blood_for_blood_orc(*mon);
+    return cls;
+}
+
+// The cost for mon to step onto p in this field, or 0 if it can't; as
+// monster_pathfind::traversable() and mons_travel_cost() would say.
+static int _field_cost(mons_distance_field &field, const monster* mon,
+                       const coord_def &p)
+{
+    uint8_t &cost = field.cost[p.x][p.y];
+    if (cost != UNKNOWN_COST)
+        return cost;
+
+    // The target itself needn't be traversable; see start_pathfind().
+    if (p != field.cls.target
+        && (env.grid(p) == DNGN_UNSEEN
+            || (opc_immob(p) == OPC_OPAQUE
+                && !feat_is_closed_door(env.grid(p)))
+            || !mons_can_traverse(*mon, p, false)))
+    {
+        cost = 0;
+    }
+    else
+        cost = _mons_step_cost(mon, p);
+    return cost;
+}
+
+// Dijkstra's algorithm outwards from the target. Step costs are between one
+// and three, so four rotating queues, one per distance, stand in for a heap.
+static void _fill_field(mons_distance_field &field, const monster* mon)
+{
+    memset(field.cost, UNKNOWN_COST, sizeof(field.cost));
+    for (int x = 0; x < GXM; x++)
+        for (int y = 0; y < GYM; y++)
+            field.dist[x][y] = INFINITE_DISTANCE;
+
+    const coord_def target = field.cls.target;
+    field.dist[target.x][target.y] = 0;
+
+    vector<coord_def> queues[4];
+    queues[0].push_back(target);
+    int queued = 1;
+    for (int d = 0; queued; d++)
+    {
+        vector<coord_def> &queue = queues[d % 4];
+        for (const coord_def c : queue)
+        {
+            // Superseded by a shorter path.
+            if (field.dist[c.x][c.y] != d)
+                continue;
+
+            const int step = d + _field_cost(field, mon, c);
+            for (adjacent_iterator ai(c); ai; ++ai)
+            {
+                if (!in_bounds(*ai) || step >= field.dist[ai->x][ai->y])
+                    continue;
+                // Cells that can't be stepped onto can still be started
+                // from, but paths don't go on through them.
+                field.dist[ai->x][ai->y] = step;
+                if (_field_cost(field, mon, *ai))
+                {
+                    queues[step % 4].push_back(*ai);
+                    queued++;
+                }
+            }
+        }
+        queued -= queue.size();
+        queue.clear();
+    }
+}
+
+// The field for the monster to reach the target, or nullptr if nothing
+// else has searched for the same thing this turn.
+static mons_distance_field *_find_field(const monster* mon, coord_def target)
+{
+    const level_id here = level_id::current();
+    if (_shared_fields_time != you.elapsed_time
+        || _shared_fields_level != here)
+    {
+        forget_shared_paths();
+        _shared_fields_time = you.elapsed_time;
+        _shared_fields_level = here;
+    }
+
+    const mons_path_class cls = _path_class(mon, target);
+    for (int i = 0; i < _num_shared_fields; i++)
+        if (_shared_fields[i]->cls == cls)
+            return _shared_fields[i].get();
+
+    auto request = find(_path_requests.begin(), _path_requests.end(), cls);
+    if (request == _path_requests.end())
+    {
+        _path_requests.push_back(cls);
+        return nullptr;
+    }
+    _path_requests.erase(request);
+
+    // Reuse the oldest field once there are enough.
+    int slot = _num_shared_fields;
+    if (slot < MAX_SHARED_FIELDS)
+        _num_shared_fields++;
+    else
+    {
+        slot = _next_shared_field;
+        _next_shared_field = (_next_shared_field + 1) % MAX_SHARED_FIELDS;
+    }
+    if (slot >= (int) _shared_fields.size())
+        _shared_fields.emplace_back(new mons_distance_field);
+
+    mons_distance_field &field = *_shared_fields[slot];
+    field.cls = cls;
+    _fill_field(field, mon);
+    return &field;
+}
+
+// The path from the monster to the target along the field. maybe if the
+// shortest path breaks the range limits of monster_pathfind, which might
+// still find a longer one that doesn't.
+static maybe_bool _field_path(const mons_distance_field &field,
+                              coord_def start, int range,
+                              vector<coord_def> &path)
+{
+    const coord_def target = field.cls.target;
+    if (field.dist[start.x][start.y] >= INFINITE_DISTANCE)
+        return false;
+    if (range && field.dist[start.x][start.y] > range * 2)
+        return maybe_bool::maybe;
+
+    path.clear();
+    path.push_back(start);
+    coord_def pos = start;
+    while (pos != target)
+    {
+        const int d = field.dist[pos.x][pos.y];
+        coord_def next;
+        // Diagonals first, and a random 90 degree rotation to avoid bias,
+        // as in calc_path_to_neighbours().
+        const int rotate = random2(4) * 2;
+        for (int idir = 1; idir < 8; (idir += 2) == 9 && (idir = 0))
+        {
+            const coord_def c = pos + Compass[(idir + rotate) % 8];
+            if (!in_bounds(c))
+                continue;
+            const int cost = field.cost[c.x][c.y];
+            if (cost && cost != UNKNOWN_COST
+                && field.dist[c.x][c.y] + cost == d)
+            {
+                next = c;
+                break;
+            }
+        }
+        ASSERT(!next.origin());
+        if (range && grid_distance(next, target) > range)
+            return maybe_bool::maybe;
+        path.push_back(next);
+        pos = next;
+    }
+    return true;
+}
+
+/**
+ * Find the waypoints for a monster to reach somewhere, as monster_pathfind's
+ * init_pathfind() and calc_waypoints() would with the given range, sharing
+ * the search with other monsters that move the same way and are heading to
+ * the same place this turn.
+ *
+ * @param mon    The monster.
+ * @param dest   Where it's going.
+ * @param range  The furthest from dest the path may go; see set_range().
+ * @return       The waypoints, or nothing if there's no path.
+ */
+vector<coord_def> mons_find_waypoints(const monster* mon, coord_def dest,
+                                      int range)
+{
+    const mons_distance_field *field = nullptr;
+    if (_can_share_path(mon) && mon->pos() != dest)
+        field = _find_field(mon, dest);
+    if (field)
+    {
+        vector<coord_def> path;
+        const maybe_bool found = _field_path(*field, mon->pos(), range,
+                                             path);
+        if (found == true)
+            return _path_waypoints(mon, false, path);
+        if (found == false)
+            return vector<coord_def>();
+    }
+
+    monster_pathfind mp;
+    mp.set_range(range);
+    if (mp.init_pathfind(mon, dest))
+        return mp.calc_waypoints();
+    return vector<coord_def>();
+}
+
+void set_shared_pathfinding(bool share)
+{
+    _share_paths = share;
+    forget_shared_paths();
+}
+
+void forget_shared_paths()
+{
+    _num_shared_fields = 0;
+    _path_requests.clear();
+}
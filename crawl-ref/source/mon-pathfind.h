@@ -13,6 +13,13 @@ class monster;
 
 int mons_tracking_range(const monster* mon);
 
+vector<coord_def> mons_find_waypoints(const monster* mon, coord_def dest,
+                                      int range);
+// Whether monsters may share paths; for benchmarking.
+void set_shared_pathfinding(bool share);
+// Throw away the shared paths, e.g. because the terrain changed.
+void forget_shared_paths();
+
 class monster_pathfind
 {
 public:
@@ -2965,7 +2965,6 @@ void define_monster(monster& mons, bool friendly)
 
     // Reset monster enchantments.
     mons.enchantments.clear();
-    mons.ench_cache.reset();
     mons.ench_countdown = 0;
 
     switch (mcls)
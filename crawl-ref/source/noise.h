@@ -68,39 +68,23 @@ struct noise_t
     }
 };
 
-struct noise_cell
+// Where and how loudly a noise was heard, as found by the wavefront.
+struct noise_heard
 {
-    // The cell from which the noise reached this cell (delta)
-    coord_def neighbour_delta;
-
-    int16_t noise_id;
+    coord_def pos;
     int noise_intensity_millis;
+    int16_t noise_id;
+    // How far the noise went to get here, which can be more than the
+    // distance from its source if it went around corners.
     int noise_travel_distance;
 
-    noise_cell();
-    bool can_apply_noise(int noise_intensity_millis) const;
-    bool apply_noise(int noise_intensity_millis,
-                     int noise_id,
-                     int travel_distance,
-                     const coord_def &neighbour_delta);
-
-    bool silent() const
+    bool operator == (const noise_heard &other) const
     {
-        return !noise_is_audible(noise_intensity_millis);
+        return pos == other.pos
+               && noise_intensity_millis == other.noise_intensity_millis
+               && noise_id == other.noise_id
+               && noise_travel_distance == other.noise_travel_distance;
     }
-
-    // Given a destination cell adjacent to this cell, returns the
-    // angle of <previous cell> <pos> <next-pos>:
-    //  * If all three cells are in a straight line, returns 0
-    //  * If the target cell is a knight's move from the original position,
-    //    returns 1
-    //  * If the target cell makes a right angle from the original position,
-    //    returns 2
-    //  * If the target cell makes a sharp 45 degree angle, returns 3.
-    //  * If the original position is the same as the new position, returns 4.
-    // This number is used to multiply the noise attenuation for noise passing
-    // through this cell.
-    int turn_angle(const coord_def &next_delta) const;
 };
 
 class noise_grid
@@ -115,6 +99,11 @@ public:
     // Propagate noise from the noise sources registered.
     void propagate_noise();
 
+    // Find every cell the registered noises are heard in, in the order
+    // propagate_noise() applies them, without applying them. A cell is
+    // listed again each time a louder noise reaches it.
+    vector<noise_heard> wavefront() const;
+
     // Clear all noise from the noise grid.
     void reset();
 
@@ -127,21 +116,12 @@ public:
 #endif
 
 private:
-    bool propagate_noise_to_neighbour(int base_attenuation,
-                                      int travel_distance,
-                                      const noise_cell &cell,
-                                      const coord_def &pos,
-                                      const coord_def &next_position);
-    void apply_noise_effects(const coord_def &pos,
-                             int noise_intensity_millis,
-                             const noise_t &noise);
-
-    coord_def noise_perceived_position(actor *act,
-                                       const coord_def &affected_position,
+    void apply_noise_effects(const noise_heard &heard, const noise_t &noise);
+
+    coord_def noise_perceived_position(actor *act, const noise_heard &heard,
                                        const noise_t &noise) const;
 
 private:
-    FixedArray<noise_cell, GXM, GYM> cells;
     vector<noise_t> noises;
     int affected_actor_count;
 };
@@ -935,6 +935,7 @@ public:
     bool        tile_level_map_hide_sidebar;
     bool        tile_web_mouse_control;
     string      tile_web_mobile_input_helper;
+    bool        tile_web_compact_map;
 #endif
 #endif // USE_TILE
 
@@ -1670,6 +1670,7 @@ void redraw_screen(bool show_updates)
 #endif
 
     draw_border();
+    view_mark_all_dirty();
 
     you.redraw_stats.init(true);
     you.redraw_title         = true;
@@ -32,12 +32,18 @@ Notes:
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
 #include <unistd.h>
 #endif
+#ifdef USE_MMAP
+#include <sys/mman.h>
+#endif
 
 #include "end.h"
 #include "endianness.h"
 #include "errors.h"
 #include "syscalls.h"
 #include "libutil.h" // map_find
+#ifdef USE_ZLIB
+#include "threads.h"
+#endif
 
 // debugging defines
 #undef  FSCK_VERBOSE
@@ -81,11 +87,30 @@ typedef pair<plen_t, plen_t> bm_p;
 typedef map<plen_t, bm_p> bm_t;
 typedef map<plen_t, plen_t> fb_t;
 
+#ifdef USE_ZLIB
+// A chunk that has been written, and is being compressed by a worker thread.
+struct deferred_chunk
+{
+    string name;
+    vector<unsigned char> *data;
+    vector<unsigned char> compressed;
+    thread_t worker;
+    bool threaded;
+    string error;
+};
+#endif
+
 package::package(const char* file, bool writeable, bool empty)
   : n_users(0), dirty(false), aborted(false)
 #ifdef DO_FSYNC
     , tmp(false)
 #endif
+#ifdef USE_MMAP
+    , use_mmap(true), map_base(nullptr), map_len(0)
+#endif
+#ifdef USE_ZLIB
+    , defer_compression(false), pending(nullptr)
+#endif
 {
     dprintf("package: initializing file=\"%s\" rw=%d\n", file, writeable);
     ASSERT(writeable || !empty);
@@ -136,6 +161,12 @@ package::package()
 #ifdef DO_FSYNC
     , tmp(true)
 #endif
+#ifdef USE_MMAP
+    , use_mmap(true), map_base(nullptr), map_len(0)
+#endif
+#ifdef USE_ZLIB
+    , defer_compression(false), pending(nullptr)
+#endif
 {
     dprintf("package: initializing tmp file\n");
     filename = "[tmp]";
@@ -214,6 +245,14 @@ package::~package()
         // catching missing manual deletes. The C++ exit handler is the
         // only place that can be legitimately call things in wrong order.
 
+#ifdef USE_ZLIB
+    if (aborted)
+        discard_deferred();
+#endif
+#ifdef USE_MMAP
+    unmap(true);
+#endif
+
     if (rw && !aborted)
     {
         commit();
@@ -234,6 +273,7 @@ package::~package()
 void package::commit()
 {
     ASSERT(rw);
+    flush_deferred();
     if (!dirty)
         return;
     ASSERT(!aborted);
@@ -269,6 +309,71 @@ void package::commit()
 #endif
 }
 
+void package::set_mmap(bool use)
+{
+#ifdef USE_MMAP
+    use_mmap = use;
+    if (!use && !n_users)
+        unmap(true);
+#else
+    UNUSED(use);
+#endif
+}
+
+#ifdef USE_MMAP
+// Returns a pointer to the given range of the file, mapping (or remapping)
+// it if needed. Returns nullptr if the range can't be mapped, in which case
+// the caller should fall back to read(), which will report any errors.
+const unsigned char *package::map_range(plen_t at, plen_t len)
+{
+    if (!use_mmap || fd == -1 || aborted)
+        return nullptr;
+
+    if ((uint64_t)at + len > map_len)
+    {
+        // The file may have grown since it was last mapped.
+        struct stat st;
+        if (fstat(fd, &st) || (uint64_t)at + len > (uint64_t)st.st_size
+            || (uint64_t)st.st_size > (plen_t)-1)
+        {
+            return nullptr;
+        }
+
+        void *m = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (m == MAP_FAILED)
+        {
+            dprintf("package: mmap failed, falling back to read()\n");
+            use_mmap = false;
+            return nullptr;
+        }
+
+        // Other readers may still be inflating from the old mapping, so it
+        // has to stay around until they are all done.
+        if (map_base)
+            stale_maps.emplace_back(map_base, map_len);
+        map_base = (const unsigned char *)m;
+        map_len = st.st_size;
+        dprintf("package: mapped %u bytes\n", map_len);
+    }
+
+    return map_base + at;
+}
+
+void package::unmap(bool all)
+{
+    for (const auto &m : stale_maps)
+        munmap((void *)m.first, m.second);
+    stale_maps.clear();
+
+    if (all && map_base)
+    {
+        munmap((void *)map_base, map_len);
+        map_base = nullptr;
+        map_len = 0;
+    }
+}
+#endif
+
 void package::seek(plen_t to)
 {
     ASSERT(!aborted);
@@ -286,6 +391,7 @@ chunk_writer* package::writer(const string &name)
 
 chunk_reader* package::reader(const string &name)
 {
+    flush_deferred();
     if (plen_t *ch = map_find(directory, name))
         return new chunk_reader(this, *ch);
     return 0;
@@ -384,6 +490,7 @@ void package::free_chunk(const string &name)
 
 void package::delete_chunk(const string &name)
 {
+    flush_deferred();
     free_chunk(name);
     directory.erase(name);
 }
@@ -564,11 +671,16 @@ void package::read_directory(plen_t start, uint8_t version)
 
 bool package::has_chunk(const string &name)
 {
+#ifdef USE_ZLIB
+    if (pending && !name.empty() && pending->name == name)
+        return true;
+#endif
     return !name.empty() && directory.count(name);
 }
 
 vector<string> package::list_chunks()
 {
+    flush_deferred();
     vector<string> list;
     list.reserve(directory.size());
     for (const auto &entry : directory)
@@ -620,16 +732,126 @@ void package::abort()
     // this point are ignored (assuming we already failed). All writes since
     // the last commit() are lost.
     aborted = true;
+#ifdef USE_ZLIB
+    discard_deferred();
+#endif
 }
 
 void package::unlink()
 {
     abort();
+#ifdef USE_MMAP
+    unmap(true);
+#endif
     close(fd);
     fd = -1;
     ::unlink_u(filename.c_str());
 }
 
+#ifdef USE_ZLIB
+static void _deflate_deferred(deferred_chunk *job)
+{
+    z_stream zs;
+    zs.data_type = Z_BINARY;
+    zs.zalloc    = 0;
+    zs.zfree     = 0;
+    zs.opaque    = Z_NULL;
+    if (deflateInit(&zs, Z_DEFAULT_COMPRESSION))
+    {
+        job->error = zs.msg ? zs.msg : "init";
+        return;
+    }
+
+    job->compressed.resize(deflateBound(&zs, job->data->size()));
+    zs.next_in   = job->data->data();
+    zs.avail_in  = job->data->size();
+    zs.next_out  = job->compressed.data();
+    zs.avail_out = job->compressed.size();
+    if (deflate(&zs, Z_FINISH) != Z_STREAM_END)
+        job->error = zs.msg ? zs.msg : "incomplete stream";
+    job->compressed.resize(zs.total_out);
+    if (deflateEnd(&zs) != Z_OK && job->error.empty())
+        job->error = zs.msg ? zs.msg : "clean-up";
+
+    // Nothing else needs the plain data; free it from this thread.
+    delete job->data;
+    job->data = nullptr;
+}
+
+static void *_deferred_worker(void *arg)
+{
+    _deflate_deferred(static_cast<deferred_chunk *>(arg));
+    return nullptr;
+}
+
+void package::set_deferred_compression(bool defer)
+{
+    defer_compression = defer;
+    // Nothing may be left compressing once deferral ends.
+    if (!defer)
+        flush_deferred();
+}
+
+void package::queue_deferred(const string &name, vector<unsigned char> *data)
+{
+    // Only one chunk is compressed at a time: finishing the previous one
+    // here keeps chunks reaching the file in the order they were written.
+    flush_deferred();
+
+    pending = new deferred_chunk;
+    pending->name = name;
+    pending->data = data;
+    pending->threaded = !thread_create_joinable(&pending->worker,
+                                                _deferred_worker, pending);
+    if (!pending->threaded)
+        _deflate_deferred(pending);
+}
+
+void package::flush_deferred()
+{
+    if (!pending)
+        return;
+
+    deferred_chunk *job = pending;
+    pending = nullptr;
+    if (job->threaded)
+        thread_join(job->worker);
+
+    if (!job->error.empty())
+    {
+        const string error = job->error;
+        delete job;
+        fail("save file compression failed: %s", error.c_str());
+    }
+
+    {
+        chunk_writer cw(this, job->name, true);
+        cw.raw_write(job->compressed.data(), job->compressed.size());
+    }
+    delete job;
+}
+
+void package::discard_deferred()
+{
+    if (!pending)
+        return;
+
+    if (pending->threaded)
+        thread_join(pending->worker);
+    delete pending->data;
+    delete pending;
+    pending = nullptr;
+}
+#else
+void package::set_deferred_compression(bool /*defer*/)
+{
+}
+
+void package::flush_deferred()
+{
+}
+#endif
+
 // the amount of free space not at the end of file
 plen_t package::get_slack()
 {
@@ -643,6 +865,7 @@ plen_t package::get_slack()
 
 plen_t package::get_chunk_fragmentation(const string &name)
 {
+    flush_deferred();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t frags = 0;
@@ -659,6 +882,7 @@ plen_t package::get_chunk_fragmentation(const string &name)
 
 plen_t package::get_chunk_compressed_length(const string &name)
 {
+    flush_deferred();
     load_traces();
     ASSERT(directory.count(name)); // not has_chunk(), "" is valid
     plen_t len = 0;
@@ -675,6 +899,9 @@ plen_t package::get_chunk_compressed_length(const string &name)
 
 chunk_writer::chunk_writer(package *parent, const string &_name)
     : first_block(0), cur_block(0), block_len(0)
+#ifdef USE_ZLIB
+    , z_buffer(nullptr), deferred(nullptr), precompressed(false)
+#endif
 {
     ASSERT(parent);
     ASSERT(!parent->aborted);
@@ -689,6 +916,34 @@ chunk_writer::chunk_writer(package *parent, const string &_name)
     name = _name;
 
 #ifdef USE_ZLIB
+    if (pkg->defer_compression)
+        deferred = new vector<unsigned char>;
+    else
+        init_zlib();
+#endif
+}
+
+#ifdef USE_ZLIB
+chunk_writer::chunk_writer(package *parent, const string &_name,
+                           bool _precompressed)
+    : first_block(0), cur_block(0), block_len(0),
+      z_buffer(nullptr), deferred(nullptr), precompressed(_precompressed)
+{
+    ASSERT(parent);
+    ASSERT(!parent->aborted);
+    ASSERT(_name.length() < MAX_CHUNK_NAME_LENGTH);
+
+    dprintf("chunk_writer(%s): starting\n", _name.c_str());
+    pkg = parent;
+    pkg->n_users++;
+    name = _name;
+
+    if (!precompressed)
+        init_zlib();
+}
+
+void chunk_writer::init_zlib()
+{
     zs.data_type = Z_BINARY;
     zs.zalloc    = 0;
     zs.zfree     = 0;
@@ -698,8 +953,8 @@ chunk_writer::chunk_writer(package *parent, const string &_name)
 #define ZB_SIZE 32768
     zs.next_out  = z_buffer = (Bytef*)malloc(ZB_SIZE);
     zs.avail_out = ZB_SIZE;
-#endif
 }
+#endif
 
 chunk_writer::~chunk_writer()
 {
@@ -710,14 +965,32 @@ chunk_writer::~chunk_writer()
     if (pkg->aborted)
     {
 #ifdef USE_ZLIB
-        // ignore errors, they're not relevant anymore
-        deflateEnd(&zs);
-        free(z_buffer);
+        delete deferred;
+        if (z_buffer)
+        {
+            // ignore errors, they're not relevant anymore
+            deflateEnd(&zs);
+            free(z_buffer);
+        }
 #endif
         return;
     }
 
 #ifdef USE_ZLIB
+    if (deferred)
+    {
+        // The package takes ownership of the data.
+        pkg->queue_deferred(name, deferred);
+        return;
+    }
+    if (precompressed)
+    {
+        if (cur_block)
+            finish_block(0);
+        pkg->finish_chunk(name, first_block);
+        return;
+    }
+
     zs.avail_in = 0;
     int res;
     do
@@ -783,6 +1056,13 @@ void chunk_writer::write(const void *data, plen_t len)
     ASSERT(!pkg->aborted);
 
 #ifdef USE_ZLIB
+    if (deferred)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        deferred->insert(deferred->end(), bytes, bytes + len);
+        return;
+    }
+
     zs.next_in  = (Bytef*)data;
     zs.avail_in = len;
     while (zs.avail_in)
@@ -838,6 +1118,8 @@ chunk_reader::chunk_reader(package *parent, const string &_name)
     ASSERT(parent);
     if (!parent->has_chunk(_name))
         corrupted("save file corrupted -- chunk \"%s\" missing", _name.c_str());
+    // The chunk may still be waiting to be compressed and written.
+    parent->flush_deferred();
     dprintf("chunk_reader(%s): starting\n", _name.c_str());
     pkg = parent;
     init(parent->directory[_name]);
@@ -856,6 +1138,10 @@ chunk_reader::~chunk_reader()
         pkg->reader_count.erase(first_block);
     ASSERT(pkg->n_users > 0);
     pkg->n_users--;
+#ifdef USE_MMAP
+    if (!pkg->n_users)
+        pkg->unmap(false);
+#endif
 }
 
 plen_t chunk_reader::raw_read(void *data, plen_t len)
@@ -904,6 +1190,43 @@ plen_t chunk_reader::raw_read(void *data, plen_t len)
     return (char*)buf - (char*)data;
 }
 
+#ifdef USE_MMAP
+// Like raw_read(), but returns the rest of the current block in place
+// instead of copying it. Returns false if the file can't be mapped.
+bool chunk_reader::mapped_read(const unsigned char *&data, plen_t &len)
+{
+    len = 0;
+    if (!block_left)
+    {
+        if (!next_block)
+            return true;
+
+        const unsigned char *head =
+            pkg->map_range(next_block, sizeof(block_header));
+        if (!head)
+            return false;
+
+        block_header bl;
+        memcpy(&bl, head, sizeof(block_header));
+        off = next_block + sizeof(block_header);
+        block_left = htole(bl.len);
+        next_block = htole(bl.next);
+        // This reeks of on-disk corruption (zeroed data).
+        if (!block_left)
+            corrupted("save file corrupted -- empty block");
+    }
+
+    data = pkg->map_range(off, block_left);
+    if (!data)
+        return false;
+
+    len = block_left;
+    off += block_left;
+    block_left = 0;
+    return true;
+}
+#endif
+
 plen_t chunk_reader::read(void *data, plen_t len)
 {
     ASSERT(data);
@@ -922,8 +1245,21 @@ plen_t chunk_reader::read(void *data, plen_t len)
     {
         if (!zs.avail_in)
         {
-            zs.next_in  = z_buffer;
-            zs.avail_in = raw_read(z_buffer, sizeof(z_buffer));
+#ifdef USE_MMAP
+            const unsigned char *mapped;
+            plen_t mapped_len;
+            if (mapped_read(mapped, mapped_len))
+            {
+                // Inflate straight from the mapped pages.
+                zs.next_in  = (Bytef*)mapped;
+                zs.avail_in = mapped_len;
+            }
+            else
+#endif
+            {
+                zs.next_in  = z_buffer;
+                zs.avail_in = raw_read(z_buffer, sizeof(z_buffer));
+            }
             if (!zs.avail_in)
                 corrupted("save file corrupted -- block truncated");
         }
@@ -942,16 +1278,32 @@ plen_t chunk_reader::read(void *data, plen_t len)
 #endif
 }
 
-void chunk_reader::read_all(vector<char> &data)
+template<typename T>
+void chunk_reader::read_all_into(vector<T> &data)
 {
-#define SPACE 1024
+    // Grow the buffer geometrically, so that big chunks are inflated in a
+    // few large steps.
+    plen_t space = 1024;
     plen_t s, at;
-    do
+    while (true)
     {
         at = data.size();
-        data.resize(at + SPACE);
-        s = read(&data[at], SPACE);
-    } while (s == SPACE);
+        data.resize(at + space);
+        s = read(&data[at], space);
+        if (s != space)
+            break;
+        if (space < 1024 * 1024)
+            space *= 2;
+    }
     data.resize(at + s);
-#undef SPACE
+}
+
+void chunk_reader::read_all(vector<char> &data)
+{
+    read_all_into(data);
+}
+
+void chunk_reader::read_all(vector<unsigned char> &data)
+{
+    read_all_into(data);
 }
@@ -21,11 +21,19 @@ using std::vector;
 #define DO_FSYNC
 #endif
 
+// Read chunks straight out of a memory mapping of the save file.
+#ifdef UNIX
+#define USE_MMAP
+#endif
+
 #define MAX_CHUNK_NAME_LENGTH 255
 
 typedef uint32_t plen_t;
 
 class package;
+#ifdef USE_ZLIB
+struct deferred_chunk;
+#endif
 
 class chunk_writer
 {
@@ -38,6 +46,13 @@ private:
 #ifdef USE_ZLIB
     z_stream zs;
     Bytef *z_buffer;
+    // If set, the uncompressed data is collected here and handed to the
+    // package to be compressed in the background once we're done.
+    vector<unsigned char> *deferred;
+    // Data is already compressed, write it as-is.
+    bool precompressed;
+    chunk_writer(package *parent, const string &_name, bool _precompressed);
+    void init_zlib();
 #endif
     void raw_write(const void *data, plen_t len);
     void finish_block(plen_t next);
@@ -62,11 +77,16 @@ private:
     Bytef z_buffer[32768];
 #endif
     plen_t raw_read(void *data, plen_t len);
+#ifdef USE_MMAP
+    bool mapped_read(const unsigned char *&data, plen_t &len);
+#endif
+    template<typename T> void read_all_into(vector<T> &data);
 public:
     chunk_reader(package *parent, const string &_name);
     ~chunk_reader();
     plen_t read(void *data, plen_t len);
     void read_all(vector<char> &data);
+    void read_all(vector<unsigned char> &data);
     friend class package;
 };
 
@@ -86,6 +106,16 @@ public:
     void unlink();
     string get_filename() { return filename; }
 
+    // While set, chunks are compressed on a worker thread after their
+    // writer is closed, and written out at the next operation that needs
+    // them (or when the next deferred chunk is closed).
+    void set_deferred_compression(bool defer);
+    void flush_deferred();
+
+    // Whether readers may use a memory mapping of the file (where
+    // supported) instead of read() calls. On by default.
+    void set_mmap(bool use);
+
     // statistics
     plen_t get_slack();
     plen_t get_size() const { return file_len; };
@@ -108,6 +138,22 @@ private:
     map<plen_t, pair<plen_t, plen_t> > block_map;
     set<plen_t> new_chunks;
     map<plen_t, uint32_t> reader_count;
+#ifdef USE_MMAP
+    bool use_mmap;
+    const unsigned char *map_base;
+    plen_t map_len;
+    // Mappings replaced by a larger one while readers might still have
+    // been using them.
+    vector<pair<const unsigned char *, plen_t> > stale_maps;
+    const unsigned char *map_range(plen_t at, plen_t len);
+    void unmap(bool all);
+#endif
+#ifdef USE_ZLIB
+    bool defer_compression;
+    deferred_chunk *pending;
+    void queue_deferred(const string &name, vector<unsigned char> *data);
+    void discard_deferred();
+#endif
     plen_t extend_block(plen_t at, plen_t size, plen_t by);
     plen_t alloc_block(plen_t &size);
     void finish_chunk(const string &name, plen_t at);
@@ -125,3 +171,19 @@ private:
     friend class chunk_writer;
     friend class chunk_reader;
 };
+
+// Compress chunks in the background for the lifetime of this object.
+class deferred_compression
+{
+public:
+    deferred_compression(package *save) : pkg(save)
+    {
+        pkg->set_deferred_compression(true);
+    }
+    ~deferred_compression()
+    {
+        pkg->set_deferred_compression(false);
+    }
+private:
+    package *pkg;
+};
@@ -14,6 +14,7 @@
 #endif
 
 #include "pattern.h"
+#include "libutil.h"
 #include "stringutil.h"
 
 #if defined(REGEX_PCRE)
@@ -229,3 +230,315 @@ pattern_match plaintext_pattern::match_location(const string &s) const
     else
         return pattern_match::failed(s);
 }
+
+static bool _pattern_prefilter = true;
+
+void set_pattern_prefilter(bool enabled)
+{
+    _pattern_prefilter = enabled;
+}
+
+// Skip the bracketed character class starting at pattern[i], returning the
+// index after it, or string::npos if it's unclosed or has a backslash (which
+// PCRE and POSIX read differently).
+static size_t _skip_class(const string &pattern, size_t i)
+{
+    ++i;
+    if (i < pattern.size() && pattern[i] == '^')
+        ++i;
+    if (i < pattern.size() && pattern[i] == ']')
+        ++i;
+    while (i < pattern.size())
+    {
+        const char c = pattern[i];
+        if (c == '\\')
+            return string::npos;
+        if (c == ']')
+            return i + 1;
+        if (c == '[' && i + 1 < pattern.size()
+            && (pattern[i + 1] == ':' || pattern[i + 1] == '.'
+                || pattern[i + 1] == '='))
+        {
+            const size_t close = pattern.find(string(1, pattern[i + 1]) + "]",
+                                              i + 2);
+            if (close == string::npos)
+                return string::npos;
+            i = close + 2;
+        }
+        else
+            ++i;
+    }
+    return string::npos;
+}
+
+// Skip the group starting at pattern[i], returning the index after it, or
+// string::npos if it's unclosed.
+static size_t _skip_group(const string &pattern, size_t i)
+{
+    int depth = 0;
+    while (i < pattern.size())
+    {
+        switch (pattern[i])
+        {
+        case '\\':
+            i += 2;
+            continue;
+        case '[':
+            i = _skip_class(pattern, i);
+            if (i == string::npos)
+                return i;
+            continue;
+        case '(':
+            ++depth;
+            break;
+        case ')':
+            if (!--depth)
+                return i + 1;
+            break;
+        }
+        ++i;
+    }
+    return string::npos;
+}
+
+/**
+ * Find the runs of plain text that every match of a regex contains.
+ *
+ * This only has to be safe, not thorough: it gives up on anything unusual,
+ * and what's inside groups is never used. Only ASCII text is kept, so that
+ * callers can compare it with ASCII-lowercased strings.
+ *
+ * @param regex The regex, in PCRE or POSIX extended syntax.
+ * @returns The runs, lowercased, in order; empty if none was found.
+ */
+vector<string> regex_required_literals(const string &regex)
+{
+    vector<string> runs;
+    // Inline options such as (?x) could change what the rest means.
+    if (regex.find("(?") != string::npos)
+        return runs;
+
+    string run;
+    auto end_run = [&]()
+    {
+        if (!run.empty())
+            runs.push_back(run);
+        run.clear();
+    };
+
+    for (size_t i = 0; i < regex.size();)
+    {
+        const char c = regex[i];
+        switch (c)
+        {
+        case '|':
+            return vector<string>();
+        case '(':
+        case '[':
+            i = c == '(' ? _skip_group(regex, i) : _skip_class(regex, i);
+            if (i == string::npos)
+                return vector<string>();
+            end_run();
+            continue;
+        case '*':
+        case '?':
+        case '+':
+        case '{':
+            // The character before might not be there at all.
+            if (!run.empty())
+                run.pop_back();
+            end_run();
+            if (c == '{')
+            {
+                i = regex.find('}', i);
+                if (i == string::npos)
+                    return vector<string>();
+            }
+            ++i;
+            continue;
+        case '\\':
+        {
+            if (i + 1 == regex.size())
+                return vector<string>();
+            const char esc = regex[i + 1];
+            if (isaalnum(esc))
+            {
+                // Only escapes that stand for a single character or a zero
+                // width assertion: others take arguments.
+                if (!strchr("bBdDsSwWntrfAzZ", esc))
+                    return vector<string>();
+                end_run();
+            }
+            // Other escapes might be anchors, like GNU's \< and \'.
+            else if (strchr(".[]{}()\\*+?^$|", esc))
+                run += esc;
+            else
+                end_run();
+            i += 2;
+            continue;
+        }
+        case '.':
+        case '^':
+        case '$':
+        case ')':
+            end_run();
+            ++i;
+            continue;
+        default:
+            // Leave case folding of anything but ASCII to the regex library.
+            if (static_cast<unsigned char>(c) >= 128)
+                end_run();
+            else
+                run += static_cast<char>(toalower(c));
+            ++i;
+            continue;
+        }
+    }
+    end_run();
+    return runs;
+}
+
+void pattern_set::clear()
+{
+    patterns.clear();
+    compiled = false;
+}
+
+void pattern_set::add(const text_pattern &pattern)
+{
+    patterns.push_back(pattern);
+    compiled = false;
+}
+
+void pattern_set::compile() const
+{
+    compiled = true;
+    unfiltered.clear();
+    memset(byte_class, 0, sizeof(byte_class));
+    num_classes = 1;
+
+    vector<string> literals;
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        string longest;
+        for (const string &run
+             : regex_required_literals(patterns[i].tostring()))
+        {
+            if (run.size() > longest.size())
+                longest = run;
+        }
+        literals.push_back(longest);
+        if (literals.back().empty())
+            unfiltered.push_back(i);
+        for (char c : literals.back())
+        {
+            const uint8_t b = c;
+            if (byte_class[b])
+                continue;
+            byte_class[b] = num_classes;
+            byte_class[static_cast<uint8_t>(toaupper(c))] = num_classes;
+            ++num_classes;
+        }
+    }
+
+    // A trie of the literals, with state 0 as its root.
+    transitions.assign(num_classes, -1);
+    found.assign(1, vector<int>());
+    for (size_t i = 0; i < literals.size(); ++i)
+    {
+        if (literals[i].empty())
+            continue;
+        int state = 0;
+        for (char c : literals[i])
+        {
+            const size_t t = state * num_classes
+                             + byte_class[static_cast<uint8_t>(c)];
+            if (transitions[t] < 0)
+            {
+                transitions[t] = found.size();
+                found.emplace_back();
+                transitions.resize(found.size() * num_classes, -1);
+            }
+            state = transitions[t];
+        }
+        found[state].push_back(i);
+    }
+
+    // Add the failure links breadth first, filling in every missing
+    // transition with the one from the longest suffix that's in the trie.
+    vector<int> fail(found.size(), 0);
+    vector<int> queue;
+    for (int cls = 0; cls < num_classes; ++cls)
+    {
+        if (transitions[cls] < 0)
+            transitions[cls] = 0;
+        else
+            queue.push_back(transitions[cls]);
+    }
+    for (size_t q = 0; q < queue.size(); ++q)
+    {
+        const int state = queue[q];
+        // Literals ending at the longest suffix also end here.
+        found[state].insert(found[state].end(), found[fail[state]].begin(),
+                            found[fail[state]].end());
+        for (int cls = 0; cls < num_classes; ++cls)
+        {
+            int &next = transitions[state * num_classes + cls];
+            const int suffix_next = transitions[fail[state] * num_classes
+                                                + cls];
+            if (next < 0)
+                next = suffix_next;
+            else
+            {
+                fail[next] = suffix_next;
+                queue.push_back(next);
+            }
+        }
+    }
+}
+
+// Which patterns could match s: those whose literal it contains, and those
+// without one.
+vector<bool> pattern_set::candidates(const string &s) const
+{
+    if (!compiled)
+        compile();
+
+    vector<bool> maybe(patterns.size(), !_pattern_prefilter);
+    if (!_pattern_prefilter)
+        return maybe;
+
+    for (int i : unfiltered)
+        maybe[i] = true;
+    int state = 0;
+    for (char c : s)
+    {
+        state = transitions[state * num_classes
+                            + byte_class[static_cast<uint8_t>(c)]];
+        for (int i : found[state])
+            maybe[i] = true;
+    }
+    return maybe;
+}
+
+int pattern_set::first_match(const string &s,
+                             const function<bool(size_t)> &wanted) const
+{
+    const vector<bool> maybe = candidates(s);
+    for (size_t i = 0; i < patterns.size(); ++i)
+    {
+        if (maybe[i] && (!wanted || wanted(i)) && patterns[i].matches(s))
+            return i;
+    }
+    return -1;
+}
+
+vector<size_t> pattern_set::matches(const string &s) const
+{
+    const vector<bool> maybe = candidates(s);
+    vector<size_t> matched;
+    for (size_t i = 0; i < patterns.size(); ++i)
+        if (maybe[i] && patterns[i].matches(s))
+            matched.push_back(i);
+    return matched;
+}
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 class pattern_match
 {
 public:
@@ -154,3 +156,71 @@ private:
     string pattern;
     bool ignore_case;
 };
+
+/**
+ * A list of text_patterns matched together, as for an option listing many
+ * regexes. When the set is compiled, the literal text that every match of
+ * each pattern has to contain goes into a single Aho-Corasick automaton. One
+ * pass of that over a string finds the patterns that could match it, and
+ * only those are then tried with the regex library.
+ */
+class pattern_set
+{
+public:
+    pattern_set() : compiled(false), num_classes(0)
+    {
+    }
+
+    void clear();
+    void add(const text_pattern &pattern);
+
+    // Make the set hold the patterns of a list, recompiling it only if they
+    // have changed. get_pattern gives the text_pattern of a list entry.
+    template<typename T, typename F>
+    void update(const vector<T> &list, F get_pattern)
+    {
+        bool same = list.size() == patterns.size();
+        for (size_t i = 0; same && i < list.size(); ++i)
+            same = get_pattern(list[i]) == patterns[i];
+        if (same)
+            return;
+
+        clear();
+        for (const T &entry : list)
+            add(get_pattern(entry));
+    }
+
+    size_t size() const { return patterns.size(); }
+    const text_pattern &operator[](size_t i) const { return patterns[i]; }
+
+    // The index of the first pattern that matches s and (if given) is
+    // wanted, or -1 if there's none.
+    int first_match(const string &s,
+                    const function<bool(size_t)> &wanted = nullptr) const;
+    // The indices of all the patterns that match s, in order.
+    vector<size_t> matches(const string &s) const;
+
+private:
+    void compile() const;
+    vector<bool> candidates(const string &s) const;
+
+    vector<text_pattern> patterns;
+
+    // The automaton, built by compile(). Bytes are mapped to classes, with
+    // both cases of a letter in the same class, and class 0 for the bytes no
+    // literal uses.
+    mutable bool compiled;
+    mutable int num_classes;
+    mutable uint8_t byte_class[256];
+    mutable vector<int> transitions;        // num_classes for each state
+    mutable vector<vector<int>> found;      // literals ending at each state
+    mutable vector<int> unfiltered;         // patterns with no literal
+};
+
+// Lowercased runs of ASCII text that every match of the regex contains,
+// for prefiltering. Empty if none could be found.
+vector<string> regex_required_literals(const string &regex);
+
+// Whether pattern_sets use their automaton, rather than trying every
+// pattern. For benchmarking.
+void set_pattern_prefilter(bool enabled);
@@ -0,0 +1,200 @@
+/**
+ * @file
+ * @brief Pooled, shared storage for the payloads of map_cells.
+ *
+ * A map_cell may remember a monster_info, an item_def and a cloud_info.
+ * These used to be allocated with new every time a cell was updated or
+ * copied, and whole grids of cells are copied for the webtiles view,
+ * packed tiles cells and forgotten maps. Instead, payloads are allocated
+ * from per-type slabs and shared between copies, and only copied again
+ * when a shared one is modified.
+ *
+ * The reference counts aren't atomic: map_cells are only used on the main
+ * thread.
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <new>
+#include <type_traits>
+
+#include "debug.h"
+
+struct payload_pool_stats
+{
+    uint64_t created;   // payloads constructed in a slot
+    uint64_t shared;    // copies that shared an existing payload
+    uint64_t unshared;  // shared payloads copied before being modified
+    uint64_t live;      // payloads currently in use
+    uint64_t slabs;     // heap allocations made by the pool
+};
+
+template <class T> class payload_pool
+{
+public:
+    struct slot
+    {
+        typename std::aligned_storage<sizeof(T), alignof(T)>::type storage;
+        unsigned int refs;
+        slot *next_free;
+
+        T *value() { return reinterpret_cast<T *>(&storage); }
+    };
+
+    static payload_pool &get()
+    {
+        // Deliberately never destroyed: map_cells in other globals may
+        // release their payloads after a static pool would be gone.
+        static payload_pool *pool = new payload_pool;
+        return *pool;
+    }
+
+    slot *create(const T &value)
+    {
+        if (!free_slots)
+            grow();
+        slot *s = free_slots;
+        new (s->value()) T(value);
+        free_slots = s->next_free;
+        s->refs = 1;
+        stats.created++;
+        stats.live++;
+        return s;
+    }
+
+    void release(slot *s)
+    {
+        ASSERT(s->refs > 0);
+        if (--s->refs)
+            return;
+        s->value()->~T();
+        s->next_free = free_slots;
+        free_slots = s;
+        stats.live--;
+    }
+
+    payload_pool_stats stats;
+
+private:
+    payload_pool() : stats(), free_slots(nullptr) { }
+
+    void grow()
+    {
+        // Slabs are never returned; the number of cells with payloads
+        // is bounded by a few copies of the level.
+        slot *slab = new slot[SLAB_SIZE];
+        for (int i = 0; i < SLAB_SIZE - 1; i++)
+            slab[i].next_free = &slab[i + 1];
+        slab[SLAB_SIZE - 1].next_free = free_slots;
+        free_slots = slab;
+        stats.slabs++;
+    }
+
+    static const int SLAB_SIZE = 256;
+    slot *free_slots;
+};
+
+// A copy-on-write handle to a pooled payload.
+template <class T> class pooled_ptr
+{
+    typedef typename payload_pool<T>::slot slot;
+
+public:
+    pooled_ptr() : s(nullptr) { }
+
+    explicit pooled_ptr(const T &value)
+        : s(payload_pool<T>::get().create(value))
+    {
+    }
+
+    pooled_ptr(const pooled_ptr &other) : s(other.s)
+    {
+        if (s)
+        {
+            s->refs++;
+            payload_pool<T>::get().stats.shared++;
+        }
+    }
+
+    pooled_ptr(pooled_ptr &&other) : s(other.s)
+    {
+        other.s = nullptr;
+    }
+
+    pooled_ptr &operator=(const pooled_ptr &other)
+    {
+        if (other.s)
+        {
+            other.s->refs++;
+            payload_pool<T>::get().stats.shared++;
+        }
+        reset();
+        s = other.s;
+        return *this;
+    }
+
+    pooled_ptr &operator=(pooled_ptr &&other)
+    {
+        if (&other != this)
+        {
+            reset();
+            s = other.s;
+            other.s = nullptr;
+        }
+        return *this;
+    }
+
+    ~pooled_ptr()
+    {
+        reset();
+    }
+
+    void reset()
+    {
+        if (s)
+            payload_pool<T>::get().release(s);
+        s = nullptr;
+    }
+
+    const T *get() const
+    {
+        return s ? s->value() : nullptr;
+    }
+
+    const T *operator->() const
+    {
+        return get();
+    }
+
+    // Makes this handle the only owner of its payload before returning it.
+    T *get_mutable()
+    {
+        if (!s)
+            return nullptr;
+        if (s->refs > 1)
+        {
+            payload_pool<T> &pool = payload_pool<T>::get();
+            slot *copy = pool.create(*s->value());
+            pool.release(s);
+            s = copy;
+            pool.stats.unshared++;
+        }
+        return s->value();
+    }
+
+    explicit operator bool() const
+    {
+        return s != nullptr;
+    }
+
+    // Handles sharing a payload are equal; equal copies made separately
+    // are not.
+    bool operator==(const pooled_ptr &other) const
+    {
+        return s == other.s;
+    }
+
+private:
+    slot *s;
+};
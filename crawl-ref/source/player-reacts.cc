@@ -97,6 +97,15 @@
 #include "xom.h"
 #include "zot.h" // bezotting
 
+// Properties looked up every turn, interned so as not to build a string and
+// search you.props for each one.
+static const prop_key melt_armour_key(MELT_ARMOUR_KEY);
+static const prop_key rampage_heal_key(RAMPAGE_HEAL_KEY);
+static const prop_key powered_by_death_key(POWERED_BY_DEATH_KEY);
+static const prop_key heavenly_storm_key(WU_JIAN_HEAVENLY_STORM_KEY);
+static const prop_key blastmote_immune_key(BLASTMOTE_IMMUNE_KEY);
+static const prop_key emergency_flight_key(EMERGENCY_FLIGHT_KEY);
+
 /**
  * Decrement a duration by the given delay.
 
@@ -239,9 +248,9 @@ static void _maybe_melt_armour()
     // We have to do the messaging here, because a simple wand of flame will
     // call _maybe_melt_player_enchantments twice. It also avoids duplicate
     // messages when melting because of several heat sources.
-    if (you.props.exists(MELT_ARMOUR_KEY))
+    if (you.props.exists(melt_armour_key))
     {
-        you.props.erase(MELT_ARMOUR_KEY);
+        you.props.erase(melt_armour_key);
         mprf(MSGCH_DURATION, "The heat melts your icy armour.");
     }
 }
@@ -609,7 +618,7 @@ static void _decrement_transform_duration(int delay)
             || form_can_swim() && feat_is_water(env.grid(you.pos())))
         {
             // Disable emergency flight if it was active
-            you.props.erase(EMERGENCY_FLIGHT_KEY);
+            you.props.erase(emergency_flight_key);
         }
         if (_decrement_a_duration(DUR_TRANSFORMATION, delay, nullptr, random2(3),
                                   "Your transformation is almost over."))
@@ -621,10 +630,10 @@ static void _decrement_transform_duration(int delay)
 
 static void _decrement_rampage_heal_duration(int delay)
 {
-    const int heal = you.props[RAMPAGE_HEAL_KEY].get_int();
+    const int heal = you.props[rampage_heal_key].get_int();
     if (heal > 0 && _decrement_a_duration(DUR_RAMPAGE_HEAL, delay))
     {
-        you.props[RAMPAGE_HEAL_KEY] = heal - 1;
+        you.props[rampage_heal_key] = heal - 1;
         reset_rampage_heal_duration();
     }
 }
@@ -658,7 +667,7 @@ static void _decrement_durations()
     if (you.duration[DUR_STICKY_FLAME])
         dec_sticky_flame_player(delay);
 
-    const bool melted = you.props.exists(MELT_ARMOUR_KEY);
+    const bool melted = you.props.exists(melt_armour_key);
     if (_decrement_a_duration(DUR_ICY_ARMOUR, delay,
                               "Your icy armour evaporates.",
                               melted ? 0 : coinflip(),
@@ -701,10 +710,10 @@ static void _decrement_durations()
     }
 
     // Decrement Powered By Death strength
-    int pbd_str = you.props[POWERED_BY_DEATH_KEY].get_int();
+    int pbd_str = you.props[powered_by_death_key].get_int();
     if (pbd_str > 0 && _decrement_a_duration(DUR_POWERED_BY_DEATH, delay))
     {
-        you.props[POWERED_BY_DEATH_KEY] = pbd_str - 1;
+        you.props[powered_by_death_key] = pbd_str - 1;
         reset_powered_by_death_duration();
     }
 
@@ -779,14 +788,14 @@ static void _decrement_durations()
             else
             {
                 // Disable emergency flight if it was active
-                you.props.erase(EMERGENCY_FLIGHT_KEY);
+                you.props.erase(emergency_flight_key);
             }
         }
         else if ((you.duration[DUR_FLIGHT] -= delay) <= 0)
         {
             // Just time out potions/spells/miscasts.
             you.duration[DUR_FLIGHT] = 0;
-            you.props.erase(EMERGENCY_FLIGHT_KEY);
+            you.props.erase(emergency_flight_key);
         }
     }
 
@@ -884,7 +893,7 @@ static void _decrement_durations()
         you.duration[DUR_SANGUINE_ARMOUR] = 1; // expire
     refresh_meek_bonus();
 
-    if (you.props.exists(WU_JIAN_HEAVENLY_STORM_KEY))
+    if (you.props.exists(heavenly_storm_key))
     {
         ASSERT(you.duration[DUR_HEAVENLY_STORM]);
         wu_jian_heaven_tick();
@@ -907,13 +916,13 @@ static void _decrement_durations()
 
 static void _handle_emergency_flight()
 {
-    ASSERT(you.props[EMERGENCY_FLIGHT_KEY].get_bool());
+    ASSERT(you.props[emergency_flight_key].get_bool());
 
     if (!is_feat_dangerous(orig_terrain(you.pos()), true, false))
     {
         mpr("You float gracefully downwards.");
         land_player();
-        you.props.erase(EMERGENCY_FLIGHT_KEY);
+        you.props.erase(emergency_flight_key);
     }
     else
     {
@@ -1100,8 +1109,8 @@ void player_reacts()
     actor_apply_cloud(&you);
     // Immunity due to just casting Volatile Blastmotes. Only lasts for one
     // turn, so erase it just after we apply clouds for the turn (above).
-    if (you.props.exists(BLASTMOTE_IMMUNE_KEY))
-        you.props.erase(BLASTMOTE_IMMUNE_KEY);
+    if (you.props.exists(blastmote_immune_key))
+        you.props.erase(blastmote_immune_key);
 
     actor_apply_toxic_bog(&you);
 
@@ -1154,7 +1163,7 @@ void player_reacts()
     else if (you_worship(GOD_ASHENZARI))
         ash_scrying();
 
-    if (you.props[EMERGENCY_FLIGHT_KEY].get_bool())
+    if (you.props[emergency_flight_key].get_bool())
         _handle_emergency_flight();
 
     if (you.duration[DUR_PRIMORDIAL_NIGHTFALL])
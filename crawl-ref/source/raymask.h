@@ -0,0 +1,143 @@
+/**
+ * @file
+ * @brief Fixed-width bit mask over the LOS cellrays.
+ *
+ * losight() combines the blocking masks of every opaque cell in a
+ * quadrant, so this is the innermost loop of all LOS calculations. Unlike
+ * bit_vector, ray_mask has a size known at compile time and is cache-line
+ * aligned, so that these operations come down to a few vector
+ * instructions.
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__)
+# include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+# include <emmintrin.h>
+# define RAY_MASK_SSE2
+#endif
+#if defined(_MSC_VER)
+# include <intrin.h>
+#endif
+
+// Enough for all minimal cellrays at LOS_MAX_RANGE 8 (there are 428).
+// los.cc checks this during precomputation.
+#define RAY_MASK_BITS 512
+#define RAY_MASK_WORDS (RAY_MASK_BITS / 64)
+
+static inline int ray_mask_lowest_bit(uint64_t w)
+{
+#if defined(__GNUC__)
+    return __builtin_ctzll(w);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long idx;
+    _BitScanForward64(&idx, w);
+    return idx;
+#else
+    int idx = 0;
+    while (!(w & 1))
+    {
+        w >>= 1;
+        ++idx;
+    }
+    return idx;
+#endif
+}
+
+struct alignas(64) ray_mask
+{
+    uint64_t words[RAY_MASK_WORDS];
+
+    void reset()
+    {
+        memset(words, 0, sizeof(words));
+    }
+
+    bool get(unsigned int i) const
+    {
+        return words[i / 64] & (uint64_t(1) << (i % 64));
+    }
+
+    void set(unsigned int i, bool value = true)
+    {
+        if (value)
+            words[i / 64] |= uint64_t(1) << (i % 64);
+        else
+            words[i / 64] &= ~(uint64_t(1) << (i % 64));
+    }
+
+    // *this |= other
+    void merge(const ray_mask &other)
+    {
+#if defined(__AVX2__)
+        for (int w = 0; w < RAY_MASK_WORDS; w += 4)
+        {
+            __m256i *d = reinterpret_cast<__m256i *>(&words[w]);
+            const __m256i *s =
+                reinterpret_cast<const __m256i *>(&other.words[w]);
+            _mm256_store_si256(d, _mm256_or_si256(_mm256_load_si256(d),
+                                                  _mm256_load_si256(s)));
+        }
+#elif defined(RAY_MASK_SSE2)
+        for (int w = 0; w < RAY_MASK_WORDS; w += 2)
+        {
+            __m128i *d = reinterpret_cast<__m128i *>(&words[w]);
+            const __m128i *s =
+                reinterpret_cast<const __m128i *>(&other.words[w]);
+            _mm_store_si128(d, _mm_or_si128(_mm_load_si128(d),
+                                            _mm_load_si128(s)));
+        }
+#else
+        for (int w = 0; w < RAY_MASK_WORDS; ++w)
+            words[w] |= other.words[w];
+#endif
+    }
+
+    // *this |= a & b
+    void merge_and(const ray_mask &a, const ray_mask &b)
+    {
+#if defined(__AVX2__)
+        for (int w = 0; w < RAY_MASK_WORDS; w += 4)
+        {
+            __m256i *d = reinterpret_cast<__m256i *>(&words[w]);
+            const __m256i x = _mm256_and_si256(
+                _mm256_load_si256(reinterpret_cast<const __m256i *>(&a.words[w])),
+                _mm256_load_si256(reinterpret_cast<const __m256i *>(&b.words[w])));
+            _mm256_store_si256(d, _mm256_or_si256(_mm256_load_si256(d), x));
+        }
+#elif defined(RAY_MASK_SSE2)
+        for (int w = 0; w < RAY_MASK_WORDS; w += 2)
+        {
+            __m128i *d = reinterpret_cast<__m128i *>(&words[w]);
+            const __m128i x = _mm_and_si128(
+                _mm_load_si128(reinterpret_cast<const __m128i *>(&a.words[w])),
+                _mm_load_si128(reinterpret_cast<const __m128i *>(&b.words[w])));
+            _mm_store_si128(d, _mm_or_si128(_mm_load_si128(d), x));
+        }
+#else
+        for (int w = 0; w < RAY_MASK_WORDS; ++w)
+            words[w] |= a.words[w] & b.words[w];
+#endif
+    }
+
+    // Calls f(i) for every i < n whose bit is not set, in increasing order.
+    template<typename F>
+    void for_each_clear(unsigned int n, F f) const
+    {
+        for (unsigned int w = 0; w * 64 < n; ++w)
+        {
+            uint64_t clear = ~words[w];
+            if (n - w * 64 < 64)
+                clear &= (uint64_t(1) << (n - w * 64)) - 1;
+            while (clear)
+            {
+                f(w * 64 + ray_mask_lowest_bit(clear));
+                clear &= clear - 1;
+            }
+        }
+    }
+};
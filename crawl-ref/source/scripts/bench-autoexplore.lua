@@ -0,0 +1,47 @@
+-- Autoexplores a run of seeded levels, with explore flooding the whole
+-- level for each step and with it flooding only as far as it needs to and
+-- keeping its route between steps. Reports how long each took, and checks
+-- that explore took the same number of turns both ways.
+-- Usage: crawl -script bench-autoexplore [<place> ...]
+
+local args = script.simple_args()
+local dungeon = { }
+for depth = 1, 15 do
+  table.insert(dungeon, "D:" .. depth)
+end
+local places = script.place_args(args, 1, dungeon)
+
+local explore_ms = { [false] = 0, [true] = 0 }
+local explore_turns = { [false] = 0, [true] = 0 }
+local differ = 0
+for _, place in ipairs(places) do
+  local turns = { }
+  for _, incremental in ipairs({ false, true }) do
+    debug.incremental_explore(incremental)
+    debug.reset_rng(1)
+    test.regenerate_level(place)
+    local start_turns = you.turns()
+    local start = crawl.millis()
+    debug.test_explore()
+    explore_ms[incremental] = explore_ms[incremental] + crawl.millis()
+                              - start
+    turns[incremental] = you.turns() - start_turns
+    explore_turns[incremental] = explore_turns[incremental]
+                                 + turns[incremental]
+  end
+  if turns[false] ~= turns[true] then
+    crawl.stderr(string.format("%s: %d turns flooding everything, %d "
+                               .. "incrementally", place, turns[false],
+                               turns[true]))
+    differ = differ + 1
+  end
+end
+debug.incremental_explore(true)
+
+for _, incremental in ipairs({ false, true }) do
+  crawl.stderr(string.format("%-11s %d levels: %7d ms, %6d turns",
+                             incremental and "incremental" or "full",
+                             #places, explore_ms[incremental],
+                             explore_turns[incremental]))
+end
+crawl.stderr(string.format("%d levels explored differently", differ))
@@ -0,0 +1,33 @@
+-- Times loading every level of an existing save file, with and without
+-- memory mapping the save. Use a save from a character that has seen a lot
+-- of the dungeon, made by this version of crawl. The save must not be in
+-- use by a running game.
+-- Usage: crawl -script bench-levelload <save file> [<iterations>]
+
+local args = script.simple_args()
+local file = args[1]
+local iters = tonumber(args[2]) or 10
+
+if not file then
+  script.usage("Usage: bench-levelload <save file> [<iterations>]")
+end
+
+-- This also warms up the OS file cache, so that both runs below read from
+-- memory.
+local levels, bytes = debug.load_save_levels(file, true)
+if levels == 0 then
+  script.usage("No loadable levels in " .. file)
+end
+crawl.stderr(string.format("%s: %d levels, %d compressed bytes", file,
+                           levels, bytes))
+
+for _, use_mmap in ipairs({ false, true }) do
+  local start = crawl.millis()
+  for i = 1, iters do
+    debug.load_save_levels(file, use_mmap)
+  end
+  local ms = crawl.millis() - start
+  crawl.stderr(string.format("%-6s %6d ms for %d loads, %.3f ms/level",
+                             use_mmap and "mmap" or "read", ms, iters,
+                             ms / (iters * levels)))
+end
@@ -0,0 +1,44 @@
+-- Times losight() over the debug_los layouts used by test/los_maps.lua.
+-- Usage: crawl -script bench-los [<iterations per map>]
+
+local args = script.simple_args()
+local iters = tonumber(args[1]) or 2000
+
+local function place_los_map(map)
+  dgn.reset_level()
+  dgn.tags(map, "no_rotate no_vmirror no_hmirror no_pool_fixup")
+  local function place_map()
+    return dgn.place_map(map, true, true)
+  end
+  dgn.with_map_anchors(30, 30, place_map)
+  you.moveto(30, 30)
+end
+
+local function bench_los_map(map)
+  place_los_map(map)
+  local visible = 0
+  local start = crawl.millis()
+  for i = 1, iters do
+    -- Look from every cell of the 10x10 test area in turn.
+    local n = i % 100
+    visible = visible + los.losight_count(30 + n % 10, 30 + math.floor(n / 10))
+  end
+  return crawl.millis() - start, visible
+end
+
+local maps, total_ms, total_calls = 0, 0, 0
+local map = dgn.map_by_tag("debug_los")
+assert(map, "Could not find debug-los maps (tag 'debug_los')")
+while map do
+  local ms, visible = bench_los_map(map)
+  crawl.stderr(string.format("%-20s %6d ms (%d cells seen)", dgn.name(map),
+                             ms, visible))
+  maps = maps + 1
+  total_ms = total_ms + ms
+  total_calls = total_calls + iters
+  map = dgn.map_by_tag("debug_los")
+end
+
+crawl.stderr(string.format("%d maps, %d losight calls in %d ms (%.1f us/call)",
+                           maps, total_calls, total_ms,
+                           total_ms * 1000 / math.max(total_calls, 1)))
@@ -0,0 +1,44 @@
+-- Walks the player around some levels, redrawing the view after each
+-- step, and reports how the pooled monsters, items and clouds of the map
+-- knowledge were allocated. Every payload created or shared here used to
+-- be a separate heap allocation; now only the slabs are.
+-- Usage: crawl -script bench-mapcell [<steps per level>] [<place> ...]
+
+local args = script.simple_args()
+local steps = tonumber(args[1]) or 200
+local places = script.place_args(args, 2)
+
+local function walk(place)
+  test.regenerate_level(place)
+  local x, y = you.pos()
+  for i = 1, steps do
+    local dx, dy = crawl.random2(3) - 1, crawl.random2(3) - 1
+    if dgn.is_passable(x + dx, y + dy) then
+      x, y = x + dx, y + dy
+      you.moveto(x, y)
+    end
+    debug.los_changed()
+    debug.viewwindow(false)
+  end
+end
+
+local kinds = { "monster", "item", "cloud" }
+local before = debug.map_cell_pools()
+local start = crawl.millis()
+for _, place in ipairs(places) do
+  walk(place)
+end
+local elapsed = crawl.millis() - start
+local after = debug.map_cell_pools()
+
+crawl.stderr(string.format("%d levels, %d steps each, %d ms", #places, steps,
+                           elapsed))
+for _, kind in ipairs(kinds) do
+  local b, a = before[kind], after[kind]
+  local created = a.created - b.created
+  local shared = a.shared - b.shared
+  crawl.stderr(string.format("%-8s %8d created %8d shared %6d unshared "
+                             .. "%6d live %4d slabs (was %d allocations)",
+                             kind, created, shared, a.unshared - b.unshared,
+                             a.live, a.slabs, created + shared))
+end
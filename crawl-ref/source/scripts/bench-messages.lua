@@ -0,0 +1,75 @@
+-- Checks a corpus of messages against force_more_message,
+-- flash_screen_message and message_colour, trying every pattern of those
+-- options and only the patterns whose literal text is in the message.
+-- Reports how long each took, and checks that they agreed.
+-- Usage: crawl -script bench-messages [<rc file>] [<repeats>]
+-- The rc file is read on top of the default options; a large one shared by
+-- other players makes for a realistic test.
+
+local args = script.simple_args()
+if args[1] then
+  crawl.read_options(args[1])
+end
+local repeats = tonumber(args[2]) or 20
+
+local monsters = {
+  "rat", "goblin", "kobold", "jackal", "orc priest", "ogre", "hydra",
+  "deep elf annihilator", "orb of fire", "Sigmund", "Boris", "Mennas",
+  "ancient lich", "lernaean hydra", "shadow dragon", "giant cockroach",
+  "dancing weapon", "juggernaut", "tengu reaver", "draconian shifter",
+}
+local templates = {
+  "The %s hits you.", "The %s misses you.", "You hit the %s.",
+  "You kill the %s!", "The %s comes into view.", "The %s shouts!",
+  "The %s casts a spell.", "The %s is burned terribly!",
+  "You feel a strange sense of loss.", "The %s picks up a scroll.",
+  "You see here a +2 short sword of %s.", "The %s is out of view.",
+  "You have reached level 12!", "You feel yourself slow down.",
+  "The %s breathes a blast of fire.", "You are engulfed in noxious fumes!",
+  "Your amulet of faith glows.", "The %s is poisoned.",
+  "You feel less protected from missiles.", "There is a stone arch here.",
+}
+local messages = { }
+for _, template in ipairs(templates) do
+  for _, monster in ipairs(monsters) do
+    table.insert(messages, string.format(template, monster))
+  end
+end
+
+local check_ms = { [false] = 0, [true] = 0 }
+local results = { [false] = { }, [true] = { } }
+for _, prefilter in ipairs({ false, true }) do
+  debug.pattern_prefilter(prefilter)
+  local start = crawl.millis()
+  for i = 1, repeats do
+    for j, msg in ipairs(messages) do
+      local more, flash, colour = debug.check_message(msg)
+      if i == 1 then
+        results[prefilter][j] = tostring(more) .. " " .. tostring(flash)
+                                .. " " .. colour
+      end
+    end
+  end
+  check_ms[prefilter] = crawl.millis() - start
+end
+debug.pattern_prefilter(true)
+
+local differ = 0
+for j, msg in ipairs(messages) do
+  if results[false][j] ~= results[true][j] then
+    crawl.stderr(string.format("%s: %s trying every pattern, %s "
+                               .. "prefiltering", msg, results[false][j],
+                               results[true][j]))
+    differ = differ + 1
+  end
+end
+
+local checked = #messages * repeats
+for _, prefilter in ipairs({ false, true }) do
+  local ms = check_ms[prefilter]
+  crawl.stderr(string.format("%-11s %d messages: %6d ms, %8.0f messages/s",
+                             prefilter and "prefilter" or "every",
+                             checked, ms,
+                             ms > 0 and checked * 1000 / ms or 0))
+end
+crawl.stderr(string.format("%d messages matched differently", differ))
@@ -0,0 +1,43 @@
+-- Walks the player around some crowded levels and, after each step, finds
+-- a path to the player for every monster that can move, as they would when
+-- chasing the player. Does this with and without monsters sharing the
+-- search with others heading the same way, and reports how long it took.
+-- Usage: crawl -script bench-pathfind [<steps per level>] [<place> ...]
+
+local args = script.simple_args()
+local steps = tonumber(args[1]) or 100
+local places = script.place_args(args, 2,
+                                { "Orc:2", "Elf:2", "Zot:3", "Vaults:4" })
+
+local function walk(place)
+  test.regenerate_level(place)
+  local x, y = you.pos()
+  local found, tried = 0, 0
+  for i = 1, steps do
+    local dx, dy = crawl.random2(3) - 1, crawl.random2(3) - 1
+    if dgn.is_passable(x + dx, y + dy) then
+      x, y = x + dx, y + dy
+      you.moveto(x, y)
+    end
+    local f, t = debug.path_monsters()
+    found, tried = found + f, tried + t
+  end
+  return found, tried
+end
+
+for _, share in ipairs({ false, true }) do
+  debug.share_paths(share)
+  debug.reset_rng(1)
+  local found, tried = 0, 0
+  local start = crawl.millis()
+  for _, place in ipairs(places) do
+    local f, t = walk(place)
+    found, tried = found + f, tried + t
+  end
+  local elapsed = crawl.millis() - start
+  crawl.stderr(string.format("%-8s %d levels, %d steps each, %6d ms, "
+                             .. "%d of %d paths found",
+                             share and "shared" or "separate", #places, steps,
+                             elapsed, found, tried))
+end
+debug.share_paths(true)
@@ -0,0 +1,47 @@
+-- Walks the player around some levels, redrawing the view after each step
+-- and then a few more times without anything changing, as happens while
+-- messages are shown or the player rests. Does this with and without the
+-- view reusing unchanged cells, and reports how long it took and how many
+-- cells were drawn.
+-- Usage: crawl -script bench-redraw [<steps per level>] [<place> ...]
+
+local args = script.simple_args()
+local steps = tonumber(args[1]) or 200
+local places = script.place_args(args, 2)
+
+local redraws = 4
+
+local function walk(place)
+  test.regenerate_level(place)
+  local x, y = you.pos()
+  for i = 1, steps do
+    local dx, dy = crawl.random2(3) - 1, crawl.random2(3) - 1
+    if dgn.is_passable(x + dx, y + dy) then
+      x, y = x + dx, y + dy
+      you.moveto(x, y)
+    end
+    debug.los_changed()
+    debug.viewwindow(true)
+    for j = 1, redraws do
+      debug.viewwindow(false)
+    end
+  end
+end
+
+for _, incremental in ipairs({ false, true }) do
+  debug.incremental_view(incremental)
+  debug.reset_rng(1)
+  local drawn, reused = debug.redraw_stats()
+  local start = crawl.millis()
+  for _, place in ipairs(places) do
+    walk(place)
+  end
+  local elapsed = crawl.millis() - start
+  local now_drawn, now_reused = debug.redraw_stats()
+  crawl.stderr(string.format("%-11s %d levels, %d steps each, %6d ms, "
+                             .. "%9d cells drawn, %9d reused",
+                             incremental and "incremental" or "full",
+                             #places, steps, elapsed, now_drawn - drawn,
+                             now_reused - reused))
+end
+debug.incremental_view(true)
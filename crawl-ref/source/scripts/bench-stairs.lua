@@ -0,0 +1,52 @@
+-- Autoexplores some seeded levels, then works out the distances between
+-- their stairs, with travel flooding from each stair one square at a time
+-- and a row of squares at a time. Also fills travel distances both ways
+-- from squares all over each explored level and checks that they agree.
+-- Reports how long each took.
+-- Usage: crawl -script bench-stairs [<updates per level>] [<place> ...]
+
+local args = script.simple_args()
+local updates = tonumber(args[1]) or 50
+local places = script.place_args(args, 2)
+local checks = 200
+
+local function random_floor()
+  while true do
+    local x = crawl.random2(dgn.GXM - 2) + 1
+    local y = crawl.random2(dgn.GYM - 2) + 1
+    if dgn.is_passable(x, y) then
+      return x, y
+    end
+  end
+end
+
+local mismatches = 0
+local update_ms = { [false] = 0, [true] = 0 }
+for _, place in ipairs(places) do
+  debug.reset_rng(1)
+  test.regenerate_level(place)
+  debug.test_explore()
+
+  for _, bitboard in ipairs({ false, true }) do
+    debug.bitboard_travel(bitboard)
+    local start = crawl.millis()
+    for i = 1, updates do
+      debug.update_level_info()
+    end
+    update_ms[bitboard] = update_ms[bitboard] + crawl.millis() - start
+  end
+
+  debug.reset_rng(2)
+  for i = 1, checks do
+    mismatches = mismatches + debug.check_travel_flood(random_floor())
+  end
+end
+debug.bitboard_travel(true)
+
+for _, bitboard in ipairs({ false, true }) do
+  crawl.stderr(string.format("%-8s %d levels, %d updates each: %6d ms",
+                             bitboard and "bitboard" or "squares", #places,
+                             updates, update_ms[bitboard]))
+end
+crawl.stderr(string.format("%d squares with different distances over %d "
+                           .. "floods", mismatches, checks * #places))
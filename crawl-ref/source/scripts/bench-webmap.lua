@@ -0,0 +1,77 @@
+-- Compares the full and compact webtiles map formats: generates levels,
+-- walks the player around them recording what the map looks like after
+-- each step, and then encodes the recorded frames in both formats.
+-- Only works in webtiles builds.
+-- Usage: crawl -script bench-webmap [<steps per level>] [<place> ...]
+
+local args = script.simple_args()
+local steps = tonumber(args[1]) or 100
+local places = script.place_args(args, 2)
+
+if not debug.webtiles_record_map then
+  script.usage("bench-webmap needs a webtiles build.")
+end
+
+local function find_start()
+  local x, y = you.pos()
+  if dgn.is_passable(x, y) then
+    return x, y
+  end
+  for y = 1, dgn.GYM - 2 do
+    for x = 1, dgn.GXM - 2 do
+      if dgn.is_passable(x, y) then
+        return x, y
+      end
+    end
+  end
+  error("No passable square on " .. you.where())
+end
+
+local function record_walk(place)
+  test.regenerate_level(place)
+  local x, y = find_start()
+  for i = 1, steps do
+    -- Wander, preferring to keep going the same way.
+    local dx, dy = crawl.random2(3) - 1, crawl.random2(3) - 1
+    for tries = 1, 8 do
+      if (dx ~= 0 or dy ~= 0) and dgn.is_passable(x + dx, y + dy) then
+        break
+      end
+      dx, dy = crawl.random2(3) - 1, crawl.random2(3) - 1
+    end
+    if dgn.is_passable(x + dx, y + dy) then
+      x, y = x + dx, y + dy
+    end
+    you.moveto(x, y)
+    debug.los_changed()
+    debug.viewwindow(false)
+    debug.webtiles_record_map()
+  end
+end
+
+local totals = { }
+for _, format in ipairs({ "full", "compact" }) do
+  totals[format] = { bytes = 0, deflated = 0, usecs = 0 }
+end
+
+for _, place in ipairs(places) do
+  record_walk(place)
+  for _, format in ipairs({ "full", "compact" }) do
+    local msgs, bytes, deflated, usecs =
+      debug.webtiles_bench_map(format == "compact")
+    crawl.stderr(string.format("%-10s %-7s %4d msgs %9d bytes %8d deflated "
+                               .. "%7d us", place, format, msgs, bytes,
+                               deflated, usecs))
+    local t = totals[format]
+    t.bytes = t.bytes + bytes
+    t.deflated = t.deflated + deflated
+    t.usecs = t.usecs + usecs
+  end
+  debug.webtiles_clear_map()
+end
+
+for _, format in ipairs({ "full", "compact" }) do
+  local t = totals[format]
+  crawl.stderr(string.format("%-10s %-7s %9d bytes %8d deflated %7d us",
+                             "total", format, t.bytes, t.deflated, t.usecs))
+end
@@ -0,0 +1,31 @@
+-- Autoexplores some seeded levels, records them for interlevel travel, and
+-- checks that the distances between their stairs come out the same when
+-- worked out from the recorded layout as from the level itself. The
+-- default places have shallow water, and some of their vaults have
+-- transporters.
+-- Usage: crawl -script check-travel-layout [<seeds>] [<place> ...]
+
+local args = script.simple_args()
+local seeds = tonumber(args[1]) or 5
+local places = script.place_args(args, 2,
+                                 { "D:6", "Lair:3", "Swamp:2", "Shoals:3",
+                                   "Snake:2", "Vaults:3", "Depths:3" })
+
+local levels, failed = 0, 0
+for _, place in ipairs(places) do
+  for seed = 1, seeds do
+    debug.reset_rng(seed)
+    test.regenerate_level(place)
+    debug.test_explore()
+    debug.update_level_info()
+    local mismatches = debug.check_layout_distances()
+    if mismatches ~= 0 then
+      crawl.stderr(string.format("%s seed %d: %d stair distances differ",
+                                 place, seed, mismatches))
+      failed = failed + 1
+    end
+    levels = levels + 1
+  end
+end
+crawl.stderr(string.format("%d of %d levels had different stair distances",
+                           failed, levels))
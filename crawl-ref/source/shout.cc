@@ -34,6 +34,7 @@
 #include "religion.h"
 #include "state.h"
 #include "stringutil.h"
+#include "syscalls.h"
 #include "terrain.h"
 #include "view.h"
 #include "viewchar.h"
@@ -918,144 +919,204 @@ static int _noise_attenuation_millis(const coord_def &pos)
                                           1);
 }
 
-noise_cell::noise_cell()
-    : neighbour_delta(0, 0), noise_id(-1), noise_intensity_millis(0),
-      noise_travel_distance(0)
+// Scratch space for noise_grid::wavefront(). Each field has its own dense
+// array rather than there being one struct per cell, and only the cells
+// a noise reached are cleared afterwards. The arrays are left as they are
+// after the last wavefront until the next one, for dump_noise_grid().
+static FixedArray<int, GXM, GYM> _wave_intensity;
+static FixedArray<int, GXM, GYM> _wave_attenuation;
+static FixedArray<int16_t, GXM, GYM> _wave_noise_id;
+static FixedArray<int16_t, GXM, GYM> _wave_distance;
+// The cell the noise came from, as an index into _wave_deltas.
+static FixedArray<uint8_t, GXM, GYM> _wave_from;
+static vector<coord_def> _wave_touched;
+// Cells to spread noise from at the current and next travel distance.
+static vector<coord_def> _wave_buckets[2];
+
+static const coord_def _wave_deltas[] =
 {
-}
+    { -1, -1 }, { -1, 0 }, { -1, 1 },
+    {  0, -1 }, {  0, 0 }, {  0, 1 },
+    {  1, -1 }, {  1, 0 }, {  1, 1 },
+};
+static const uint8_t WAVE_SOURCE = 4;
 
-bool noise_cell::can_apply_noise(int _noise_intensity_millis) const
+// The extra attenuation, in percent, of noise passing through a cell that
+// it entered from the direction from and leaves towards to: nothing if it
+// goes straight on, 25% for a knight's move, 50% for a right angle, 75%
+// for a sharp 45 degree angle and 100% for reversing.
+static int _wave_turn_percent(uint8_t from, uint8_t to)
 {
-    return noise_intensity_millis < _noise_intensity_millis;
+    if (from == WAVE_SOURCE)
+        return 0;
+    const coord_def &in = _wave_deltas[from];
+    const coord_def &out = _wave_deltas[to];
+    if (out == -in)
+        return 100;
+    return (abs(in.x - out.x) + abs(in.y - out.y)) * 25;
 }
 
-bool noise_cell::apply_noise(int _noise_intensity_millis,
-                             int _noise_id,
-                             int _noise_travel_distance,
-                             const coord_def &_neighbour_delta)
+typedef FixedArray<int, ARRAYSZ(_wave_deltas), ARRAYSZ(_wave_deltas)>
+    wave_turn_table;
+
+static wave_turn_table _make_wave_turns()
 {
-    if (can_apply_noise(_noise_intensity_millis))
-    {
-        noise_id = _noise_id;
-        noise_intensity_millis = _noise_intensity_millis;
-        noise_travel_distance = _noise_travel_distance;
-        neighbour_delta = _neighbour_delta;
-        return true;
-    }
-    return false;
+    wave_turn_table turns;
+    for (uint8_t from = 0; from < ARRAYSZ(_wave_deltas); ++from)
+        for (uint8_t to = 0; to < ARRAYSZ(_wave_deltas); ++to)
+            turns[from][to] = _wave_turn_percent(from, to);
+    return turns;
 }
 
-int noise_cell::turn_angle(const coord_def &next_delta) const
+static const wave_turn_table _wave_turns = _make_wave_turns();
+
+// Noise of the given intensity reaches p from the direction from; keep it
+// if it's louder than what's there. Returns whether it was kept.
+static bool _wave_apply(const coord_def &p, int intensity, int16_t noise_id,
+                        int distance, uint8_t from)
 {
-    if (neighbour_delta.origin())
-        return 0;
+    int &cell_intensity = _wave_intensity(p);
+    if (cell_intensity >= intensity)
+        return false;
 
-    // Going in reverse?
-    if (next_delta.x == -neighbour_delta.x
-        && next_delta.y == -neighbour_delta.y)
+    if (!cell_intensity)
     {
-        return 4;
+        _wave_touched.push_back(p);
+        _wave_attenuation(p) = _noise_attenuation_millis(p);
     }
+    cell_intensity = intensity;
+    _wave_noise_id(p) = noise_id;
+    _wave_distance(p) = distance;
+    _wave_from(p) = from;
+    return true;
+}
 
-    const int xdiff = abs(neighbour_delta.x - next_delta.x);
-    const int ydiff = abs(neighbour_delta.y - next_delta.y);
-    return xdiff + ydiff;
+static void _wave_clear()
+{
+    for (const coord_def &p : _wave_touched)
+        _wave_intensity(p) = 0;
+    _wave_touched.clear();
 }
 
 noise_grid::noise_grid()
-    : cells(), noises(), affected_actor_count(0)
+    : noises(), affected_actor_count(0)
 {
 }
 
 void noise_grid::reset()
 {
-    cells.init(noise_cell());
     noises.clear();
     affected_actor_count = 0;
 }
 
 void noise_grid::register_noise(const noise_t &noise)
 {
-    noise_cell &target_cell(cells(noise.noise_source));
-    if (target_cell.can_apply_noise(noise.noise_intensity_millis))
-    {
-        const int noise_index = noises.size();
-        noises.push_back(noise);
-        noises[noise_index].noise_id = noise_index;
-        cells(noise.noise_source).apply_noise(noise.noise_intensity_millis,
-                                              noise_index,
-                                              0,
-                                              coord_def(0, 0));
-    }
+    // Drop noises drowned out by a louder one from the same place.
+    int loudest = 0;
+    for (const noise_t &other : noises)
+        if (other.noise_source == noise.noise_source)
+            loudest = max(loudest, other.noise_intensity_millis);
+    if (noise.noise_intensity_millis <= loudest)
+        return;
+
+    const int noise_index = noises.size();
+    noises.push_back(noise);
+    noises[noise_index].noise_id = noise_index;
 }
 
-void noise_grid::propagate_noise()
+// Spread the noises out one step of travel distance at a time. A cell
+// that a louder noise reaches after it has been spread from is spread
+// from again, and cells are taken in the same order as when each had its
+// own noise_cell, so that monsters hear things in the same order as they
+// always have.
+vector<noise_heard> noise_grid::wavefront() const
 {
-    if (noises.empty())
-        return;
-
-#ifdef DEBUG_NOISE_PROPAGATION
-    dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
-         (unsigned int)noises.size());
-#endif
-    vector<coord_def> noise_perimeter[2];
-    int circ_index = 0;
+    _wave_clear();
+    vector<noise_heard> heard;
 
+    vector<coord_def> *perimeter = &_wave_buckets[0];
+    vector<coord_def> *next_perimeter = &_wave_buckets[1];
+    perimeter->clear();
+    next_perimeter->clear();
     for (const noise_t &noise : noises)
-        noise_perimeter[circ_index].push_back(noise.noise_source);
+    {
+        _wave_apply(noise.noise_source, noise.noise_intensity_millis,
+                    noise.noise_id, 0, WAVE_SOURCE);
+        perimeter->push_back(noise.noise_source);
+    }
 
     int travel_distance = 0;
-    while (!noise_perimeter[circ_index].empty())
+    while (!perimeter->empty())
     {
-        const vector<coord_def> &perimeter(noise_perimeter[circ_index]);
-        vector<coord_def> &next_perimeter(noise_perimeter[!circ_index]);
         ++travel_distance;
-        for (const coord_def &p : perimeter)
+        for (const coord_def &p : *perimeter)
         {
-            const noise_cell &cell(cells(p));
-
-            if (!cell.silent())
+            // Read these afresh, as something else in this perimeter may
+            // have made p louder.
+            const int intensity = _wave_intensity(p);
+            if (!noise_is_audible(intensity))
+                continue;
+
+            const int16_t noise_id = _wave_noise_id(p);
+            heard.push_back({ p, intensity, noise_id, _wave_distance(p) });
+
+            const int attenuation = _wave_attenuation(p);
+            // If the base noise attenuation kills the noise, go no farther:
+            if (!noise_is_audible(intensity - attenuation))
+                continue;
+
+            const uint8_t from = _wave_from(p);
+            for (uint8_t to = 0; to < ARRAYSZ(_wave_deltas); ++to)
             {
-                apply_noise_effects(p,
-                                    cell.noise_intensity_millis,
-                                    noises[cell.noise_id]);
+                if (to == WAVE_SOURCE)
+                    continue;
+                const coord_def next = p + _wave_deltas[to];
+                if (!in_bounds(next)
+                    || _wave_intensity(next) >= intensity - attenuation)
+                {
+                    continue;
+                }
 
-                const int attenuation = _noise_attenuation_millis(p);
-                // If the base noise attenuation kills the noise, go no farther:
-                if (noise_is_audible(cell.noise_intensity_millis - attenuation))
+                const int turn = _wave_turns[from][to];
+                const int next_intensity =
+                    intensity - (turn ? attenuation * (100 + turn) / 100
+                                      : attenuation);
+                if (!noise_is_audible(next_intensity))
+                    continue;
+
+                const int old_distance =
+                    _wave_intensity(next) ? _wave_distance(next) : 0;
+                // Queue it only if it's not queued already, presumably
+                // with a quieter noise.
+                if (_wave_apply(next, next_intensity, noise_id,
+                                travel_distance, to)
+                    && old_distance != travel_distance)
                 {
-                    // [ds] Not using adjacent iterator which has
-                    // unnecessary overhead for the tight loop here.
-                    for (int xi = -1; xi <= 1; ++xi)
-                    {
-                        for (int yi = -1; yi <= 1; ++yi)
-                        {
-                            if (xi || yi)
-                            {
-                                const coord_def next_position(p.x + xi,
-                                                              p.y + yi);
-                                if (in_bounds(next_position))
-                                {
-                                    if (propagate_noise_to_neighbour(
-                                            attenuation,
-                                            travel_distance,
-                                            cell, p,
-                                            next_position))
-                                    {
-                                        next_perimeter.push_back(next_position);
-                                    }
-                                }
-                            }
-                        }
-                    }
+                    next_perimeter->push_back(next);
                 }
             }
         }
 
-        noise_perimeter[circ_index].clear();
-        circ_index = !circ_index;
+        perimeter->clear();
+        swap(perimeter, next_perimeter);
     }
 
+    return heard;
+}
+
+void noise_grid::propagate_noise()
+{
+    if (noises.empty())
+        return;
+
+#ifdef DEBUG_NOISE_PROPAGATION
+    dprf(DIAG_NOISE, "noise_grid: %u noises to apply",
+         (unsigned int)noises.size());
+#endif
+
+    for (const noise_heard &heard : wavefront())
+        apply_noise_effects(heard, noises[heard.noise_id]);
+
 #ifdef DEBUG_NOISE_PROPAGATION
     if (affected_actor_count)
     {
@@ -1066,44 +1127,12 @@ void noise_grid::propagate_noise()
 #endif
 }
 
-bool noise_grid::propagate_noise_to_neighbour(int base_attenuation,
-                                              int travel_distance,
-                                              const noise_cell &cell,
-                                              const coord_def &current_pos,
-                                              const coord_def &next_pos)
-{
-    noise_cell &neighbour(cells(next_pos));
-    if (!neighbour.can_apply_noise(cell.noise_intensity_millis
-                                   - base_attenuation))
-    {
-        return false;
-    }
-
-    const int noise_turn_angle = cell.turn_angle(next_pos - current_pos);
-    const int turn_attenuation =
-        noise_turn_angle? (base_attenuation * (100 + noise_turn_angle * 25)
-                           / 100)
-        : base_attenuation;
-    const int attenuated_noise_intensity =
-        cell.noise_intensity_millis - turn_attenuation;
-    if (noise_is_audible(attenuated_noise_intensity))
-    {
-        const int neighbour_old_distance = neighbour.noise_travel_distance;
-        if (neighbour.apply_noise(attenuated_noise_intensity,
-                                  cell.noise_id,
-                                  travel_distance,
-                                  next_pos - current_pos))
-            // Return true only if we hadn't already registered this
-            // cell as a neighbour (presumably with a lower volume).
-            return neighbour_old_distance != travel_distance;
-    }
-    return false;
-}
-
-void noise_grid::apply_noise_effects(const coord_def &pos,
-                                     int noise_intensity_millis,
+void noise_grid::apply_noise_effects(const noise_heard &heard,
                                      const noise_t &noise)
 {
+    const coord_def &pos = heard.pos;
+    const int noise_intensity_millis = heard.noise_intensity_millis;
+
     // Real noises don't have any effect in silenced squares.
     if (silenced(pos) && !noise.fake_noise)
         return;
@@ -1141,7 +1170,7 @@ void noise_grid::apply_noise_effects(const coord_def &pos,
             && mons->mid != noise.noise_producer_mid)
         {
             const coord_def perceived_position =
-                noise_perceived_position(mons, pos, noise);
+                noise_perceived_position(mons, heard, noise);
             _actor_apply_noise(mons, perceived_position,
                                noise_intensity_millis);
             ++affected_actor_count;
@@ -1172,10 +1201,11 @@ void noise_grid::apply_noise_effects(const coord_def &pos,
 //    will know the exact origin, 100% of the time, even if the
 //    observer is all the way across the level.
 coord_def noise_grid::noise_perceived_position(actor *act,
-                                               const coord_def &affected_pos,
+                                               const noise_heard &heard,
                                                const noise_t &noise) const
 {
-    const int noise_travel_distance = cells(affected_pos).noise_travel_distance;
+    const coord_def &affected_pos = heard.pos;
+    const int noise_travel_distance = heard.noise_travel_distance;
     if (!noise_travel_distance)
         return noise.noise_source;
 
@@ -1288,7 +1318,7 @@ static void _write_noise_grid_css(FILE *outf)
 
 void noise_grid::write_cell(FILE *outf, coord_def p, int ch) const
 {
-    const int intensity = min(25, cells(p).noise_intensity_millis / 1000);
+    const int intensity = min(25, _wave_intensity(p) / 1000);
     if (intensity)
         fprintf(outf, "<span class='i%d'>&#%d;</span>", intensity, ch);
     else
@@ -1340,14 +1370,12 @@ static void _actor_apply_noise(actor *act,
 {
 #ifdef DEBUG_NOISE_PROPAGATION
     dprf(DIAG_NOISE, "[NOISE] Actor %s (%d,%d) perceives noise (%d) "
-         "from (%d,%d), real source (%d,%d), distance: %d, noise travelled: %d",
+         "from (%d,%d), distance: %d",
          act->name(DESC_PLAIN, true).c_str(),
          act->pos().x, act->pos().y,
          noise_intensity_millis,
          apparent_source.x, apparent_source.y,
-         noise.noise_source.x, noise.noise_source.y,
-         grid_distance(act->pos(), noise.noise_source),
-         noise_travel_distance);
+         grid_distance(act->pos(), apparent_source));
 #endif
 
     const bool player = act->is_player();
@@ -718,6 +718,20 @@ bool LevelStashes::needs_visit(const coord_def& c, bool autopickup) const
     return shop_needs_visit(c);
 }
 
+void LevelStashes::mark_visit_squares(map_bitmask &squares,
+                                      bool autopickup) const
+{
+    for (const auto &entry : m_stashes)
+    {
+        const Stash &s = entry.second;
+        if (s.unvisited() || autopickup && s.pickup_eligible())
+            squares.set(entry.first);
+    }
+    for (const ShopInfo &shop : m_shops)
+        if (shop_needs_visit(shop.shop.pos))
+            squares.set(shop.shop.pos);
+}
+
 bool LevelStashes::needs_stop(const coord_def &c) const
 {
     const Stash *s = find_stash(c);
@@ -192,6 +192,8 @@ public:
     // swag that merits a personal visit (for EXPLORE_GREEDY).
     bool  needs_visit(const coord_def& c, bool autopickup) const;
     bool  shop_needs_visit(const coord_def& c) const;
+    // Sets the squares where needs_visit() is true.
+    void  mark_visit_squares(map_bitmask &squares, bool autopickup) const;
 
     // Returns true if the items at c are not fully known to the stash-tracker
     // and the items are not all handled by autopickup.
@@ -42,8 +42,10 @@ game_state::game_state()
       obj_stat_gen(false), type(GAME_TYPE_NORMAL),
       last_type(GAME_TYPE_UNSPECIFIED), last_game_exit(game_exit::unknown),
       marked_as_won(false), arena_suspended(false),
-      generating_level(false), dump_maps(false), test(false), script(false),
-      build_db(false), use_des_cache(true), tests_selected(),
+      generating_level(false), dump_maps(false), arena_bench(0), test(false),
+      script(false),
+      build_db(false), build_des(false), build_des_jobs(0),
+      use_des_cache(true), tests_selected(),
 #ifdef DGAMELAUNCH
       throttle(true),
       bypassed_startup_menu(true),
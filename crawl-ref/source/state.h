@@ -82,10 +82,13 @@ struct game_state
     bool generating_level;
 
     bool dump_maps;         // Dump map Lua to stderr on fresh parse.
+    int arena_bench;        // Number of fights to run for -arena-bench.
     bool test;              // Set if we want to run self-tests and exit.
     bool test_list;         // Show available tests and exit.
     bool script;            // Set if we want to run a Lua script and exit.
     bool build_db;          // Set if we want to rebuild the db and exit.
+    bool build_des;         // Set to precompile des files in parallel.
+    int build_des_jobs;     // Worker processes for -builddes (0: per CPU).
     bool use_des_cache;
     vector<string> tests_selected; // Tests to be run.
     vector<string> script_args;    // Arguments to scripts.
@@ -1262,6 +1262,15 @@ static map<string, int> accesses;
 //////////////////
 // Misc functions
 
+prop_key::prop_key(const char *name)
+{
+    // Never destroyed, since prop_keys are statics all over the place.
+    static map<string, unsigned int> &ids = *new map<string, unsigned int>;
+    auto entry = ids.emplace(name, ids.size() + 1).first;
+    _name = &entry->first;
+    _id = entry->second;
+}
+
 bool CrawlHashTable::exists(const string &key) const
 {
     ACCESS(key);
@@ -1269,6 +1278,105 @@ bool CrawlHashTable::exists(const string &key) const
     return find(key) != end();
 }
 
+bool CrawlHashTable::exists(const prop_key &key) const
+{
+    ACCESS(key.name());
+    ASSERT_VALIDITY();
+    return find_interned(key) != end();
+}
+
+size_t CrawlHashTable::erase(const string &key)
+{
+    auto iter = map::find(key);
+    if (iter == end())
+        return 0;
+    erase(iter);
+    return 1;
+}
+
+size_t CrawlHashTable::erase(const prop_key &key)
+{
+    auto iter = find_interned(key);
+    if (iter == end())
+        return 0;
+    erase(iter);
+    return 1;
+}
+
+CrawlHashTable::iterator CrawlHashTable::erase(iterator pos)
+{
+    forget_interned(pos);
+    return map::erase(pos);
+}
+
+void CrawlHashTable::clear()
+{
+    map::clear();
+    lookups.reset();
+}
+
+CrawlHashTable::iterator CrawlHashTable::find_interned(const prop_key &key)
+    const
+{
+    // The lookups are only a cache, so using them doesn't change the table.
+    CrawlHashTable &self = const_cast<CrawlHashTable &>(*this);
+    vector<interned_lookup> &slots = lookups.slots;
+
+    if (lookups.used * 2 >= slots.size())
+    {
+        vector<interned_lookup> old;
+        old.swap(slots);
+        slots.resize(max<size_t>(8, old.size() * 2), { 0, 0, self.end() });
+        for (const interned_lookup &lookup : old)
+        {
+            if (!lookup.key)
+                continue;
+            size_t i = (lookup.key * 2654435761U) & (slots.size() - 1);
+            while (slots[i].key)
+                i = (i + 1) & (slots.size() - 1);
+            slots[i] = lookup;
+        }
+    }
+
+    size_t i = (key.id() * 2654435761U) & (slots.size() - 1);
+    while (slots[i].key && slots[i].key != key.id())
+        i = (i + 1) & (slots.size() - 1);
+
+    interned_lookup &lookup = slots[i];
+    if (lookup.key == key.id()
+        && (lookup.pos != self.end() || lookup.inserts == lookups.inserts))
+    {
+        return lookup.pos;
+    }
+
+    if (!lookup.key)
+    {
+        lookup.key = key.id();
+        lookups.used++;
+    }
+    lookup.pos = self.map::find(key.name());
+    lookup.inserts = lookups.inserts;
+    return lookup.pos;
+}
+
+void CrawlHashTable::forget_interned(iterator pos)
+{
+    for (interned_lookup &lookup : lookups.slots)
+    {
+        if (lookup.key && lookup.pos == pos)
+        {
+            lookup.pos = end();
+            lookup.inserts = lookups.inserts;
+        }
+    }
+}
+
+void CrawlHashTable::inserted()
+{
+    // Keys remembered as missing might not be any more.
+    lookups.inserts++;
+}
+
 void CrawlHashTable::assert_validity() const
 {
 #ifdef DEBUG
@@ -1338,7 +1446,25 @@ CrawlStoreValue& CrawlHashTable::get_value(const string &key)
     ASSERT_VALIDITY();
     ACCESS(key);
     // Inserts CrawlStoreValue() if the key was not found.
-    return map::operator[](key);
+    const size_t old_size = size();
+    CrawlStoreValue &val = map::operator[](key);
+    if (size() != old_size)
+        inserted();
+    return val;
+}
+
+CrawlStoreValue& CrawlHashTable::get_value(const prop_key &key)
+{
+    ASSERT_VALIDITY();
+    ACCESS(key.name());
+    auto iter = find_interned(key);
+    if (iter == end())
+    {
+        map::operator[](key.name());
+        inserted();
+        iter = find_interned(key);
+    }
+    return iter->second;
 }
 
 const CrawlStoreValue& CrawlHashTable::get_value(const string &key) const
@@ -1355,6 +1481,21 @@ const CrawlStoreValue& CrawlHashTable::get_value(const string &key) const
     return store;
 }
 
+const CrawlStoreValue& CrawlHashTable::get_value(const prop_key &key) const
+{
+    ASSERT_VALIDITY();
+    ACCESS(key.name());
+    auto iter = find_interned(key);
+    ASSERTM(iter != end(), "trying to read non-existent property \"%s\"",
+            key.name().c_str());
+
+    const CrawlStoreValue& store = iter->second;
+    ASSERT(store.type != SV_NONE);
+    ASSERT(!(store.flags & SFLAG_UNSET));
+
+    return store;
+}
+
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
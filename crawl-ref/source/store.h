@@ -241,15 +241,45 @@ protected:
     friend class CrawlVector;
 };
 
-class CrawlHashTable : public map<string, CrawlStoreValue>
+// An interned property key, for looking up the same property over and over.
+// Constructing one looks up its id once; use them as statics, e.g.
+//     static const prop_key melt_armour_key(MELT_ARMOUR_KEY);
+//     if (you.props.exists(melt_armour_key))
+// Lookups with one skip building a string, and a table remembers where each
+// interned key was found, so repeated lookups don't walk the tree either.
+class prop_key
+{
+public:
+    explicit prop_key(const char *name);
+
+    const string &name() const { return *_name; }
+    unsigned int id() const { return _id; }
+
+private:
+    const string *_name;
+    unsigned int _id;
+};
+
+class CrawlHashTable : private map<string, CrawlStoreValue>
 {
 public:
     friend class CrawlStoreValue;
 
+    using map::iterator;
+    using map::const_iterator;
+    using map::value_type;
+    using map::begin;
+    using map::end;
+    using map::empty;
+    using map::size;
+    using map::find;
+    using map::count;
+
     void write(writer &) const;
     void read(reader &);
 
     bool exists(const string &key) const;
+    bool exists(const prop_key &key) const;
 
     void assert_validity() const;
 
@@ -258,10 +288,13 @@ public:
     const CrawlStoreValue& get_value(const string &key) const;
     const CrawlStoreValue& get_value(const char *key) const
     { return get_value(string(key)); }
+    const CrawlStoreValue& get_value(const prop_key &key) const;
     const CrawlStoreValue& operator[] (const string &key) const
     { return get_value(key); }
     const CrawlStoreValue& operator[] (const char *key) const
     { return get_value(string(key)); }
+    const CrawlStoreValue& operator[] (const prop_key &key) const
+    { return get_value(key); }
 
     // NOTE: If get_value() or [] is given a key which doesn't exist
     // in the table, an unset/empty CrawlStoreValue will be created
@@ -273,9 +306,69 @@ public:
     CrawlStoreValue& get_value(const string &key);
     CrawlStoreValue& get_value(const char *key)
     { return get_value(string(key)); }
-    using map::operator[];
+    CrawlStoreValue& get_value(const prop_key &key);
+    CrawlStoreValue& operator[] (const string &key)
+    { return get_value(key); }
     CrawlStoreValue& operator[] (const char *key)
     { return get_value(string(key)); }
+    CrawlStoreValue& operator[] (const prop_key &key)
+    { return get_value(key); }
+
+    size_t erase(const string &key);
+    size_t erase(const prop_key &key);
+    iterator erase(iterator pos);
+    void clear();
+
+private:
+    iterator find_interned(const prop_key &key) const;
+    void forget_interned(iterator pos);
+    void inserted();
+
+    // Where interned keys were found: an open-addressing table from key id
+    // to the key's entry, or to end() if it was missing. Entries stay put
+    // until erased, so found keys stay valid until erase() forgets them;
+    // missing keys are only trusted until the next insertion. Copies start
+    // out empty, since the iterators belong to the original.
+    struct interned_lookup
+    {
+        unsigned int key;       // 0 if the slot is unused
+        unsigned int inserts;   // the insertion count when it was missing
+        iterator     pos;
+    };
+
+    class interned_lookups
+    {
+    public:
+        interned_lookups() : used(0), inserts(0) { }
+        interned_lookups(const interned_lookups &) : used(0), inserts(0) { }
+        interned_lookups(interned_lookups &&other) : used(0), inserts(0)
+        {
+            other.reset();
+        }
+        interned_lookups &operator=(const interned_lookups &)
+        {
+            reset();
+            return *this;
+        }
+        interned_lookups &operator=(interned_lookups &&other)
+        {
+            reset();
+            other.reset();
+            return *this;
+        }
+
+        void reset()
+        {
+            slots.clear();
+            used = 0;
+        }
+
+        vector<interned_lookup> slots;
+        unsigned int used;
+        unsigned int inserts;
+    };
+
+    mutable interned_lookups lookups;
 };
 
 // A CrawlVector is the vector version of CrawlHashTable, except that
@@ -117,7 +117,7 @@ extern set<pair<string, level_id> > auto_unique_annotations;
 extern abyss_state abyssal_state;
 
 reader::reader(const string &_read_filename, int minorVersion)
-    : _filename(_read_filename), _chunk(0), _pbuf(nullptr), _read_offset(0),
+    : _filename(_read_filename), _pos(nullptr), _end(nullptr),
       _minorVersion(minorVersion), _safe_read(false)
 {
     _file       = fopen_u(_filename.c_str(), "rb");
@@ -125,17 +125,18 @@ reader::reader(const string &_read_filename, int minorVersion)
 }
 
 reader::reader(package *save, const string &chunkname, int minorVersion)
-    : _file(0), _chunk(0), opened_file(false), _pbuf(0), _read_offset(0),
-     _minorVersion(minorVersion), _safe_read(false)
+    : _file(0), opened_file(false), _minorVersion(minorVersion),
+      _safe_read(false)
 {
     ASSERT(save);
-    _chunk = new chunk_reader(save, chunkname);
+    chunk_reader inf(save, chunkname);
+    inf.read_all(_inflated);
+    _pos = _inflated.data();
+    _end = _pos + _inflated.size();
 }
 
 reader::~reader()
 {
-    if (_chunk)
-        delete _chunk;
     close();
 }
 
@@ -160,8 +161,7 @@ void reader::advance(size_t offset)
 
 bool reader::valid() const
 {
-    return (_file && !feof(_file)) ||
-           (_pbuf && _read_offset < _pbuf->size());
+    return (_file && !feof(_file)) || _pos < _end;
 }
 
 static NORETURN void _short_read(bool safe_read)
@@ -173,29 +173,16 @@ static NORETURN void _short_read(bool safe_read)
     die_noline("short read while reading save");
 }
 
-// Reads input in network byte order, from a file or buffer.
-unsigned char reader::readByte()
+// readByte() when reading from a file, or past the end of the buffer.
+unsigned char reader::read_byte_slow()
 {
-    if (_file)
-    {
-        int b = fgetc(_file);
-        if (b == EOF)
-            _short_read(_safe_read);
-        return b;
-    }
-    else if (_chunk)
-    {
-        unsigned char buf;
-        if (_chunk->read(&buf, 1) != 1)
-            _short_read(_safe_read);
-        return buf;
-    }
-    else
-    {
-        if (_read_offset >= _pbuf->size())
-            _short_read(_safe_read);
-        return (*_pbuf)[_read_offset++];
-    }
+    if (!_file)
+        _short_read(_safe_read);
+
+    int b = fgetc(_file);
+    if (b == EOF)
+        _short_read(_safe_read);
+    return b;
 }
 
 void reader::read(void *data, size_t size)
@@ -210,19 +197,14 @@ void reader::read(void *data, size_t size)
         else
             fseek(_file, (long)size, SEEK_CUR);
     }
-    else if (_chunk)
-    {
-        if (_chunk->read(data, size) != size)
-            _short_read(_safe_read);
-    }
     else
     {
-        if (_read_offset+size > _pbuf->size())
+        if ((size_t)(_end - _pos) < size)
             _short_read(_safe_read);
         if (data && size)
-            memcpy(data, &(*_pbuf)[_read_offset], size);
+            memcpy(data, _pos, size);
 
-        _read_offset += size;
+        _pos += size;
     }
 }
 
@@ -239,10 +221,7 @@ void reader::setMinorVersion(int minorVersion)
 
 void reader::fail_if_not_eof(const string &name)
 {
-    char dummy;
-    if (_chunk ? _chunk->read(&dummy, 1) :
-        _file ? (fgetc(_file) != EOF) :
-        _read_offset >= _pbuf->size())
+    if (_file ? fgetc(_file) != EOF : _pos < _end)
     {
         fail("Incomplete read of \"%s\" - aborting.", name.c_str());
     }
@@ -6027,7 +6006,7 @@ void marshallMapCell(writer &th, const map_cell &cell)
 
     if (flags & MAP_SERIALIZE_CLOUD)
     {
-        cloud_info* ci = cell.cloudinfo();
+        const cloud_info* ci = cell.cloudinfo();
         marshallUnsigned(th, ci->type);
         marshallUnsigned(th, ci->colour);
         marshallUnsigned(th, ci->duration);
@@ -6230,8 +6209,8 @@ void marshallMonster(writer &th, const monster& m)
     marshallUnsigned(th, m.flags.flags);
 
     marshallShort(th, m.enchantments.size());
-    for (const auto &entry : m.enchantments)
-        marshall_mon_enchant(th, entry.second);
+    for (const mon_enchant &me : m.enchantments)
+        marshall_mon_enchant(th, me);
     marshallByte(th, m.ench_countdown);
 
     marshallShort(th, min(m.hit_points, MAX_MONSTER_HP));
@@ -6770,9 +6749,15 @@ static void _tag_read_level(reader &th)
             unmarshallMapCell(th, env.map_knowledge[i][j]);
             // Fixup positions
             if (env.map_knowledge[i][j].monsterinfo())
-                env.map_knowledge[i][j].monsterinfo()->pos = coord_def(i, j);
+            {
+                env.map_knowledge[i][j].mutable_monsterinfo()->pos
+                    = coord_def(i, j);
+            }
             if (env.map_knowledge[i][j].cloudinfo())
-                env.map_knowledge[i][j].cloudinfo()->pos = coord_def(i, j);
+            {
+                env.map_knowledge[i][j].mutable_cloudinfo()->pos
+                    = coord_def(i, j);
+            }
 
             env.map_knowledge[i][j].flags &= ~MAP_VISIBLE_FLAG;
             if (env.map_knowledge[i][j].seen())
@@ -7191,8 +7176,7 @@ void unmarshallMonster(reader &th, monster& m)
     for (int i = 0; i < nenchs; ++i)
     {
         mon_enchant me = unmarshall_mon_enchant(th);
-        m.enchantments[me.ench] = me;
-        m.ench_cache.set(me.ench, true);
+        m.enchantments.insert(me);
     }
     m.ench_countdown = unmarshallByte(th);
 
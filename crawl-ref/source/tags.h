@@ -115,17 +115,24 @@ class reader
 public:
     reader(const string &filename, int minorVersion = TAG_MINOR_INVALID);
     reader(FILE* input, int minorVersion = TAG_MINOR_INVALID)
-        : _file(input), _chunk(0), opened_file(false), _pbuf(0),
-          _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
+        : _file(input), opened_file(false), _pos(nullptr), _end(nullptr),
+          _minorVersion(minorVersion), _safe_read(false) {}
     reader(const vector<unsigned char>& input,
            int minorVersion = TAG_MINOR_INVALID)
-        : _file(0), _chunk(0), opened_file(false), _pbuf(&input),
-          _read_offset(0), _minorVersion(minorVersion), _safe_read(false) {}
+        : _file(0), opened_file(false), _pos(input.data()),
+          _end(input.data() + input.size()), _minorVersion(minorVersion),
+          _safe_read(false) {}
     reader(package *save, const string &chunkname,
            int minorVersion = TAG_MINOR_INVALID);
     ~reader();
 
-    unsigned char readByte();
+    // Reads input in network byte order, from a file or buffer.
+    unsigned char readByte()
+    {
+        if (_pos < _end)
+            return *_pos++;
+        return read_byte_slow();
+    }
     void read(void *data, size_t size);
     void advance(size_t size);
     int getMinorVersion() const;
@@ -139,12 +146,15 @@ public:
     void set_safe_read(bool setting) { _safe_read = setting; }
 
 private:
+    unsigned char read_byte_slow();
+
     string _filename;
     FILE* _file;
-    chunk_reader *_chunk;
     bool  opened_file;
-    const vector<unsigned char>* _pbuf;
-    unsigned int _read_offset;
+    // Unread part of the buffer, when not reading from a file. Package
+    // chunks are inflated in one go into _inflated and read from there.
+    const unsigned char *_pos, *_end;
+    vector<unsigned char> _inflated;
     int _minorVersion;
     // always throw an exception rather than dying when reading past EOF
     bool _safe_read;
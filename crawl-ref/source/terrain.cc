@@ -36,6 +36,7 @@
 #include "mapmark.h"
 #include "message.h"
 #include "mon-behv.h"
+#include "mon-pathfind.h"
 #include "mon-place.h"
 #include "mon-poly.h"
 #include "mon-util.h"
@@ -1960,6 +1961,9 @@ const char* feat_type_name(dungeon_feature_type feat)
 
 void set_terrain_changed(const coord_def p)
 {
+    view_mark_dirty(p);
+    forget_shared_paths();
+
     if (cell_is_solid(p))
         delete_cloud(p);
 
@@ -0,0 +1,30 @@
+-----------------------------------------------------------------------
+-- Encodes a short walk as webtiles map messages in both the full and
+-- the compact map format. Only does anything in webtiles builds.
+-----------------------------------------------------------------------
+
+if debug.webtiles_record_map then
+  local steps = 20
+
+  test.regenerate_level("D:1")
+  local x, y = you.pos()
+  for i = 1, steps do
+    local dx, dy = crawl.random2(3) - 1, crawl.random2(3) - 1
+    if dgn.is_passable(x + dx, y + dy) then
+      x, y = x + dx, y + dy
+    end
+    you.moveto(x, y)
+    debug.los_changed()
+    debug.viewwindow(false)
+    debug.webtiles_record_map()
+  end
+
+  for _, compact in ipairs({ false, true }) do
+    local msgs, bytes = debug.webtiles_bench_map(compact)
+    local format = compact and "compact" or "full"
+    assert(msgs == steps, "Encoded " .. msgs .. " " .. format
+                          .. " map messages, expected " .. steps)
+    assert(bytes > 0, "Empty " .. format .. " map messages")
+  end
+  debug.webtiles_clear_map()
+end
@@ -0,0 +1,455 @@
+/**
+ * @file
+ * @brief Compiled, read-only files for the text databases.
+**/
+
+#include "AppHdr.h"
+
+#include "textdb.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
+#include <unistd.h>
+#endif
+#ifdef UNIX
+#include <sys/mman.h>
+#endif
+
+#include "pattern.h"
+#include "stringutil.h"
+#include "syscalls.h"
+
+// These files are a per-install cache, so they are written in native byte
+// order. A file from a machine with the other byte order fails the magic
+// check and is regenerated.
+#define TEXTDB_MAGIC   0x42445443 /* "CTDB" */
+#define TEXTDB_VERSION 1
+
+#define NO_ENTRY 0xffffffff
+
+// All offsets are from the start of the file. Tables are arrays of
+// uint32_t.
+struct textdb_header
+{
+    uint32_t magic;
+    uint32_t version;
+    uint32_t entries;
+    uint32_t buckets;
+    uint32_t trigrams;
+    // [buckets]: hash seed for the keys in each bucket.
+    uint32_t displacement_off;
+    // [entries]: entry for each hash slot.
+    uint32_t slot_off;
+    // [entries][4]: key offset, key length, body offset, body length.
+    uint32_t entry_off;
+    // [trigrams][3]: trigram, first posting, number of postings.
+    uint32_t trigram_off;
+    // Entry numbers, in increasing order for each trigram.
+    uint32_t posting_off;
+    uint32_t postings;
+    uint32_t timestamp_off;
+    uint32_t timestamp_len;
+};
+
+// FNV-1a, with a final mix so that different seeds give unrelated values.
+static uint32_t _hash(const char *s, size_t len, uint32_t seed)
+{
+    uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+    for (size_t i = 0; i < len; i++)
+    {
+        h ^= (unsigned char)s[i];
+        h *= 16777619u;
+    }
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35u;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t _trigram(const string &s, size_t at)
+{
+    return (unsigned char)s[at] << 16 | (unsigned char)s[at + 1] << 8
+           | (unsigned char)s[at + 2];
+}
+
+textdb_file::textdb_file()
+    : data(nullptr), len(0), mapped(false), head(nullptr)
+{
+}
+
+textdb_file::~textdb_file()
+{
+    close();
+}
+
+void textdb_file::close()
+{
+#ifdef UNIX
+    if (mapped)
+        munmap((void *)data, len);
+    else
+#endif
+        delete[] data;
+    data = nullptr;
+    len = 0;
+    mapped = false;
+    head = nullptr;
+}
+
+bool textdb_file::open(const string &filename)
+{
+    close();
+
+    const int fd = open_u(filename.c_str(), O_RDONLY | O_BINARY, 0);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) || st.st_size < (off_t)sizeof(textdb_header))
+    {
+        ::close(fd);
+        return false;
+    }
+    len = st.st_size;
+
+#ifdef UNIX
+    void *m = mmap(nullptr, len, PROT_READ, MAP_SHARED, fd, 0);
+    if (m != MAP_FAILED)
+    {
+        data = (const char *)m;
+        mapped = true;
+    }
+    else
+#endif
+    {
+        char *buf = new char[len];
+        size_t got = 0;
+        while (got < len)
+        {
+            const ssize_t r = ::read(fd, buf + got, len - got);
+            if (r <= 0)
+                break;
+            got += r;
+        }
+        data = buf;
+        if (got != len)
+        {
+            ::close(fd);
+            close();
+            return false;
+        }
+    }
+    ::close(fd);
+
+    head = (const textdb_header *)data;
+    const uint64_t n = head->entries;
+    auto fits = [&](uint64_t off, uint64_t bytes)
+    {
+        return off % sizeof(uint32_t) == 0 && off + bytes <= len;
+    };
+    if (head->magic != TEXTDB_MAGIC || head->version != TEXTDB_VERSION
+        || !head->buckets
+        || !fits(head->displacement_off, head->buckets * 4ull)
+        || !fits(head->slot_off, n * 4)
+        || !fits(head->entry_off, n * 16)
+        || !fits(head->trigram_off, head->trigrams * 12ull)
+        || !fits(head->posting_off, head->postings * 4ull)
+        || (uint64_t)head->timestamp_off + head->timestamp_len > len)
+    {
+        close();
+        return false;
+    }
+
+    // Check the entries, so that lookups don't have to.
+    const uint32_t *entry = table(head->entry_off);
+    for (uint64_t i = 0; i < n * 4; i += 2)
+        if ((uint64_t)entry[i] + entry[i + 1] > len)
+        {
+            close();
+            return false;
+        }
+    const uint32_t *trigram = table(head->trigram_off);
+    for (uint64_t i = 0; i < head->trigrams * 3ull; i += 3)
+        if ((uint64_t)trigram[i + 1] + trigram[i + 2] > head->postings)
+        {
+            close();
+            return false;
+        }
+
+    return true;
+}
+
+const uint32_t *textdb_file::table(uint32_t offset) const
+{
+    return (const uint32_t *)(data + offset);
+}
+
+string textdb_file::text(uint32_t offset, uint32_t length) const
+{
+    return string(data + offset, length);
+}
+
+string textdb_file::timestamp() const
+{
+    return head ? text(head->timestamp_off, head->timestamp_len) : "";
+}
+
+unsigned int textdb_file::size() const
+{
+    return head ? head->entries : 0;
+}
+
+string textdb_file::key(unsigned int entry) const
+{
+    ASSERT(entry < size());
+    const uint32_t *e = table(head->entry_off) + entry * 4;
+    return text(e[0], e[1]);
+}
+
+string textdb_file::body(unsigned int entry) const
+{
+    ASSERT(entry < size());
+    const uint32_t *e = table(head->entry_off) + entry * 4;
+    return text(e[2], e[3]);
+}
+
+string textdb_file::find(const string &key) const
+{
+    if (!head || !head->entries)
+        return "";
+
+    const uint32_t bucket =
+        _hash(key.data(), key.size(), 0) % head->buckets;
+    const uint32_t seed = table(head->displacement_off)[bucket];
+    const uint32_t slot =
+        _hash(key.data(), key.size(), seed) % head->entries;
+    const uint32_t entry = table(head->slot_off)[slot];
+    if (entry >= head->entries)
+        return "";
+
+    // Keys that aren't in the database still hash to some slot.
+    const uint32_t *e = table(head->entry_off) + entry * 4;
+    if (e[1] != key.size() || memcmp(data + e[0], key.data(), key.size()))
+        return "";
+    return text(e[2], e[3]);
+}
+
+vector<unsigned int> textdb_file::candidates(const string &regex) const
+{
+    vector<unsigned int> result;
+    if (!head)
+        return result;
+
+    const uint32_t *trigrams = table(head->trigram_off);
+    const uint32_t *postings = table(head->posting_off);
+    bool narrowed = false;
+    for (const string &run : regex_required_literals(regex))
+    {
+        for (size_t i = 0; i + 2 < run.size(); i++)
+        {
+            const uint32_t want = _trigram(run, i);
+            uint32_t lo = 0, hi = head->trigrams;
+            while (lo < hi)
+            {
+                const uint32_t mid = lo + (hi - lo) / 2;
+                if (trigrams[mid * 3] < want)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            if (lo == head->trigrams || trigrams[lo * 3] != want)
+                return vector<unsigned int>();
+
+            const uint32_t *first = postings + trigrams[lo * 3 + 1];
+            const uint32_t *last = first + trigrams[lo * 3 + 2];
+            if (!narrowed)
+                result.assign(first, last);
+            else
+            {
+                vector<unsigned int> both;
+                set_intersection(result.begin(), result.end(), first, last,
+                                 back_inserter(both));
+                result.swap(both);
+            }
+            narrowed = true;
+            if (result.empty())
+                return result;
+        }
+    }
+
+    if (!narrowed)
+    {
+        result.resize(head->entries);
+        for (unsigned int i = 0; i < result.size(); i++)
+            result[i] = i;
+    }
+    else
+    {
+        result.erase(remove_if(result.begin(), result.end(),
+                               [this](unsigned int e)
+                               { return e >= head->entries; }),
+                     result.end());
+    }
+    return result;
+}
+
+// Finds a seed for each bucket of keys that sends them all to empty slots.
+static bool _perfect_hash(const vector<const string *> &keys,
+                          vector<uint32_t> &displacements,
+                          vector<uint32_t> &slots)
+{
+    const uint32_t n = keys.size();
+    const uint32_t nbuckets = max<uint32_t>(1, n / 4);
+    vector<vector<uint32_t>> buckets(nbuckets);
+    for (uint32_t i = 0; i < n; i++)
+        buckets[_hash(keys[i]->data(), keys[i]->size(), 0) % nbuckets]
+            .push_back(i);
+
+    // Place the biggest buckets first, while there's still lots of room.
+    vector<uint32_t> order(nbuckets);
+    for (uint32_t b = 0; b < nbuckets; b++)
+        order[b] = b;
+    sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+         {
+             return buckets[a].size() > buckets[b].size();
+         });
+
+    displacements.assign(nbuckets, 0);
+    slots.assign(n, NO_ENTRY);
+    vector<uint32_t> placed;
+    for (uint32_t b : order)
+    {
+        if (buckets[b].empty())
+            break;
+
+        bool done = false;
+        for (uint32_t seed = 1; seed < (1 << 24) && !done; seed++)
+        {
+            placed.clear();
+            for (uint32_t i : buckets[b])
+            {
+                const uint32_t s =
+                    _hash(keys[i]->data(), keys[i]->size(), seed) % n;
+                if (slots[s] != NO_ENTRY
+                    || find(placed.begin(), placed.end(), s) != placed.end())
+                {
+                    break;
+                }
+                placed.push_back(s);
+            }
+            if (placed.size() != buckets[b].size())
+                continue;
+
+            for (size_t i = 0; i < placed.size(); i++)
+                slots[placed[i]] = buckets[b][i];
+            displacements[b] = seed;
+            done = true;
+        }
+        if (!done)
+            return false;
+    }
+    return true;
+}
+
+bool textdb_file::write(const string &filename,
+                        const map<string, string> &entries,
+                        const string &timestamp)
+{
+    vector<const string *> keys;
+    for (const auto &entry : entries)
+        keys.push_back(&entry.first);
+
+    vector<uint32_t> displacements, slots;
+    if (!_perfect_hash(keys, displacements, slots))
+        return false;
+
+    // Trigrams of each lowercased key and body, for candidates().
+    map<uint32_t, vector<uint32_t>> index;
+    uint32_t entry_num = 0;
+    vector<uint32_t> seen;
+    for (const auto &entry : entries)
+    {
+        const string text = lowercase_string(entry.first) + "\n"
+                            + lowercase_string(entry.second);
+        seen.clear();
+        for (size_t i = 0; i + 2 < text.size(); i++)
+            seen.push_back(_trigram(text, i));
+        sort(seen.begin(), seen.end());
+        seen.erase(unique(seen.begin(), seen.end()), seen.end());
+        for (uint32_t t : seen)
+            index[t].push_back(entry_num);
+        entry_num++;
+    }
+
+    vector<uint32_t> out(sizeof(textdb_header) / sizeof(uint32_t));
+    auto append = [&](const vector<uint32_t> &tab)
+    {
+        const uint32_t off = out.size() * sizeof(uint32_t);
+        out.insert(out.end(), tab.begin(), tab.end());
+        return off;
+    };
+
+    textdb_header head;
+    head.magic = TEXTDB_MAGIC;
+    head.version = TEXTDB_VERSION;
+    head.entries = entries.size();
+    head.buckets = displacements.size();
+    head.trigrams = index.size();
+    head.displacement_off = append(displacements);
+    head.slot_off = append(slots);
+
+    vector<uint32_t> trigrams, postings;
+    for (const auto &tri : index)
+    {
+        trigrams.push_back(tri.first);
+        trigrams.push_back(postings.size());
+        trigrams.push_back(tri.second.size());
+        postings.insert(postings.end(), tri.second.begin(), tri.second.end());
+    }
+    head.trigram_off = append(trigrams);
+    head.posting_off = append(postings);
+    head.postings = postings.size();
+
+    // The strings go after all the tables.
+    uint64_t text_off = (out.size() + entries.size() * 4) * sizeof(uint32_t);
+    vector<uint32_t> entry_table;
+    string strings;
+    for (const auto &entry : entries)
+    {
+        entry_table.push_back(text_off + strings.size());
+        entry_table.push_back(entry.first.size());
+        strings += entry.first;
+        entry_table.push_back(text_off + strings.size());
+        entry_table.push_back(entry.second.size());
+        strings += entry.second;
+    }
+    head.entry_off = append(entry_table);
+    head.timestamp_off = text_off + strings.size();
+    head.timestamp_len = timestamp.size();
+    strings += timestamp;
+    if (text_off + strings.size() > 0xffffffffu)
+        return false;
+    memcpy(out.data(), &head, sizeof(head));
+
+    // Write to a temporary file and move it into place, so that other
+    // processes never see a partly written database.
+    const string tmp = filename + ".tmp";
+    FILE *f = fopen_u(tmp.c_str(), "wb");
+    if (!f)
+        return false;
+    const bool ok =
+        fwrite(out.data(), sizeof(uint32_t), out.size(), f) == out.size()
+        && fwrite(strings.data(), 1, strings.size(), f) == strings.size();
+    if (fclose(f) || !ok || rename_u(tmp.c_str(), filename.c_str()))
+    {
+        unlink_u(tmp.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,64 @@
+/**
+ * @file
+ * @brief Compiled, read-only files for the text databases.
+ *
+ * Each text database (and each translation of one) is compiled into one
+ * of these files, which is then mapped into memory. Keys are looked up
+ * through a perfect hash. Regex searches over keys and bodies are first
+ * narrowed down with a trigram index over the lowercased text.
+**/
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+using std::map;
+using std::string;
+using std::vector;
+
+struct textdb_header;
+
+class textdb_file
+{
+public:
+    textdb_file();
+    ~textdb_file();
+
+    // Returns false if the file is missing, or isn't a database in the
+    // current format.
+    bool open(const string &filename);
+    void close();
+
+    string timestamp() const;
+
+    // Returns "" if the key is missing.
+    string find(const string &key) const;
+
+    unsigned int size() const;
+    string key(unsigned int entry) const;
+    string body(unsigned int entry) const;
+
+    // The entries whose key or body might match the given regex, in key
+    // order. All entries if the regex can't be narrowed down.
+    vector<unsigned int> candidates(const string &regex) const;
+
+    // Writes a database to filename, replacing it atomically.
+    static bool write(const string &filename,
+                      const map<string, string> &entries,
+                      const string &timestamp);
+
+private:
+    textdb_file(const textdb_file &) = delete;
+    textdb_file &operator=(const textdb_file &) = delete;
+
+    const uint32_t *table(uint32_t offset) const;
+    string text(uint32_t offset, uint32_t len) const;
+
+    const char *data;
+    size_t len;
+    bool mapped;
+    const textdb_header *head;
+};
@@ -5,6 +5,7 @@
 #include "tileweb.h"
 
 #include <cerrno>
+#include <chrono>
 #include <cstdarg>
 
 #include <sys/socket.h>
@@ -14,6 +15,7 @@
 #if defined(UNIX) || defined(TARGET_COMPILER_MINGW)
 #include <unistd.h>
 #endif
+#include <zlib.h>
 
 #include "artefact.h"
 #include "branch.h"
@@ -72,6 +74,11 @@
 
 //#define DEBUG_WEBSOCKETS
 
+// How many bytes may be waiting for a single receiver before we give up on
+// it: the first time, its queue is discarded and it gets a full resync; if
+// it can't keep up with that either, it is dropped.
+#define WEBTILES_QUEUE_LIMIT (4 * 1024 * 1024)
+
 static unsigned int get_milliseconds()
 {
     // This is Unix-only, but so is Webtiles at the moment.
@@ -85,6 +92,9 @@ TilesFramework tiles;
 
 TilesFramework::TilesFramework() :
       m_controlled_from_web(false),
+      m_need_resync(false),
+      m_writer_running(false),
+      m_writer_stop(false),
       _send_lock(false),
       m_last_ui_state(UI_INIT),
       m_view_loaded(false),
@@ -93,6 +103,7 @@ TilesFramework::TilesFramework() :
       m_next_view_tl(0, 0),
       m_next_view_br(-1, -1),
       m_need_full_map(true),
+      m_compact_map(false),
       m_text_menu("menu_txt"),
       m_print_fg(15)
 {
@@ -100,10 +111,15 @@ TilesFramework::TilesFramework() :
     default_cell.tile.bg = TILE_FLAG_UNSEEN;
     m_current_view.fill(default_cell);
     m_next_view.fill(default_cell);
+
+    mutex_init(m_send_mutex);
+    cond_init(m_send_cond);
 }
 
 TilesFramework::~TilesFramework()
 {
+    cond_destroy(m_send_cond);
+    mutex_destroy(m_send_mutex);
 }
 
 void TilesFramework::shutdown()
@@ -111,6 +127,31 @@ void TilesFramework::shutdown()
     if (m_sock_name.empty())
         return;
 
+    if (m_writer_running)
+    {
+        // Give the writer a few seconds to deliver whatever is still queued
+        // (the exit reason, in particular) before we close the socket.
+        for (int i = 0; i < 500; ++i)
+        {
+            bool pending = false;
+            mutex_lock(m_send_mutex);
+            for (const auto &dest : m_dests)
+                if (!dest->dead && !dest->messages.empty())
+                    pending = true;
+            mutex_unlock(m_send_mutex);
+            if (!pending)
+                break;
+            usleep(10 * 1000);
+        }
+
+        mutex_lock(m_send_mutex);
+        m_writer_stop = true;
+        cond_wake(m_send_cond);
+        mutex_unlock(m_send_mutex);
+        thread_join(m_writer);
+        m_writer_running = false;
+    }
+
     close(m_sock);
     remove(m_sock_name.c_str());
 }
@@ -153,6 +194,11 @@ bool TilesFramework::initialise()
     if (setsockopt(m_sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0)
         die("Can't set send timeout!");
 
+    m_writer_stop = false;
+    if (thread_create_joinable(&m_writer, _writer_thread, this))
+        die("Can't start the webtiles writer thread!");
+    m_writer_running = true;
+
     if (m_await_connection)
         _await_connection();
 
@@ -185,13 +231,75 @@ void TilesFramework::write_message(const char *format, ...)
     m_msg_buf.append(buf);
 }
 
+// Queue m_msg_buf for one receiver. Called with m_send_mutex held.
+void TilesFramework::_queue_message(WebtilesDest &dest)
+{
+    // Anything we'd send now is superseded by the coming resync.
+    if (dest.dead || dest.needs_resync)
+        return;
+
+    if (dest.queued_bytes + m_msg_buf.size() > WEBTILES_QUEUE_LIMIT)
+    {
+        // Keep a message that is partly on the wire, so that the receiver
+        // doesn't see half a line; drop everything after it.
+        const bool keep_front = !dest.messages.empty()
+                                && (dest.front_offset > 0 || dest.in_flight);
+        while (dest.messages.size() > (keep_front ? 1 : 0))
+        {
+            dest.queued_bytes -= dest.messages.back().size();
+            dest.messages.pop_back();
+        }
+
+        if (dest.resyncing)
+        {
+#ifdef DEBUG_WEBSOCKETS
+            fprintf(stderr, "websocket: Receiver can't keep up with a resync, "
+                            "dropping it.\n");
+#endif
+            dest.dead = true;
+        }
+        else
+        {
+#ifdef DEBUG_WEBSOCKETS
+            fprintf(stderr, "websocket: Send queue overflow, resyncing.\n");
+#endif
+            dest.needs_resync = true;
+            m_need_resync = true;
+        }
+        return;
+    }
+
+    dest.messages.push_back(m_msg_buf);
+    dest.queued_bytes += m_msg_buf.size();
+}
+
+// Forget receivers the writer has given up on. Called with m_send_mutex held.
+void TilesFramework::_reap_destinations()
+{
+    for (unsigned int i = 0; i < m_dests.size(); ++i)
+    {
+        if (!m_dests[i]->dead)
+            continue;
+
+        if (!m_dests[i]->error.empty())
+        {
+            const string error = m_dests[i]->error;
+            mutex_unlock(m_send_mutex);
+            die("Socket write error: %s", error.c_str());
+        }
+
+        m_dests.erase(m_dests.begin() + i);
+        i--;
+    }
+}
+
 void TilesFramework::finish_message()
 {
     if (m_msg_buf.size() == 0)
         return;
 #ifdef DEBUG_WEBSOCKETS
     const int initial_buf_size = m_msg_buf.size();
-    fprintf(stderr, "websocket: About to send %d bytes.\n", initial_buf_size);
+    fprintf(stderr, "websocket: About to queue %d bytes.\n", initial_buf_size);
 #endif
 
     if (m_sock_name.empty())
@@ -201,90 +309,115 @@ void TilesFramework::finish_message()
     }
 
     m_msg_buf.append("\n");
-    const char* fragment_start = m_msg_buf.data();
-    const char* data_end = m_msg_buf.data() + m_msg_buf.size();
+
+    mutex_lock(m_send_mutex);
+    _reap_destinations();
+    for (auto &dest : m_dests)
+        _queue_message(*dest);
+    cond_wake(m_send_cond);
+    mutex_unlock(m_send_mutex);
+
+    m_msg_buf.clear();
+    m_need_flush = true;
 #ifdef DEBUG_WEBSOCKETS
-    int fragments = 0;
+    // should the game actually crash in this case?
+    if (m_controlled_from_web && m_dests.size() == 0)
+        fprintf(stderr, "No open websockets after finish_message!!\n");
 #endif
-    while (fragment_start < data_end)
+}
+
+void *TilesFramework::_writer_thread(void *arg)
+{
+    static_cast<TilesFramework *>(arg)->_write_queued();
+    return nullptr;
+}
+
+// The writer thread. Sends each receiver's queue in order, a datagram of
+// at most m_max_msg_size at a time, taking turns between receivers so that
+// one that isn't reading doesn't hold up the others.
+void TilesFramework::_write_queued()
+{
+    mutex_lock(m_send_mutex);
+    while (!m_writer_stop)
     {
-        int fragment_size = data_end - fragment_start;
-        if (fragment_size > m_max_msg_size)
-            fragment_size = m_max_msg_size;
-#ifdef DEBUG_WEBSOCKETS
-        fragments++;
-#endif
+        bool pending = false;
+        bool progress = false;
 
-        for (unsigned int i = 0; i < m_dest_addrs.size(); ++i)
+        // The game may add or remove receivers while we're unlocked, so
+        // go by index and hold on to the one we're sending to.
+        for (unsigned int i = 0; i < m_dests.size() && !m_writer_stop; ++i)
         {
-            int retries = 30;
-            ssize_t sent = 0;
-            while (sent < fragment_size)
+            shared_ptr<WebtilesDest> dest = m_dests[i];
+            if (dest->dead || dest->messages.empty())
+                continue;
+            pending = true;
+
+            const string &msg = dest->messages.front();
+            const size_t size = min<size_t>(m_max_msg_size,
+                                            msg.size() - dest->front_offset);
+            const string fragment = msg.substr(dest->front_offset, size);
+            const sockaddr_un addr = dest->addr;
+            dest->in_flight = true;
+            mutex_unlock(m_send_mutex);
+
+            const ssize_t retval = sendto(m_sock, fragment.data(),
+                                          fragment.size(), MSG_DONTWAIT,
+                                          (const sockaddr*) &addr,
+                                          sizeof(sockaddr_un));
+            const int err = errno;
+
+            mutex_lock(m_send_mutex);
+            dest->in_flight = false;
+            if (retval > 0)
             {
-                ssize_t retval = sendto(m_sock, fragment_start + sent,
-                    fragment_size - sent, 0, (sockaddr*) &m_dest_addrs[i],
-                    sizeof(sockaddr_un));
-#ifdef DEBUG_WEBSOCKETS
-                fprintf(stderr,
-                            "    trying to send fragment to client %d...", i);
-#endif
-                if (retval <= 0)
+                progress = true;
+                dest->front_offset += retval;
+                dest->queued_bytes -= retval;
+                if (dest->front_offset >= dest->messages.front().size())
                 {
-                    const char *errmsg = retval == 0 ? "No bytes sent"
-                                                     : strerror(errno);
-                    if (--retries <= 0)
-                        die("Socket write error: %s", errmsg);
-
-                    if (retval == 0 || errno == ENOBUFS || errno == EWOULDBLOCK
-                        || errno == EINTR || errno == EAGAIN)
-                    {
-                        // Wait for half a second at first (up to five), then
-                        // try again.
-                        const int sleep_time = retries > 25 ? 2 * 1000
-                                             : retries > 10 ? 500 * 1000
-                                             : 5000 * 1000;
-#ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr, "failed (%s), sleeping for %dms.\n",
-                                                    errmsg, sleep_time / 1000);
-#endif
-                        usleep(sleep_time);
-                    }
-                    else if (errno == ECONNREFUSED || errno == ENOENT)
-                    {
-                        // the other side is dead
-#ifdef DEBUG_WEBSOCKETS
-                        fprintf(stderr,
-                            "failed (%s), breaking.\n", errmsg);
-#endif
-                        m_dest_addrs.erase(m_dest_addrs.begin() + i);
-                        i--;
-                        break;
-                    }
-                    else
-                        die("Socket write error: %s", errmsg);
+                    dest->messages.pop_front();
+                    dest->front_offset = 0;
+                    if (dest->messages.empty())
+                        dest->resyncing = false;
                 }
-                else
-                {
+            }
+            else if (retval == 0 || err == ENOBUFS || err == EWOULDBLOCK
+                     || err == EINTR || err == EAGAIN)
+            {
+                // Try again once we've been round the others.
+            }
+            else
+            {
+                // ECONNREFUSED or ENOENT mean the other side is dead; the
+                // game will forget about it. Anything else is fatal, but
+                // that has to be reported from the main thread.
 #ifdef DEBUG_WEBSOCKETS
-                    fprintf(stderr, "fragment size %d sent.\n", fragment_size);
+                fprintf(stderr, "websocket: Write failed (%s), dropping "
+                                "receiver.\n", strerror(err));
 #endif
-                    sent += retval;
-                }
+                if (err != ECONNREFUSED && err != ENOENT)
+                    dest->error = strerror(err);
+                dest->dead = true;
+                dest->messages.clear();
+                dest->front_offset = 0;
+                dest->queued_bytes = 0;
             }
         }
 
-        fragment_start += fragment_size;
+        if (m_writer_stop)
+            break;
+        else if (!pending)
+            cond_wait(m_send_cond, m_send_mutex);
+        else if (!progress)
+        {
+            // Every receiver with something queued is backed up; give the
+            // socket buffers a moment to drain.
+            mutex_unlock(m_send_mutex);
+            usleep(2 * 1000);
+            mutex_lock(m_send_mutex);
+        }
     }
-    m_msg_buf.clear();
-    m_need_flush = true;
-#ifdef DEBUG_WEBSOCKETS
-    // should the game actually crash in this case?
-    if (m_controlled_from_web && m_dest_addrs.size() == 0)
-        fprintf(stderr, "No open websockets after finish_message!!\n");
-
-    fprintf(stderr, "websocket: Sent %d bytes in %d fragments.\n",
-                                                initial_buf_size, fragments);
-#endif
+    mutex_unlock(m_send_mutex);
 }
 
 void TilesFramework::send_message(const char *format, ...)
@@ -315,6 +448,9 @@ void TilesFramework::flush_messages()
         return;
     unwind_bool no_rentry(_send_lock, true);
 
+    if (m_need_resync)
+        _resync_destinations();
+
     if (m_need_flush)
     {
         send_message("*{\"msg\":\"flush_messages\"}");
@@ -322,12 +458,36 @@ void TilesFramework::flush_messages()
     }
 }
 
+// Send a full copy of the game state after a receiver's queue overflowed.
+// As when a spectator joins, this goes to every receiver: the state we send
+// differences against is shared between them all.
+void TilesFramework::_resync_destinations()
+{
+    m_need_resync = false;
+
+    mutex_lock(m_send_mutex);
+    bool any = false;
+    for (auto &dest : m_dests)
+    {
+        if (dest->needs_resync && !dest->dead)
+        {
+            dest->needs_resync = false;
+            dest->resyncing = true;
+            any = true;
+        }
+    }
+    mutex_unlock(m_send_mutex);
+
+    if (any)
+        _send_everything();
+}
+
 void TilesFramework::_await_connection()
 {
     if (m_sock_name.empty())
         return;
 
-    while (m_dest_addrs.size() == 0)
+    while (m_dests.size() == 0)
         _receive_control_message();
 }
 
@@ -439,7 +599,11 @@ wint_t TilesFramework::_handle_control_message(sockaddr_un addr, string data)
         JsonWrapper primary = json_find_member(obj.node, "primary");
         primary.check(JSON_BOOL);
 
-        m_dest_addrs.push_back(addr);
+        auto dest = make_shared<WebtilesDest>();
+        dest->addr = addr;
+        mutex_lock(m_send_mutex);
+        m_dests.push_back(dest);
+        mutex_unlock(m_send_mutex);
         m_controlled_from_web = primary->bool_;
     }
     else if (msgtype == "key")
@@ -729,6 +893,14 @@ void TilesFramework::send_milestone(const xlog_fields &xl)
 
 void TilesFramework::send_options()
 {
+    // The client decodes map messages according to the options it was last
+    // sent, so this is the only place the map format can change.
+    if (m_compact_map != Options.tile_web_compact_map)
+    {
+        m_compact_map = Options.tile_web_compact_map;
+        m_need_full_map = true;
+    }
+
     json_open_object();
     json_write_string("msg", "options");
     Options.write_webtiles_options("options");
@@ -1520,39 +1692,122 @@ void TilesFramework::write_tileidx(tileidx_t t)
         tiles.write_message("[%d,%d]", lo, hi);
 }
 
+// The fields of a cell update common enough to have a fixed slot in the
+// compact map format. A compact cell is an array of the field mask, the
+// values of the fields present in this order, and then optionally an object
+// holding everything else, as in the full format. See map_knowledge.js.
+enum compact_cell_field
+{
+    CCF_FEAT        = 1 << 0,
+    CCF_MAP_FEAT    = 1 << 1,
+    CCF_GLYPH       = 1 << 2,
+    CCF_COLOUR      = 1 << 3,
+    CCF_FG          = 1 << 4,
+    CCF_BG          = 1 << 5,
+    CCF_FLV_FLOOR   = 1 << 6,
+    CCF_FLV_SPECIAL = 1 << 7,
+};
+
 void TilesFramework::_send_cell(const coord_def &gc,
                                 const screen_cell_t &current_sc, const screen_cell_t &next_sc,
                                 const map_cell &current_mc, const map_cell &next_mc,
                                 map<uint32_t, coord_def>& new_monster_locs,
                                 bool force_full)
 {
-    if (current_mc.feat() != next_mc.feat())
-        json_write_int("f", next_mc.feat());
+    const packed_cell &next_pc = next_sc.tile;
+    const packed_cell &current_pc = current_sc.tile;
 
-    if (next_mc.monsterinfo())
-        _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
-    else if (current_mc.monsterinfo())
-        json_write_null("mon");
+    // Work out which of the common fields changed first, since the compact
+    // format has to write its field mask before anything else.
+    int fields = 0;
 
-    map_feature mf = get_cell_map_feature(gc);
+    if (current_mc.feat() != next_mc.feat())
+        fields |= CCF_FEAT;
+
+    const map_feature mf = get_cell_map_feature(gc);
     if (get_cell_map_feature(current_mc) != mf)
-        json_write_int("mf", mf);
+        fields |= CCF_MAP_FEAT;
 
     // Glyph and colour
-    char32_t glyph = next_sc.glyph;
+    const char32_t glyph = next_sc.glyph;
+    char glyph_buf[5];
     if (current_sc.glyph != glyph)
     {
-        char buf[5];
-        buf[wctoutf8(buf, glyph)] = 0;
-        json_write_string("g", buf);
+        glyph_buf[wctoutf8(glyph_buf, glyph)] = 0;
+        fields |= CCF_GLYPH;
     }
+    int col = 0;
     if ((current_sc.colour != next_sc.colour
          || current_sc.glyph == ' ') && glyph != ' ')
     {
-        int col = next_sc.colour;
+        col = next_sc.colour;
         col = (_get_highlight(col) << 4) | macro_colour(col & 0xF);
-        json_write_int("col", col);
+        fields |= CCF_COLOUR;
+    }
+
+    if (next_pc.fg != current_pc.fg)
+        fields |= CCF_FG;
+    if (next_pc.bg != current_pc.bg)
+        fields |= CCF_BG;
+
+    if (_needs_flavour(next_pc) &&
+        (next_pc.flv.floor != current_pc.flv.floor
+         || next_pc.flv.special != current_pc.flv.special
+         || !_needs_flavour(current_pc)
+         || force_full))
+    {
+        fields |= CCF_FLV_FLOOR;
+        if (next_pc.flv.special)
+            fields |= CCF_FLV_SPECIAL;
+    }
+
+    if (m_compact_map)
+    {
+        json_write_int(fields);
+        if (!fields)
+            json_treat_as_empty();
+        if (fields & CCF_FEAT)
+            json_write_int(next_mc.feat());
+        if (fields & CCF_MAP_FEAT)
+            json_write_int(mf);
+        if (fields & CCF_GLYPH)
+            json_write_string(glyph_buf);
+        if (fields & CCF_COLOUR)
+            json_write_int(col);
+        if (fields & CCF_FG)
+        {
+            json_write_comma();
+            write_tileidx(next_pc.fg);
+        }
+        if (fields & CCF_BG)
+        {
+            json_write_comma();
+            write_tileidx(next_pc.bg);
+        }
+        if (fields & CCF_FLV_FLOOR)
+            json_write_int(next_pc.flv.floor);
+        if (fields & CCF_FLV_SPECIAL)
+            json_write_int(next_pc.flv.special);
+
+        json_open_object();
     }
+    else
+    {
+        if (fields & CCF_FEAT)
+            json_write_int("f", next_mc.feat());
+        if (fields & CCF_MAP_FEAT)
+            json_write_int("mf", mf);
+        if (fields & CCF_GLYPH)
+            json_write_string("g", glyph_buf);
+        if (fields & CCF_COLOUR)
+            json_write_int("col", col);
+    }
+
+    if (next_mc.monsterinfo())
+        _send_monster(gc, next_mc.monsterinfo(), new_monster_locs, force_full);
+    else if (current_mc.monsterinfo())
+        json_write_null("mon");
+
     if (current_sc.flash_colour != next_sc.flash_colour)
         json_write_int("flc", next_sc.flash_colour);
     if (current_sc.flash_alpha != next_sc.flash_alpha)
@@ -1561,30 +1816,38 @@ void TilesFramework::_send_cell(const coord_def &gc,
     json_open_object("t");
     {
         // Tile data
-        const packed_cell &next_pc = next_sc.tile;
-        const packed_cell &current_pc = current_sc.tile;
-
         const tileidx_t fg_idx = next_pc.fg & TILE_FLAG_MASK;
 
         const bool in_water = _in_water(next_pc);
-        bool fg_changed = false;
+        const bool fg_changed = fields & CCF_FG;
 
-        if (next_pc.fg != current_pc.fg)
+        if (!m_compact_map)
         {
-            fg_changed = true;
+            if (fields & CCF_FG)
+            {
+                json_write_name("fg");
+                write_tileidx(next_pc.fg);
+            }
 
-            json_write_name("fg");
-            write_tileidx(next_pc.fg);
-            if (get_tile_texture(fg_idx) == TEX_DEFAULT)
-                json_write_int("base", (int) tileidx_known_base_item(fg_idx));
-        }
+            if (fields & CCF_BG)
+            {
+                json_write_name("bg");
+                write_tileidx(next_pc.bg);
+            }
 
-        if (next_pc.bg != current_pc.bg)
-        {
-            json_write_name("bg");
-            write_tileidx(next_pc.bg);
+            if (fields & CCF_FLV_FLOOR)
+            {
+                json_open_object("flv");
+                json_write_int("f", next_pc.flv.floor);
+                if (fields & CCF_FLV_SPECIAL)
+                    json_write_int("s", next_pc.flv.special);
+                json_close_object();
+            }
         }
 
+        if (fg_changed && get_tile_texture(fg_idx) == TEX_DEFAULT)
+            json_write_int("base", (int) tileidx_known_base_item(fg_idx));
+
         if (next_pc.cloud != current_pc.cloud)
         {
             json_write_name("cloud");
@@ -1647,19 +1910,6 @@ void TilesFramework::_send_cell(const coord_def &gc,
         if (next_pc.travel_trail != current_pc.travel_trail)
             json_write_int("travel_trail", next_pc.travel_trail);
 
-        if (_needs_flavour(next_pc) &&
-            (next_pc.flv.floor != current_pc.flv.floor
-             || next_pc.flv.special != current_pc.flv.special
-             || !_needs_flavour(current_pc)
-             || force_full))
-        {
-            json_open_object("flv");
-            json_write_int("f", next_pc.flv.floor);
-            if (next_pc.flv.special)
-                json_write_int("s", next_pc.flv.special);
-            json_close_object();
-        }
-
         if (fg_idx >= TILEP_MCACHE_START)
         {
             if (fg_changed)
@@ -1759,6 +2009,10 @@ void TilesFramework::_send_cell(const coord_def &gc,
         }
     }
     json_close_object(true);
+
+    // The object of everything else in a compact cell.
+    if (m_compact_map)
+        json_close_object(true);
 }
 
 void TilesFramework::_send_cursor(cursor_type type)
@@ -1797,45 +2051,12 @@ void TilesFramework::_mcache_ref(bool inc)
         }
 }
 
-void TilesFramework::_send_map(bool force_full)
+// Write the "cells" of a map message: the differences between
+// m_current_view and m_next_view for every dirty cell, redrawing those that
+// need it first.
+void TilesFramework::_write_map_cells(bool force_full,
+                                      map<uint32_t, coord_def>& new_monster_locs)
 {
-    // TODO: prevent in some other / better way?
-    if (_send_lock)
-        return;
-
-    unwind_bool no_rentry(_send_lock, true);
-
-    map<uint32_t, coord_def> new_monster_locs;
-
-    force_full = force_full || m_need_full_map;
-    m_need_full_map = false;
-
-    json_open_object();
-    json_write_string("msg", "map");
-    json_treat_as_empty();
-
-    // cautionary note: this is used in heuristic ways in process_handler.py,
-    // see `_is_full_map_msg`
-    if (force_full)
-        json_write_bool("clear", true);
-
-    if (force_full || you.on_current_level != m_player_on_level)
-    {
-        json_write_bool("player_on_level", you.on_current_level);
-        m_player_on_level = you.on_current_level;
-    }
-
-    if (force_full || m_current_gc != m_next_gc)
-    {
-        if (m_origin.equals(-1, -1))
-            m_origin = m_next_gc;
-        json_open_object("vgrdc");
-        json_write_int("x", m_next_gc.x - m_origin.x);
-        json_write_int("y", m_next_gc.y - m_origin.y);
-        json_close_object();
-        m_current_gc = m_next_gc;
-    }
-
     screen_cell_t default_cell;
     default_cell.tile.bg = TILE_FLAG_UNSEEN;
     default_cell.glyph = ' ';
@@ -1875,14 +2096,34 @@ void TilesFramework::_send_map(bool force_full)
             if (m_origin.equals(-1, -1))
                 m_origin = gc;
 
-            json_open_object();
-            if (send_gc
-                || last_gc.x + 1 != gc.x
-                || last_gc.y != gc.y)
+            const bool moved = send_gc
+                               || last_gc.x + 1 != gc.x
+                               || last_gc.y != gc.y;
+            const int start = m_msg_buf.size();
+
+            // Cells without a position are for the cell to the right of
+            // the previous one. The compact format gives the position as
+            // an object of its own.
+            if (m_compact_map)
             {
-                json_write_int("x", x - m_origin.x);
-                json_write_int("y", y - m_origin.y);
-                json_treat_as_empty();
+                if (moved)
+                {
+                    json_open_object();
+                    json_write_int("x", x - m_origin.x);
+                    json_write_int("y", y - m_origin.y);
+                    json_close_object();
+                }
+                json_open_array();
+            }
+            else
+            {
+                json_open_object();
+                if (moved)
+                {
+                    json_write_int("x", x - m_origin.x);
+                    json_write_int("y", y - m_origin.y);
+                    json_treat_as_empty();
+                }
             }
 
             const screen_cell_t& sc = force_full ? default_cell
@@ -1895,14 +2136,64 @@ void TilesFramework::_send_map(bool force_full)
                        mc, env.map_knowledge(gc),
                        new_monster_locs, force_full);
 
-            if (!json_is_empty())
+            const bool empty = json_is_empty();
+            if (!empty)
             {
                 send_gc = false;
                 last_gc = gc;
             }
-            json_close_object(true);
+            if (m_compact_map)
+            {
+                json_close_array(true);
+                if (empty)
+                    m_msg_buf.resize(start);
+            }
+            else
+                json_close_object(true);
         }
     json_close_array(true);
+}
+
+void TilesFramework::_send_map(bool force_full)
+{
+    // TODO: prevent in some other / better way?
+    if (_send_lock)
+        return;
+
+    unwind_bool no_rentry(_send_lock, true);
+
+    map<uint32_t, coord_def> new_monster_locs;
+
+    force_full = force_full || m_need_full_map;
+    m_need_full_map = false;
+
+    json_open_object();
+    json_write_string("msg", "map");
+    json_treat_as_empty();
+
+    // cautionary note: this is used in heuristic ways in process_handler.py,
+    // see `_is_full_map_msg`
+    if (force_full)
+        json_write_bool("clear", true);
+
+    if (force_full || you.on_current_level != m_player_on_level)
+    {
+        json_write_bool("player_on_level", you.on_current_level);
+        m_player_on_level = you.on_current_level;
+    }
+
+    if (force_full || m_current_gc != m_next_gc)
+    {
+        if (m_origin.equals(-1, -1))
+            m_origin = m_next_gc;
+        json_open_object("vgrdc");
+        json_write_int("x", m_next_gc.x - m_origin.x);
+        json_write_int("y", m_next_gc.y - m_origin.y);
+        json_close_object();
+        m_current_gc = m_next_gc;
+    }
+
+    _write_map_cells(force_full, new_monster_locs);
 
     json_close_object(true);
 
@@ -1923,6 +2214,120 @@ void TilesFramework::_send_map(bool force_full)
     m_monster_locs = new_monster_locs;
 }
 
+/**
+ * Keep a copy of the whole map as it would be sent now, for
+ * bench_map_frames().
+ */
+void TilesFramework::record_map_frame()
+{
+    crawl_view_buffer frame(coord_def(GXM, GYM));
+    for (int y = 0; y < GYM; y++)
+        for (int x = 0; x < GXM; x++)
+            draw_cell(&frame(coord_def(x, y)), coord_def(x, y), false, 0);
+    for (int y = 0; y < GYM; y++)
+        for (int x = 0; x < GXM; x++)
+            pack_cell_overlays(coord_def(x, y), frame);
+
+    m_recorded_frames.push_back(frame);
+}
+
+void TilesFramework::clear_map_frames()
+{
+    m_recorded_frames.clear();
+}
+
+/**
+ * Encode the recorded frames as map messages: a full map for the first
+ * frame, then each frame as an update from the one before. Nothing is
+ * actually sent, and the map state is restored afterwards.
+ *
+ * @param compact Whether to use the compact map format.
+ * @return The number of messages, their total size, how big they would
+ *         be after the webserver's deflate, and the time spent encoding.
+ */
+TilesFramework::map_bench_result TilesFramework::bench_map_frames(bool compact)
+{
+    map_bench_result result;
+    if (m_recorded_frames.empty())
+        return result;
+
+    unwind_var<crawl_view_buffer> saved_current_view(m_current_view);
+    unwind_var<crawl_view_buffer> saved_next_view(m_next_view);
+    unwind_var<MapKnowledge> saved_current_knowledge(m_current_map_knowledge);
+    unwind_var<MapKnowledge> saved_knowledge(env.map_knowledge);
+    unwind_var<map<uint32_t, coord_def>> saved_monster_locs(m_monster_locs);
+    unwind_var<bitset<GXM * GYM>> saved_dirty(m_dirty_cells);
+    unwind_var<bitset<GXM * GYM>> saved_redraw(m_cells_needing_redraw);
+    unwind_var<coord_def> saved_origin(m_origin);
+    unwind_var<dolls_data> saved_doll(last_player_doll);
+    unwind_var<bool> saved_compact(m_compact_map, compact);
+    unwind_var<string> saved_msg_buf(m_msg_buf, "");
+
+    // The webserver deflates each websocket's messages as one stream, with
+    // a sync flush after every message; see ws_handler.py.
+    z_stream zs;
+    zs.zalloc = Z_NULL;
+    zs.zfree  = Z_NULL;
+    zs.opaque = Z_NULL;
+    if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        die("deflateInit2 failed");
+    }
+    vector<Bytef> out(64 * 1024);
+
+    for (size_t i = 0; i < m_recorded_frames.size(); ++i)
+    {
+        const bool full = i == 0;
+        m_next_view = m_recorded_frames[i];
+        for (int y = 0; y < GYM; y++)
+            for (int x = 0; x < GXM; x++)
+                env.map_knowledge[x][y] = m_next_view(coord_def(x, y)).tile.map_knowledge;
+
+        // Every cell is up for comparison, but none is redrawn.
+        m_dirty_cells.set();
+        m_cells_needing_redraw.reset();
+        m_msg_buf.clear();
+        map<uint32_t, coord_def> new_monster_locs;
+
+        const auto start = chrono::steady_clock::now();
+        json_open_object();
+        json_write_string("msg", "map");
+        if (full)
+            json_write_bool("clear", true);
+        _write_map_cells(full, new_monster_locs);
+        json_close_object();
+        const auto end = chrono::steady_clock::now();
+
+        result.messages++;
+        result.bytes += m_msg_buf.size() + 1; // and a newline
+        result.usecs += chrono::duration_cast<chrono::microseconds>(
+                            end - start).count();
+
+        zs.next_in = (Bytef *) m_msg_buf.data();
+        zs.avail_in = m_msg_buf.size();
+        do
+        {
+            zs.next_out = out.data();
+            zs.avail_out = out.size();
+            deflate(&zs, Z_SYNC_FLUSH);
+            result.deflated_bytes += out.size() - zs.avail_out;
+        }
+        while (zs.avail_out == 0);
+        // ws_handler strips the 00 00 ff ff trailer of each flush.
+        result.deflated_bytes -= 4;
+
+        m_current_view = m_next_view;
+        m_current_map_knowledge = env.map_knowledge;
+        m_monster_locs = new_monster_locs;
+    }
+
+    deflateEnd(&zs);
+    m_msg_buf.clear();
+
+    return result;
+}
+
 void TilesFramework::_send_monster(const coord_def &gc, const monster_info* m,
                                    map<uint32_t, coord_def>& new_monster_locs,
                                    bool force_full)
@@ -1989,6 +2394,22 @@ void TilesFramework::_send_monster(const coord_def &gc, const monster_info* m,
     json_close_object(true);
 }
 
+// Would _send_cell() have anything to send for a change from b to a?
+// packed_cell::operator== leaves out a few fields that are sent.
+static bool _same_screen_cell(const screen_cell_t &a, const screen_cell_t &b)
+{
+    return a.glyph == b.glyph
+           && a.colour == b.colour
+           && a.flash_colour == b.flash_colour
+           && a.flash_alpha == b.flash_alpha
+           && a.tile == b.tile
+           && a.tile.flv.floor == b.tile.flv.floor
+           && a.tile.flv.special == b.tile.flv.special
+           && a.tile.icons == b.tile.icons
+           && a.tile.is_highlighted_summoner == b.tile.is_highlighted_summoner
+           && a.tile.has_bfb_corpse == b.tile.has_bfb_corpse;
+}
+
 void TilesFramework::load_dungeon(const crawl_view_buffer &vbuf,
                                   const coord_def &gc)
 {
@@ -2039,8 +2460,19 @@ void TilesFramework::load_dungeon(const crawl_view_buffer &vbuf,
             *cell = ((const screen_cell_t *) vbuf)[x + vbuf.size().x * y];
             pack_cell_overlays(grid, m_next_view);
 
+            // Only send the cells that have changed since they were last
+            // sent. Monsters are always sent, to keep track of where they
+            // have moved.
+            const bool changed = is_dirty(grid)
+                || !_same_screen_cell(*cell, m_current_view(grid))
+                || env.map_knowledge(grid) != m_current_map_knowledge(grid)
+                || get_cell_map_feature(grid)
+                   != get_cell_map_feature(m_current_map_knowledge(grid))
+                || env.map_knowledge(grid).monsterinfo();
+
             mark_clean(grid); // Remove redraw flag
-            mark_dirty(grid);
+            if (changed)
+                mark_dirty(grid);
         }
 
     m_next_gc = gc;
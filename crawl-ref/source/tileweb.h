@@ -8,7 +8,9 @@
 #ifdef USE_TILE_WEB
 
 #include <bitset>
+#include <deque>
 #include <map>
+#include <memory>
 #include <vector>
 
 #include <sys/un.h>
@@ -18,6 +20,7 @@
 #include "map-knowledge.h"
 #include "status.h"
 #include "text-tag-type.h"
+#include "threads.h"
 #include "tiledoll.h"
 #include "tilemcache.h"
 #include "tileweb-text.h"
@@ -28,6 +31,22 @@ using std::vector;
 class xlog_fields;
 class Menu;
 
+// A receiver of webtiles messages. Messages are queued here by the game
+// and written out to the socket by a background thread, so that a slow
+// reader can't stall the game. Guarded by TilesFramework::m_send_mutex.
+struct WebtilesDest
+{
+    sockaddr_un addr;
+    deque<string> messages;
+    size_t front_offset = 0; // bytes of messages.front() already sent
+    size_t queued_bytes = 0;
+    bool in_flight = false;  // the writer is sending part of messages.front()
+    bool needs_resync = false;
+    bool resyncing = false;
+    bool dead = false;
+    string error;
+};
+
 enum WebtilesUIState
 {
     UI_INIT = -1,
@@ -157,7 +176,7 @@ public:
     void send_message(PRINTF(1, ));
     void flush_messages();
 
-    bool has_receivers() { return !m_dest_addrs.empty(); }
+    bool has_receivers() { return !m_dests.empty(); }
     bool is_controlled_from_web() { return m_controlled_from_web; }
 
     /* Webtiles can receive input both via stdin, and on the
@@ -223,14 +242,39 @@ public:
     void send_milestone(const xlog_fields &xl);
     void send_options();
 
+    // Benchmarking the map stream: see scripts/bench-webmap.lua.
+    struct map_bench_result
+    {
+        int messages = 0;
+        size_t bytes = 0;
+        size_t deflated_bytes = 0;
+        uint64_t usecs = 0;
+    };
+    void record_map_frame();
+    void clear_map_frames();
+    map_bench_result bench_map_frames(bool compact);
+
 protected:
     int m_sock;
     int m_max_msg_size;
     string m_msg_buf;
-    vector<sockaddr_un> m_dest_addrs;
+    vector<shared_ptr<WebtilesDest>> m_dests;
 
     bool m_controlled_from_web;
     bool m_need_flush;
+    bool m_need_resync;
+
+    mutex_t m_send_mutex;
+    cond_t m_send_cond;
+    thread_t m_writer;
+    bool m_writer_running;
+    bool m_writer_stop;
+
+    static void *_writer_thread(void *arg);
+    void _write_queued();
+    void _queue_message(WebtilesDest &dest);
+    void _reap_destinations();
+    void _resync_destinations();
 
     bool _send_lock; // not thread safe
 
@@ -290,6 +334,9 @@ protected:
     FixedArray<map_cell, GXM, GYM> m_current_map_knowledge;
     map<uint32_t, coord_def> m_monster_locs;
     bool m_need_full_map;
+    bool m_compact_map;
+
+    vector<crawl_view_buffer> m_recorded_frames;
 
     coord_def m_cursor[CURSOR_MAX];
     coord_def m_last_clicked_grid;
@@ -320,6 +367,8 @@ protected:
 
     void _send_cursor(cursor_type type);
     void _send_map(bool force_full = false);
+    void _write_map_cells(bool force_full,
+                          map<uint32_t, coord_def>& new_monster_locs);
     void _send_cell(const coord_def &gc,
                     const screen_cell_t &current_sc, const screen_cell_t &next_sc,
                     const map_cell &current_mc, const map_cell &next_mc,
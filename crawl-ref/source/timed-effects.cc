@@ -432,7 +432,8 @@ static void _catchup_monster_move(monster* mon, int moves)
  * @param mon       The monster under consideration
  * @param turns     The number of offlevel player turns to simulate.
  */
-static void _catchup_monster_moves(monster* mon, int turns)
+static void _catchup_monster_moves(monster* mon, int turns,
+                                   const map_bitmask *arrival_reach)
 {
     // Summoned monsters might have disappeared.
     if (!mon->alive())
@@ -474,6 +475,16 @@ static void _catchup_monster_moves(monster* mon, int turns)
     if (mon_turns <= 0)
         return;
 
+    // Monsters walled off from wherever the player could be arriving just
+    // mill about, like ranged monsters keeping their distance below.
+    if (arrival_reach && !arrival_reach->get(mon->pos()))
+    {
+        mon->shift(mon->pos());
+        dprf("can't reach the player; shifted to (%d, %d)",
+             mon->pos().x, mon->pos().y);
+        return;
+    }
+
     // restore behaviour later if we start fleeing
     unwind_var<beh_type> saved_beh(mon->behaviour);
 
@@ -498,6 +509,50 @@ static void _catchup_monster_moves(monster* mon, int turns)
     dprf("moved to (%d, %d)", mon->pos().x, mon->pos().y);
 }
 
+/**
+ * Find where the catch-up moves of monsters could take them to somewhere the
+ * player might arrive: a stair, portal or hatch, or where the player left
+ * from. _catchup_monster_move() never steps onto a solid feature, so
+ * monsters outside this can't get near the player however long they walk.
+ *
+ * @param[out] reach  Set to the cells connected to an arrival cell.
+ * @return            Whether there were any arrival cells; if not, nothing
+ *                    can be ruled out.
+ */
+static bool _find_arrival_reach(map_bitmask &reach)
+{
+    reach.reset();
+    vector<coord_def> queue;
+    const auto add = [&](const coord_def &c)
+    {
+        if (!reach.get(c) && !feat_is_solid(env.grid(c)))
+        {
+            reach.set(c);
+            queue.push_back(c);
+        }
+    };
+
+    for (rectangle_iterator ri(0); ri; ++ri)
+        if (feat_is_stair(env.grid(*ri)))
+            add(*ri);
+    if (in_bounds(env.old_player_pos))
+        add(env.old_player_pos);
+    if (in_bounds(you.pos()))
+        add(you.pos());
+
+    if (queue.empty())
+        return false;
+
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        const coord_def c = queue[i];
+        for (adjacent_iterator ai(c); ai; ++ai)
+            if (in_bounds(*ai))
+                add(*ai);
+    }
+    return true;
+}
+
 /**
  * Update a monster's enchantments when the player returns
  * to the level.
@@ -527,13 +582,21 @@ void monster::timeout_enchantments(int levels)
     if (enchantments.empty())
         return;
 
-    const mon_enchant_list ec = enchantments;
-    for (auto &entry : ec)
+    // Go through the enchantments there were to begin with, skipping those
+    // that went away along with an earlier one.
+    enchant_type present[NUM_ENCHANTMENTS];
+    const int num_present = enchantments.list_types(present);
+    for (int i = 0; i < num_present; ++i)
     {
-        if (entry.second.duration >= INFINITE_DURATION)
+        const mon_enchant *current = enchantments.find(present[i]);
+        if (!current)
+            continue;
+        const mon_enchant me = *current;
+
+        if (me.duration >= INFINITE_DURATION)
             continue;
 
-        switch (entry.first)
+        switch (me.ench)
         {
         case ENCH_POISON: case ENCH_CORONA: case ENCH_CONTAM:
         case ENCH_STICKY_FLAME: case ENCH_SUMMON_TIMER:
@@ -557,12 +620,12 @@ void monster::timeout_enchantments(int levels)
         case ENCH_SLOW: case ENCH_WEAK: case ENCH_EMPOWERED_SPELLS:
         case ENCH_BOUND: case ENCH_CONCENTRATE_VENOM: case ENCH_TOXIC_RADIANCE:
         case ENCH_PAIN_BOND:
-            lose_ench_levels(entry.second, levels);
+            lose_ench_levels(me, levels);
             break;
 
         case ENCH_INVIS:
             if (!mons_class_flag(type, M_INVIS))
-                lose_ench_levels(entry.second, levels);
+                lose_ench_levels(me, levels);
             break;
 
         case ENCH_FRENZIED:
@@ -573,22 +636,22 @@ void monster::timeout_enchantments(int levels)
         case ENCH_INFESTATION:
         case ENCH_HELD:
         case ENCH_BULLSEYE_TARGET:
-            del_ench(entry.first);
+            del_ench(me.ench);
             break;
 
         case ENCH_FATIGUE:
-            del_ench(entry.first);
+            del_ench(me.ench);
             del_ench(ENCH_SLOW);
             break;
 
         case ENCH_TP:
             teleport(true);
-            del_ench(entry.first);
+            del_ench(me.ench);
             break;
 
         case ENCH_CONFUSION:
             if (!mons_class_flag(type, M_CONFUSED))
-                del_ench(entry.first);
+                del_ench(me.ench);
             // That triggered a behaviour_event, which could have made a
             // pacified monster leave the level.
             if (alive() && !is_stationary())
@@ -598,14 +661,14 @@ void monster::timeout_enchantments(int levels)
         case ENCH_TIDE:
         {
             const int actdur = speed_to_duration(speed) * levels;
-            lose_ench_duration(entry.first, actdur);
+            lose_ench_duration(me.ench, actdur);
             break;
         }
 
         case ENCH_SLOWLY_DYING:
         {
             const int actdur = speed_to_duration(speed) * levels;
-            if (lose_ench_duration(entry.first, actdur))
+            if (lose_ench_duration(me.ench, actdur))
                 monster_die(*this, KILL_NON_ACTOR, NON_MONSTER, true);
             break;
         }
@@ -619,6 +682,58 @@ void monster::timeout_enchantments(int levels)
     }
 }
 
+/**
+ * Update the monster upon the player's return
+ *
+ * @param mon   The monster to update.
+ * @param turns How many turns (not auts) since the monster left the player
+ * @param arrival_reach  If not null, where the monster could walk to the
+ *                       player from; monsters elsewhere aren't moved towards
+ *                       their target.
+ * @returns     Returns nullptr if monster was destroyed by the update;
+ *              Returns the updated monster if it still exists.
+ */
+static monster* _update_monster(monster& mon, int turns,
+                                const map_bitmask *arrival_reach)
+{
+    // Pacified monsters often leave the level now.
+    if (mon.pacified() && turns > random2(40) + 21)
+    {
+        make_mons_leave_level(&mon);
+        return nullptr;
+    }
+
+    // Ignore monsters flagged to skip their next action
+    if (mon.flags & MF_JUST_SUMMONED)
+        return &mon;
+
+    // XXX: Allow some spellcasting (like Healing and Teleport)? - bwr
+    // const bool healthy = (mon->hit_points * 2 > mon->max_hit_points);
+
+    mon.heal(div_rand_round(turns * mon.off_level_regen_rate(), 100));
+
+    // Handle nets specially to remove the trapping property of the net.
+    if (mon.caught())
+        mon.del_ench(ENCH_HELD, true);
+
+    _catchup_monster_moves(&mon, turns, arrival_reach);
+
+    mon.foe_memory = max(mon.foe_memory - turns, 0);
+
+    // FIXME:  Convert literal string 10 to constant to convert to auts
+    if (turns >= 10 && mon.alive())
+        mon.timeout_enchantments(turns / 10);
+
+    return &mon;
+}
+
+// For a monster catching up by itself, such as one following the player from
+// another level.
+monster* update_monster(monster& mon, int turns)
+{
+    return _update_monster(mon, turns, nullptr);
+}
+
 /**
  * Update the level upon the player's return.
  *
@@ -653,14 +768,21 @@ void update_level(int elapsedTime)
     dungeon_events.fire_event(
         dgn_event(DET_TURN_ELAPSED, coord_def(0, 0), turns * 10));
 
+    // Work out once, for every monster, which could walk to the player.
+    map_bitmask arrival_reach;
+    const bool have_arrival = _find_arrival_reach(arrival_reach);
+
     for (monster_iterator mi; mi; ++mi)
     {
 #ifdef DEBUG_DIAGNOSTICS
         mons_total++;
 #endif
 
-        if (!update_monster(**mi, turns))
+        if (!_update_monster(**mi, turns,
+                             have_arrival ? &arrival_reach : nullptr))
+        {
             continue;
+        }
     }
 
 #ifdef DEBUG_DIAGNOSTICS
@@ -670,47 +792,6 @@ void update_level(int elapsedTime)
     delete_all_clouds();
 }
 
-/**
- * Update the monster upon the player's return
- *
- * @param mon   The monster to update.
- * @param turns How many turns (not auts) since the monster left the player
- * @returns     Returns nullptr if monster was destroyed by the update;
- *              Returns the updated monster if it still exists.
- */
-monster* update_monster(monster& mon, int turns)
-{
-    // Pacified monsters often leave the level now.
-    if (mon.pacified() && turns > random2(40) + 21)
-    {
-        make_mons_leave_level(&mon);
-        return nullptr;
-    }
-
-    // Ignore monsters flagged to skip their next action
-    if (mon.flags & MF_JUST_SUMMONED)
-        return &mon;
-
-    // XXX: Allow some spellcasting (like Healing and Teleport)? - bwr
-    // const bool healthy = (mon->hit_points * 2 > mon->max_hit_points);
-
-    mon.heal(div_rand_round(turns * mon.off_level_regen_rate(), 100));
-
-    // Handle nets specially to remove the trapping property of the net.
-    if (mon.caught())
-        mon.del_ench(ENCH_HELD, true);
-
-    _catchup_monster_moves(&mon, turns);
-
-    mon.foe_memory = max(mon.foe_memory - turns, 0);
-
-    // FIXME:  Convert literal string 10 to constant to convert to auts
-    if (turns >= 10 && mon.alive())
-        mon.timeout_enchantments(turns / 10);
-
-    return &mon;
-}
-
 static void _drop_tomb(const coord_def& pos, bool premature, bool zin)
 {
     int count = 0;
@@ -50,6 +50,7 @@
 #include "output.h"
 #include "place.h"
 #include "prompt.h"
+#include "raymask.h" // ray_mask_lowest_bit
 #include "religion.h"
 #include "stairs.h"
 #include "state.h"
@@ -116,6 +117,10 @@ static level_id _Src_Level;
 // Remember the last place explore stopped because autopickup failed.
 static coord_def explore_stopped_pos;
 
+// Whether explore floods only as far as it needs to, and keeps its route
+// between steps (see explore_route).
+static bool _incremental_explore = true;
+
 // The place in the Vestibule of Hell where all portals to Hell land.
 static level_pos travel_hell_entry;
 
@@ -898,6 +903,204 @@ void explore_pickup_event(int did_pickup, int tried_pickup)
     }
 }
 
+// What a travel flood back from a destination looks at in a square.
+enum route_square_flags
+{
+    RS_COST_MASK            = 0x03, // _feature_traverse_cost()
+    RS_SAFE                 = 0x04, // is_travelsafe_square()
+    RS_LANDING              = 0x08, // a transporter landing
+    RS_EXCLUDED_TRANSPORTER = 0x10,
+};
+
+static uint8_t _route_square_state(const coord_def &c)
+{
+    const dungeon_feature_type feat = env.map_knowledge(c).feat();
+    uint8_t state = _feature_traverse_cost(feat);
+    if (is_travelsafe_square(c))
+        state |= RS_SAFE;
+    if (env.grid(c) == DNGN_TRANSPORTER_LANDING)
+        state |= RS_LANDING;
+    if (feat == DNGN_TRANSPORTER && is_excluded(c))
+        state |= RS_EXCLUDED_TRANSPORTER;
+    return state;
+}
+
+static bool _same_transporters(const vector<transporter_info> &a,
+                               const vector<transporter_info> &b)
+{
+    if (a.size() != b.size())
+        return false;
+    for (unsigned int i = 0; i < a.size(); ++i)
+    {
+        if (a[i].position != b[i].position
+            || a[i].destination != b[i].destination)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * The flood _find_travel_pos() makes back from the explore target to the
+ * player, kept from one explore step to the next.
+ *
+ * Until it reaches the player, that flood only depends on the squares it
+ * has looked at: how long each takes to cross, whether it's safe, and
+ * whether it's a transporter landing or an excluded transporter. The flood
+ * goes on to other squares the same way whichever of them the player is
+ * on, so it also finds the first move from every square it looked at on
+ * the way. While the squares looked at before such a square are as they
+ * were, the move from it is still the one a new flood would find, and the
+ * player can keep walking the route without flooding again. Squares that
+ * changed elsewhere on the level don't matter.
+ */
+class explore_route : public travel_pathfind
+{
+public:
+    explore_route(const coord_def &_target)
+        : target(_target), level(level_id::current())
+    {
+    }
+
+    // The next square to move to from from, as
+    // travel_pathfind::pathfind(RMODE_TRAVEL) would find it.
+    coord_def travel_move(const coord_def &from);
+
+    const coord_def target;
+    const level_id level;
+
+protected:
+    bool path_flood(const coord_def &c, const coord_def &dc) override;
+
+private:
+    struct route_square
+    {
+        coord_def pos;
+        uint8_t state;
+        // The square the flood first came from to this one, and how many
+        // squares it had looked at by then; unset if it never did.
+        coord_def move;
+        int looked_at;
+    };
+
+    void flood(const coord_def &from);
+    void look_at(const coord_def &c);
+    const route_square *reached(const coord_def &c) const;
+    bool unchanged(int looked_at);
+
+    // In the order the flood looked at them.
+    vector<route_square> squares;
+    // 1 + the index of each square in squares, or 0.
+    FixedArray<uint16_t, GXM, GYM> square_index;
+    vector<transporter_info> transporters;
+};
+
+coord_def explore_route::travel_move(const coord_def &from)
+{
+    // pathfind() gives up on these before flooding.
+    if (!in_bounds(target)
+        || !is_travelsafe_square(target, false, false, true)
+           && !is_trap(target))
+    {
+        return coord_def();
+    }
+    if (target == from)
+        return target;
+
+    const route_square *sq = reached(from);
+    if (!sq || !unchanged(sq->looked_at))
+    {
+        flood(from);
+        sq = reached(from);
+        if (!sq)
+            return coord_def();
+    }
+
+    return _is_safe_move(sq->move) ? sq->move : coord_def();
+}
+
+void explore_route::flood(const coord_def &from)
+{
+    squares.clear();
+    square_index.init(0);
+    transporters = travel_cache.get_level_info(level).get_transporters();
+
+    set_src_dst(from, target);
+    look_at(target);
+    pathfind(RMODE_TRAVEL);
+}
+
+void explore_route::look_at(const coord_def &c)
+{
+    uint16_t &index = square_index(c);
+    if (index)
+        return;
+    squares.push_back({ c, _route_square_state(c), coord_def(), 0 });
+    index = squares.size();
+}
+
+const explore_route::route_square *
+explore_route::reached(const coord_def &c) const
+{
+    const uint16_t index = square_index(c);
+    if (!index || squares[index - 1].move.origin())
+        return nullptr;
+    return &squares[index - 1];
+}
+
+bool explore_route::unchanged(int looked_at)
+{
+    if (!_same_transporters(transporters,
+                            travel_cache.get_level_info(level)
+                                .get_transporters()))
+    {
+        return false;
+    }
+
+    unwind_bool slime_wall_check(g_Slime_Wall_Check,
+                                 !actor_slime_wall_immune(&you));
+    for (int i = 0; i < looked_at; ++i)
+        if (_route_square_state(squares[i].pos) != squares[i].state)
+            return false;
+    return true;
+}
+
+bool explore_route::path_flood(const coord_def &c, const coord_def &dc)
+{
+    if (in_bounds(dc))
+    {
+        look_at(dc);
+        // This is where a flood towards dc would stop.
+        route_square &sq = squares[square_index(dc) - 1];
+        if (sq.move.origin() && !takes_excluded_transporter(c, dc))
+        {
+            sq.move = c;
+            sq.looked_at = squares.size();
+        }
+    }
+    return travel_pathfind::path_flood(c, dc);
+}
+
+static unique_ptr<explore_route> _explore_route;
+
+void set_incremental_explore(bool enabled)
+{
+    _incremental_explore = enabled;
+    _explore_route.reset();
+}
+
+static coord_def _explore_travel_move(const coord_def &youpos)
+{
+    if (!_explore_route
+        || _explore_route->target != you.running.pos
+        || _explore_route->level != level_id::current())
+    {
+        _explore_route = make_unique<explore_route>(you.running.pos);
+    }
+    return _explore_route->travel_move(youpos);
+}
+
 /**
  * Run the travel_pathfind algorithm with a destination with the aim of
  * determining the next travel move. Try to avoid to let travel (including
@@ -920,7 +1123,9 @@ static void _find_travel_pos(const coord_def& youpos, int *move_x, int *move_y)
 
     tp.set_src_dst(youpos, you.running.pos);
 
-    coord_def dest = tp.pathfind(RMODE_TRAVEL, false);
+    coord_def dest = _incremental_explore && you.running.is_explore()
+                     ? _explore_travel_move(youpos)
+                     : tp.pathfind(RMODE_TRAVEL, false);
     if (dest.origin())
         dest = tp.pathfind(RMODE_TRAVEL, true);
     coord_def new_dest = dest;
@@ -1257,7 +1462,18 @@ static bool _is_greed_inducing_square(const LevelStashes *ls,
 
 bool travel_pathfind::is_greed_inducing_square(const coord_def &c) const
 {
-    return _is_greed_inducing_square(ls, c, autopickup);
+    return greed_squares(c);
+}
+
+// Whether going from c to dc means taking a transporter the player has
+// excluded.
+bool travel_pathfind::takes_excluded_transporter(const coord_def &c,
+                                                 const coord_def &dc) const
+{
+    return !ignore_danger
+           && is_excluded(c)
+           && env.map_knowledge(c).feat() == DNGN_TRANSPORTER
+           && !adjacent(c, dc);
 }
 
 void travel_pathfind::set_src_dst(const coord_def &src, const coord_def &dst)
@@ -1335,6 +1551,15 @@ coord_def travel_pathfind::pathfind(run_mode_type rmode, bool fallback_explore)
     if (!ls && (annotate_map || need_for_greed))
         ls = StashTrack.find_current_level();
 
+    // Ask the stashes once which squares are worth a visit, rather than
+    // for every square the flood reaches.
+    if (need_for_greed)
+    {
+        greed_squares.reset();
+        if (ls)
+            ls->mark_visit_squares(greed_squares, autopickup);
+    }
+
     next_travel_move.reset();
 
     // For greedy explore, keep track of the closest unexplored territory and
@@ -1694,19 +1919,26 @@ bool travel_pathfind::path_flood(const coord_def &c, const coord_def &dc)
         // implies greedy-explore.
         if (unexplored_dist != UNFOUND_DIST && greedy_dist != UNFOUND_DIST)
             return true;
+
+        // Squares are examined in order of distance, so with no items or
+        // walls to weigh against it, no unexplored square found later
+        // could replace the first one: stop here rather than flooding the
+        // rest of the level.
+        if (_incremental_explore
+            && unexplored_dist != UNFOUND_DIST
+            && !need_for_greed
+            && !Options.explore_wall_bias
+            && !ignore_hostile)
+        {
+            return true;
+        }
     }
 
     // We don't want to follow the transporter at c if it's excluded. We also
     // don't want to update point_distance for the destination based on
     // taking this transporter.
-    if (!ignore_danger
-        && is_excluded(c)
-        && env.map_knowledge(c).feat() == DNGN_TRANSPORTER
-        // We have to actually take the transporter to go from c to dc.
-        && !adjacent(c, dc))
-    {
+    if (takes_excluded_transporter(c, dc))
         return false;
-    }
     else if (dc == dest)
     {
         // Hallelujah, we're home!
@@ -1884,6 +2116,257 @@ int travel_pathfind::explore_status()
 }
 
 
+// The cells of the map as rows of bits, x along each row.
+struct travel_bitboard
+{
+    static const int WORDS = (GXM + 63) / 64;
+    uint64_t rows[GYM][WORDS];
+
+    void reset()
+    {
+        memset(rows, 0, sizeof(rows));
+    }
+
+    bool get(const coord_def &c) const
+    {
+        return rows[c.y][c.x / 64] >> (c.x % 64) & 1;
+    }
+
+    void set(const coord_def &c)
+    {
+        rows[c.y][c.x / 64] |= uint64_t(1) << (c.x % 64);
+    }
+
+    // Sets row y of out to the cells of this board in or next to that row,
+    // including diagonally.
+    void neighbours(int y, uint64_t *out) const
+    {
+        uint64_t column[WORDS];
+        for (int w = 0; w < WORDS; ++w)
+        {
+            column[w] = rows[y][w];
+            if (y > 0)
+                column[w] |= rows[y - 1][w];
+            if (y < GYM - 1)
+                column[w] |= rows[y + 1][w];
+        }
+        for (int w = 0; w < WORDS; ++w)
+        {
+            uint64_t left = column[w] << 1;
+            uint64_t right = column[w] >> 1;
+            if (w > 0)
+                left |= column[w - 1] >> 63;
+            if (w < WORDS - 1)
+                right |= column[w + 1] << 63;
+            out[w] = column[w] | left | right;
+        }
+    }
+};
+
+static bool _bitboard_travel = true;
+
+// What travel_pathfind needs to know about the current level to fill
+// travel_point_distance as fill_travel_point_distance() does, kept as bit
+// rows so that a whole row of the flood can be taken at once. Setting it up
+// looks at every square of the level, so it only pays for itself over the
+// floods from every stair in update_stair_distances(), which share one as
+// long as the level doesn't change in between.
+class travel_bitboard_flood
+{
+public:
+    travel_bitboard_flood();
+    void fill(const coord_def &start) const;
+
+private:
+    // Squares that are safe to travel over, and those that take two and
+    // three turns to move off.
+    travel_bitboard safe, slow2, slow3;
+    // What path_flood() marks unsafe squares with when it reaches them;
+    // zero if it leaves them alone.
+    FixedArray<int, GXM, GYM> unsafe_mark;
+    // Known transporters that travel will go through, and where to.
+    vector<pair<coord_def, coord_def>> transporters;
+};
+
+travel_bitboard_flood::travel_bitboard_flood()
+{
+    // As in travel_pathfind::pathfind().
+    unwind_bool slime_wall_check(g_Slime_Wall_Check,
+                                 !actor_slime_wall_immune(&you));
+    unwind_slime_wall_precomputer slime_neighbours(g_Slime_Wall_Check);
+
+    safe.reset();
+    slow2.reset();
+    slow3.reset();
+    unsafe_mark.init(0);
+    for (rectangle_iterator ri(1); ri; ++ri)
+    {
+        const coord_def c = *ri;
+        if (is_travelsafe_square(c, false, false, true))
+            safe.set(c);
+        else if (_is_reseedable(c))
+        {
+            unsafe_mark(c) = is_exclude_root(c)   ? PD_EXCLUDED :
+                             is_excluded(c)       ? PD_EXCLUDED_RADIUS :
+                             !_is_safe_cloud(c)   ? PD_CLOUD
+                                                  : PD_TRAP;
+        }
+
+        const int cost =
+            _feature_traverse_cost(env.map_knowledge(c).feat());
+        if (cost == 2)
+            slow2.set(c);
+        else if (cost == 3)
+            slow3.set(c);
+    }
+
+    LevelInfo *li = travel_cache.find_level_info(level_id::current());
+    if (!li)
+        return;
+    for (const transporter_info &ti : li->get_transporters())
+    {
+        const coord_def c = ti.position;
+        if (!in_bounds(c) || env.grid(c) != DNGN_TRANSPORTER
+            || ti.destination == INVALID_COORD
+            || !in_bounds(ti.destination))
+        {
+            continue;
+        }
+        // path_flood() won't take an excluded transporter.
+        if (is_excluded(c)
+            && env.map_knowledge(c).feat() == DNGN_TRANSPORTER
+            && !adjacent(c, ti.destination))
+        {
+            continue;
+        }
+        transporters.emplace_back(c, ti.destination);
+    }
+}
+
+// A square of travel distance d that takes k turns to move off is moved off
+// k rounds later, so the squares moved off in round r are kept in bucket
+// r % 4, and every square newly reached from them in that round has
+// distance r. This gives every square the distance pathfind() gives it,
+// since that doesn't depend on the order it takes squares in.
+void travel_bitboard_flood::fill(const coord_def &start) const
+{
+    memset(travel_point_distance, 0, sizeof(travel_distance_grid_t));
+    if (!in_bounds(start))
+        return;
+
+    static travel_bitboard buckets[4];
+    static travel_bitboard reached, moved_off;
+    for (travel_bitboard &bucket : buckets)
+        bucket.reset();
+    reached.reset();
+    moved_off.reset();
+
+    auto cost = [this](const coord_def &c)
+    {
+        return slow3.get(c) ? 3 : slow2.get(c) ? 2 : 1;
+    };
+
+    int pending[4] = { 0, 0, 0, 0 };
+    buckets[cost(start) % 4].set(start);
+    pending[cost(start) % 4]++;
+    int total_pending = 1;
+
+    for (int round = 1; total_pending; ++round)
+    {
+        travel_bitboard &now = buckets[round % 4];
+        if (!pending[round % 4])
+            continue;
+        total_pending -= pending[round % 4];
+        pending[round % 4] = 0;
+
+        uint64_t next[GYM][travel_bitboard::WORDS];
+        for (int y = 0; y < GYM; ++y)
+        {
+            now.neighbours(y, next[y]);
+            for (int w = 0; w < travel_bitboard::WORDS; ++w)
+            {
+                moved_off.rows[y][w] |= now.rows[y][w];
+                // Only the start can be moved off before being reached,
+                // and then it isn't next to itself.
+                next[y][w] &= safe.rows[y][w]
+                              & ~(reached.rows[y][w] | now.rows[y][w]);
+            }
+        }
+        for (const auto &trans : transporters)
+        {
+            const coord_def &dest = trans.second;
+            if (now.get(trans.first) && safe.get(dest) && !reached.get(dest))
+                next[dest.y][dest.x / 64] |= uint64_t(1) << (dest.x % 64);
+        }
+        now.reset();
+
+        for (int y = 0; y < GYM; ++y)
+            for (int w = 0; w < travel_bitboard::WORDS; ++w)
+            {
+                reached.rows[y][w] |= next[y][w];
+                for (uint64_t bits = next[y][w]; bits; bits &= bits - 1)
+                {
+                    const coord_def c(w * 64 + ray_mask_lowest_bit(bits), y);
+                    travel_point_distance[c.x][c.y] = round;
+                    const int when = (round + cost(c)) % 4;
+                    buckets[when].set(c);
+                    pending[when]++;
+                    total_pending++;
+                }
+            }
+    }
+
+    // Unsafe squares next to where the flood went get marked, apart from
+    // the start. The start can only have been reached again if safe.
+    for (int y = 0; y < GYM; ++y)
+    {
+        uint64_t near[travel_bitboard::WORDS];
+        moved_off.neighbours(y, near);
+        for (int w = 0; w < travel_bitboard::WORDS; ++w)
+            for (uint64_t bits = near[w] & ~safe.rows[y][w]; bits;
+                 bits &= bits - 1)
+            {
+                const coord_def c(w * 64 + ray_mask_lowest_bit(bits), y);
+                if (in_bounds(c) && c != start)
+                    travel_point_distance[c.x][c.y] = unsafe_mark(c);
+            }
+    }
+    for (const auto &trans : transporters)
+    {
+        const coord_def &dest = trans.second;
+        if (moved_off.get(trans.first) && !safe.get(dest) && dest != start)
+            travel_point_distance[dest.x][dest.y] = unsafe_mark(dest);
+    }
+}
+
+void set_bitboard_travel(bool enabled)
+{
+    _bitboard_travel = enabled;
+}
+
+// Fill travel_point_distance from start both ways, and return how many
+// squares they disagree about. Leaves what travel_pathfind found.
+int bitboard_travel_mismatches(const coord_def &start)
+{
+    travel_bitboard_flood().fill(start);
+    static travel_distance_grid_t bitboard_distance;
+    memcpy(bitboard_distance, travel_point_distance,
+           sizeof(travel_distance_grid_t));
+
+    fill_travel_point_distance(start);
+
+    int mismatches = 0;
+    for (rectangle_iterator ri(0); ri; ++ri)
+    {
+        if (bitboard_distance[ri->x][ri->y]
+            != travel_point_distance[ri->x][ri->y])
+        {
+            ++mismatches;
+        }
+    }
+    return mismatches;
+}
+
 /**
  * Run the travel_pathfind algorithm, from the given position in floodout mode
  * to populate travel_point_distance relative to that starting point.
@@ -3164,8 +3647,37 @@ static int _find_transtravel_stair(const level_id &cur,
     return local_distance;
 }
 
+// The distance to pos from the start of the last travel_point_distance
+// fill, or -1 if it can't be reached.
+static int _filled_distance(const coord_def &start, const coord_def &pos)
+{
+    const int dist = travel_point_distance[pos.x][pos.y];
+    if (!dist && start != pos || dist < -1)
+        return -1;
+    return dist;
+}
+
+static void _set_stair_distances(const level_pos &target)
+{
+    curr_stairs.clear();
+    for (stair_info si : travel_cache.get_level_info(target.id).get_stairs())
+    {
+        si.distance = _filled_distance(target.pos, si.position);
+        curr_stairs.push_back(si);
+    }
+}
+
 static bool _loadlev_populate_stair_distances(const level_pos &target)
 {
+    // Rather than loading the whole level, use what we remember of its
+    // layout if we can.
+    const LevelInfo *li = travel_cache.find_level_info(target.id);
+    if (li && li->fill_layout_distance(target.pos))
+    {
+        _set_stair_distances(target);
+        return true;
+    }
+
     level_excursion excursion;
     excursion.go_to(target.id);
     _populate_stair_distances(target);
@@ -3176,19 +3688,42 @@ static void _populate_stair_distances(const level_pos &target)
 {
     // Populate travel_point_distance.
     fill_travel_point_distance(target.pos);
+    _set_stair_distances(target);
+}
 
-    curr_stairs.clear();
-    for (stair_info si : travel_cache.get_level_info(target.id).get_stairs())
+// Work out the distances between the stairs of a level from its recorded
+// layout, and again by flooding the level itself (visiting it if need be),
+// and return how many differ; -1 if there is no recorded layout.
+int layout_distance_mismatches(const level_id &lid)
+{
+    LevelInfo *li = travel_cache.find_level_info(lid);
+    if (!li)
+        return -1;
+    // The excursion might update the level's info.
+    const vector<stair_info> stairs = li->get_stairs();
+
+    vector<int> from_layout;
+    for (const stair_info &from : stairs)
     {
-        si.distance = travel_point_distance[si.position.x][si.position.y];
-        if (!si.distance && target.pos != si.position
-            || si.distance < -1)
-        {
-            si.distance = -1;
-        }
+        if (!li->fill_layout_distance(from.position))
+            return -1;
+        for (const stair_info &to : stairs)
+            from_layout.push_back(_filled_distance(from.position, to.position));
+    }
 
-        curr_stairs.push_back(si);
+    level_excursion excursion;
+    excursion.go_to(lid);
+
+    int mismatches = 0;
+    auto expected = from_layout.begin();
+    for (const stair_info &from : stairs)
+    {
+        fill_travel_point_distance(from.position);
+        for (const stair_info &to : stairs)
+            if (*expected++ != _filled_distance(from.position, to.position))
+                ++mismatches;
     }
+    return mismatches;
 }
 
 static coord_def _find_closest_adj(coord_def targ)
@@ -3359,6 +3894,7 @@ void start_explore(bool grab_items)
     }
 
     you.running = (grab_items ? RMODE_EXPLORE_GREEDY : RMODE_EXPLORE);
+    _explore_route.reset();
 
     for (rectangle_iterator ri(0); ri; ++ri)
         if (env.map_knowledge(*ri).seen())
@@ -3600,9 +4136,119 @@ void LevelInfo::update()
     get_transporters(transporter_positions);
     correct_transporter_list(transporter_positions);
 
+    update_layout();
+
     update_daction_counters(this);
 }
 
+// Values in LevelInfo::layout: the cost of moving off a square, as given by
+// _feature_traverse_cost(), and whether travel will go there.
+static const uint16_t LAYOUT_COST_MASK = 0x3;
+static const uint16_t LAYOUT_SAFE = 0x4;
+static const int LAYOUT_RUN_BITS = 13;
+static const uint16_t LAYOUT_MAX_RUN = (1 << LAYOUT_RUN_BITS) - 1;
+
+typedef FixedArray<uint8_t, GXM, GYM> travel_layout_grid;
+
+// Called from update(), while the travel safety grid is in use, so that
+// squares are safe if and only if they were for update_stair_distances().
+void LevelInfo::update_layout()
+{
+    layout.clear();
+    uint16_t value = 0;
+    uint16_t run = 0;
+    for (int y = 0; y < GYM; ++y)
+        for (int x = 0; x < GXM; ++x)
+        {
+            const coord_def p(x, y);
+            const uint16_t here =
+                _feature_traverse_cost(env.map_knowledge(p).feat())
+                | (is_travelsafe_square(p) ? LAYOUT_SAFE : 0);
+            if (run && (here != value || run == LAYOUT_MAX_RUN))
+            {
+                layout.push_back(value << LAYOUT_RUN_BITS | run);
+                run = 0;
+            }
+            value = here;
+            ++run;
+        }
+    layout.push_back(value << LAYOUT_RUN_BITS | run);
+}
+
+static void _decode_layout(const vector<uint16_t> &layout,
+                           travel_layout_grid &grid)
+{
+    int i = 0;
+    for (uint16_t entry : layout)
+    {
+        const uint8_t value = entry >> LAYOUT_RUN_BITS;
+        for (int end = i + (entry & LAYOUT_MAX_RUN); i < end; ++i)
+            grid[i % GXM][i / GXM] = value;
+    }
+    ASSERT(i == GXM * GYM);
+}
+
+// The same flood as travel_pathfind::pathfind() does for
+// fill_travel_point_distance(), giving each square the same distance,
+// but without marking the squares it can't cross. The transporters are the
+// ones the level info knows, which update() keeps to those on the level.
+// layout_distance_mismatches() checks the result against the level.
+bool LevelInfo::fill_layout_distance(const coord_def &pos) const
+{
+    if (layout.empty())
+        return false;
+
+    static travel_layout_grid grid;
+    _decode_layout(layout, grid);
+
+    memset(travel_point_distance, 0, sizeof(travel_distance_grid_t));
+    if (!in_bounds(pos))
+        return true;
+
+    vector<coord_def> circumference[2];
+    int circ_index = 0;
+    circumference[circ_index].push_back(pos);
+
+    for (int traveled_distance = 1; !circumference[circ_index].empty();
+         ++traveled_distance, circ_index = !circ_index)
+    {
+        vector<coord_def> &next = circumference[!circ_index];
+        auto flood = [&](const coord_def &dc)
+        {
+            if (in_bounds(dc) && (grid(dc) & LAYOUT_SAFE)
+                && !travel_point_distance[dc.x][dc.y])
+            {
+                travel_point_distance[dc.x][dc.y] = traveled_distance;
+                next.push_back(dc);
+            }
+        };
+
+        for (const coord_def &c : circumference[circ_index])
+        {
+            // Squares that are slow to move off are put off until later,
+            // as in square_slows_movement().
+            const int cost = grid(c) & LAYOUT_COST_MASK;
+            if (cost > 1
+                && travel_point_distance[c.x][c.y] > traveled_distance - cost)
+            {
+                next.push_back(c);
+                continue;
+            }
+
+            // As in path_examine_point(), which takes a transporter from
+            // the start even if it isn't safe to travel over.
+            for (int dir = 0; dir < 8; (dir += 2) == 8 && (dir = 1))
+                flood(c + Compass[dir]);
+
+            for (const transporter_info &ti : transporters)
+                if (ti.position == c && ti.destination != INVALID_COORD)
+                    flood(ti.destination);
+        }
+        circumference[circ_index].clear();
+    }
+    return true;
+}
+
 void LevelInfo::set_distance_between_stairs(int a, int b, int dist)
 {
     // Note dist == 0 is illegal because we can't have two stairs on
@@ -3616,6 +4262,11 @@ void LevelInfo::set_distance_between_stairs(int a, int b, int dist)
 void LevelInfo::update_stair_distances()
 {
     const int nstairs = stairs.size();
+    // The level doesn't change between floods, so they can all share one.
+    unique_ptr<travel_bitboard_flood> flood;
+    if (_bitboard_travel && nstairs > 1)
+        flood = make_unique<travel_bitboard_flood>();
+
     // Now we update distances for all the stairs, relative to all other
     // stairs.
     for (int s = 0; s < nstairs - 1; ++s)
@@ -3624,7 +4275,10 @@ void LevelInfo::update_stair_distances()
 
         // For each stair, we need to ask travel to populate the distance
         // array.
-        fill_travel_point_distance(stairs[s].position);
+        if (flood)
+            flood->fill(stairs[s].position);
+        else
+            fill_travel_point_distance(stairs[s].position);
 
         // Assume movement distance between stairs is commutative,
         // i.e. going from a->b is the same distance as b->a.
@@ -4011,6 +4665,10 @@ void LevelInfo::save(writer& outf) const
     marshallByte(outf, NUM_DACTION_COUNTERS);
     for (int i = 0; i < NUM_DACTION_COUNTERS; i++)
         marshallShort(outf, daction_counters[i]);
+
+    marshallUnsigned(outf, layout.size());
+    for (uint16_t run : layout)
+        marshallUnsigned(outf, run);
 }
 
 void LevelInfo::load(reader& inf, int minorVersion)
@@ -4062,6 +4720,19 @@ void LevelInfo::load(reader& inf, int minorVersion)
     ASSERT_RANGE(n_count, 0, NUM_DACTION_COUNTERS + 1);
     for (int i = 0; i < n_count; i++)
         daction_counters[i] = unmarshallShort(inf);
+
+    layout.clear();
+#if TAG_MAJOR_VERSION == 34
+    if (minorVersion >= TAG_MINOR_TRAVEL_LAYOUT)
+    {
+#endif
+    const size_t layout_size = unmarshallUnsigned(inf);
+    layout.reserve(layout_size);
+    for (size_t i = 0; i < layout_size; ++i)
+        layout.push_back(unmarshallUnsigned(inf));
+#if TAG_MAJOR_VERSION == 34
+    }
+#endif
 }
 
 void LevelInfo::fixup()
@@ -5221,6 +5892,8 @@ void clear_travel_trail()
     for (coord_def c : env.travel_trail)
         tiles.update_minimap(c);
 #endif
+    if (!env.travel_trail.empty())
+        view_mark_all_dirty();
     env.travel_trail.clear();
 }
 
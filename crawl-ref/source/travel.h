@@ -78,6 +78,22 @@ bool is_unknown_transporter(const coord_def &p);
 void fill_travel_point_distance(const coord_def& youpos,
                      vector<coord_def>* coords = nullptr);
 
+// How many of the distances between the stairs of a level differ when
+// worked out from its recorded layout rather than the level itself; -1 if
+// it has no recorded layout.
+int layout_distance_mismatches(const level_id &lid);
+
+// Whether stair distances are worked out by flooding a row of squares at a
+// time rather than with fill_travel_point_distance(); both give the same
+// distances.
+void set_bitboard_travel(bool enabled);
+int bitboard_travel_mismatches(const coord_def &start);
+
+// Whether explore stops flooding at the nearest unexplored square and
+// keeps its route to the explore target between steps; explore goes the
+// same way either way.
+void set_incremental_explore(bool enabled);
+
 bool is_stair_exclusion(const coord_def &p);
 
 /* ***********************************************************************
@@ -329,7 +345,7 @@ public:
 // Information on a level that interlevel travel needs.
 struct LevelInfo
 {
-    LevelInfo() : stairs(), excludes(), stair_distances(), id()
+    LevelInfo() : stairs(), excludes(), stair_distances(), layout(), id()
     {
         daction_counters.init(0);
     }
@@ -383,6 +399,12 @@ struct LevelInfo
     // current level.
     bool is_known_branch(uint8_t branch) const;
 
+    // Fills travel_point_distance with how far it is from pos to each
+    // square of this level, as fill_travel_point_distance() would have on
+    // the level, but using what the last update() recorded of its layout
+    // instead of loading it. Returns false if nothing was recorded.
+    bool fill_layout_distance(const coord_def &pos) const;
+
     FixedVector<int, NUM_DACTION_COUNTERS> daction_counters;
 
 private:
@@ -394,6 +416,7 @@ private:
     void correct_stair_list(const vector<coord_def> &s);
     void correct_transporter_list(const vector<coord_def> &s);
     void update_stair_distances();
+    void update_layout();
     void sync_all_branch_stairs();
     void sync_branch_stairs(const stair_info *si);
     void set_distance_between_stairs(int a, int b, int dist);
@@ -407,6 +430,11 @@ private:
     exclude_set excludes;
 
     vector<short> stair_distances;  // Dist between stairs
+
+    // Which squares were safe to travel over at the last update(), and how
+    // long each takes to cross, run-length encoded in row order. Each run
+    // has the layout value in its top bits and its length below.
+    vector<uint16_t> layout;
     level_id id;
 
     friend class TravelCache;
@@ -539,6 +567,8 @@ public:
 
 protected:
     bool is_greed_inducing_square(const coord_def &c) const;
+    bool takes_excluded_transporter(const coord_def &c,
+                                    const coord_def &dc) const;
     bool path_examine_point(const coord_def &c);
     virtual bool point_traverse_delay(const coord_def &c);
     virtual bool path_flood(const coord_def &c, const coord_def &dc);
@@ -587,6 +617,9 @@ protected:
     // Can we autopickup?
     bool autopickup;
 
+    // For greedy explore, the squares ls says are worth a visit.
+    map_bitmask greed_squares;
+
     // Targets for explore and greedy explore.
     coord_def unexplored_place, greedy_place;
 
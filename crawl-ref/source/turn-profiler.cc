@@ -0,0 +1,396 @@
+/**
+ * @file
+ * @brief Timing of the phases of world_reacts(), for finding slow turns.
+**/
+
+#include "AppHdr.h"
+
+#include "turn-profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <vector>
+
+#include "files.h"
+#include "losglobal.h"
+#include "message.h"
+#include "mon-util.h"
+#include "options.h"
+#include "player.h"
+#include "prompt.h"
+#include "stringutil.h"
+#include "syscalls.h"
+
+static bool _totalling = false;
+static map<string, turn_profile_total> _phase_totals;
+static map<spell_type, turn_profile_total> _spell_totals;
+
+#ifdef TURN_PROFILER
+
+struct turn_profile_event
+{
+    const char *phase;
+    monster_type mon;
+    int turn;
+    int depth;          // how many scopes this one is inside
+    int64_t start;      // nanoseconds since profiling started
+    int64_t nsecs;
+};
+
+// The most recent events; once full, new events replace the oldest.
+static const size_t MAX_EVENTS = 1 << 16;
+static vector<turn_profile_event> _events;
+static size_t _next_event = 0;
+
+static bool _running = false;
+static int _depth = 0;
+static int64_t _epoch = 0;
+static string _trace_file;
+
+#endif
+
+static int64_t _profile_now()
+{
+    return chrono::duration_cast<chrono::nanoseconds>(
+        chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool _recording()
+{
+#ifdef TURN_PROFILER
+    return _running || _totalling;
+#else
+    return _totalling;
+#endif
+}
+
+turn_profile_scope::turn_profile_scope(const char *_phase, monster_type _mon,
+                                       spell_type _spell)
+    : phase(_phase), mon(_mon), spell(_spell),
+      start(_recording() ? _profile_now() : -1)
+{
+#ifdef TURN_PROFILER
+    if (start >= 0)
+        _depth++;
+#endif
+}
+
+turn_profile_scope::~turn_profile_scope()
+{
+    if (start < 0)
+        return;
+
+    const int64_t nsecs = _profile_now() - start;
+    if (_totalling)
+    {
+        _phase_totals[phase].add(nsecs);
+        if (spell != SPELL_NO_SPELL)
+            _spell_totals[spell].add(nsecs);
+    }
+
+#ifdef TURN_PROFILER
+    _depth--;
+    if (!_running)
+        return;
+
+    turn_profile_event &ev = _events[_next_event++ % MAX_EVENTS];
+    ev.phase = phase;
+    ev.mon = mon;
+    ev.turn = you.num_turns;
+    ev.depth = _depth;
+    ev.start = start - _epoch;
+    ev.nsecs = nsecs;
+#endif
+}
+
+void turn_profiler_start_totals()
+{
+    _phase_totals.clear();
+    _spell_totals.clear();
+    _totalling = true;
+}
+
+void turn_profiler_stop_totals()
+{
+    _totalling = false;
+}
+
+const map<string, turn_profile_total> &turn_profile_phase_totals()
+{
+    return _phase_totals;
+}
+
+const map<spell_type, turn_profile_total> &turn_profile_spell_totals()
+{
+    return _spell_totals;
+}
+
+#ifdef TURN_PROFILER
+
+// The recorded events, oldest first. Events are recorded when their scope
+// ends, so inner scopes come before the scopes they're inside.
+static vector<const turn_profile_event *> _recorded_events()
+{
+    vector<const turn_profile_event *> events;
+    const size_t count = min(_next_event, MAX_EVENTS);
+    for (size_t i = _next_event - count; i < _next_event; ++i)
+        events.push_back(&_events[i % MAX_EVENTS]);
+    return events;
+}
+
+static string _event_name(const turn_profile_event &ev)
+{
+    if (ev.mon != MONS_NO_MONSTER)
+        return mons_type_name(ev.mon, DESC_PLAIN);
+    return ev.phase;
+}
+
+static string _total_line(const string &name, const turn_profile_total &t)
+{
+    return make_stringf("  %-24s %7d %10.3f %9.1f %9.1f", name.c_str(),
+                        t.calls, t.nsecs / 1e6, t.nsecs / 1e3 / t.calls,
+                        t.max_nsecs / 1e3);
+}
+
+static vector<pair<string, turn_profile_total>>
+_by_total(const map<string, turn_profile_total> &totals)
+{
+    vector<pair<string, turn_profile_total>> sorted(totals.begin(),
+                                                    totals.end());
+    sort(sorted.begin(), sorted.end(),
+         [](const pair<string, turn_profile_total> &a,
+            const pair<string, turn_profile_total> &b)
+         {
+             return a.second.nsecs > b.second.nsecs;
+         });
+    return sorted;
+}
+
+static vector<string> _summary(size_t max_monsters, size_t max_turns)
+{
+    const vector<const turn_profile_event *> events = _recorded_events();
+    vector<string> lines;
+    if (events.empty())
+    {
+        lines.emplace_back("No turns have been profiled.");
+        return lines;
+    }
+
+    map<string, turn_profile_total> phases, monsters;
+    vector<const turn_profile_event *> turns;
+    for (const turn_profile_event *ev : events)
+    {
+        if (ev->mon != MONS_NO_MONSTER)
+            monsters[_event_name(*ev)].add(ev->nsecs);
+        else
+            phases[ev->phase].add(ev->nsecs);
+        if (!ev->depth)
+            turns.push_back(ev);
+    }
+
+    lines.push_back(make_stringf("Turn profile: %u events, %u turns "
+                                 "(%d to %d)%s",
+                                 (unsigned int) events.size(),
+                                 (unsigned int) turns.size(),
+                                 events.front()->turn, events.back()->turn,
+                                 _next_event > MAX_EVENTS ? ", oldest dropped"
+                                                          : ""));
+    const string header = make_stringf("  %-24s %7s %10s %9s %9s", "",
+                                       "calls", "total ms", "mean us",
+                                       "max us");
+    lines.push_back(header);
+    for (const auto &entry : _by_total(phases))
+        lines.push_back(_total_line(entry.first, entry.second));
+
+    if (!monsters.empty())
+    {
+        lines.emplace_back("Monster moves:");
+        const auto sorted = _by_total(monsters);
+        for (size_t i = 0; i < sorted.size() && i < max_monsters; ++i)
+            lines.push_back(_total_line(sorted[i].first, sorted[i].second));
+    }
+
+    sort(turns.begin(), turns.end(),
+         [](const turn_profile_event *a, const turn_profile_event *b)
+         {
+             return a->nsecs > b->nsecs;
+         });
+    if (turns.size() > max_turns)
+        turns.resize(max_turns);
+    if (!turns.empty())
+        lines.emplace_back("Slowest turns:");
+    for (const turn_profile_event *turn : turns)
+    {
+        // The phases directly inside this turn, slowest first.
+        map<string, turn_profile_total> inside;
+        for (const turn_profile_event *ev : events)
+        {
+            if (ev->depth == 1 && ev->start >= turn->start
+                && ev->start < turn->start + turn->nsecs)
+            {
+                inside[_event_name(*ev)].add(ev->nsecs);
+            }
+        }
+        vector<string> parts;
+        for (const auto &entry : _by_total(inside))
+        {
+            if (parts.size() == 3)
+                break;
+            parts.push_back(make_stringf("%s %.3f", entry.first.c_str(),
+                                         entry.second.nsecs / 1e6));
+        }
+        lines.push_back(make_stringf("  turn %d: %.3f ms (%s)", turn->turn,
+                                     turn->nsecs / 1e6,
+                                     join_strings(parts.begin(), parts.end(),
+                                                  ", ").c_str()));
+    }
+    return lines;
+}
+
+static string _json_escape(const string &s)
+{
+    string escaped;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            escaped += '\\';
+        escaped += c;
+    }
+    return escaped;
+}
+
+bool turn_profiler_write_trace(const string &filename)
+{
+    FILE *f = fopen_u(filename.c_str(), "w");
+    if (!f)
+        return false;
+
+    fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    for (const turn_profile_event *ev : _recorded_events())
+    {
+        fprintf(f, "%s{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\","
+                   "\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1,"
+                   "\"args\":{\"turn\":%d}}",
+                first ? "" : ",\n", _json_escape(_event_name(*ev)).c_str(),
+                ev->mon != MONS_NO_MONSTER ? "monster" : "phase",
+                ev->start / 1e3, ev->nsecs / 1e3, ev->turn);
+        first = false;
+    }
+    fprintf(f, "\n]}\n");
+    return fclose(f) == 0;
+}
+
+bool turn_profiler_available()
+{
+    return true;
+}
+
+bool turn_profiler_running()
+{
+    return _running;
+}
+
+void turn_profiler_start(const string &trace_file)
+{
+    _events.resize(MAX_EVENTS);
+    _next_event = 0;
+    _epoch = _profile_now();
+    _running = true;
+    if (!trace_file.empty())
+        _trace_file = trace_file;
+}
+
+void turn_profiler_stop()
+{
+    _running = false;
+}
+
+void turn_profiler_exit()
+{
+    if (_trace_file.empty())
+        return;
+
+    _running = false;
+    for (const string &line : _summary(20, 10))
+        fprintf(stderr, "%s\n", line.c_str());
+    if (turn_profiler_write_trace(_trace_file))
+        fprintf(stderr, "Wrote turn trace to %s\n", _trace_file.c_str());
+    else
+    {
+        fprintf(stderr, "Couldn't write turn trace to %s\n",
+                _trace_file.c_str());
+    }
+}
+
+#else
+
+bool turn_profiler_available()
+{
+    return false;
+}
+
+bool turn_profiler_running()
+{
+    return false;
+}
+
+void turn_profiler_start(const string &)
+{
+}
+
+void turn_profiler_stop()
+{
+}
+
+bool turn_profiler_write_trace(const string &)
+{
+    return false;
+}
+
+#endif
+
+#ifdef WIZARD
+void wizard_turn_profile()
+{
+    const los_cache_stats &los = get_los_cache_stats();
+    mprf(MSGCH_DIAGNOSTICS, "LOS cache: %" PRIu64 " hits, %" PRIu64
+         " misses, %" PRIu64 " prefilled, %" PRIu64 " invalidated, %" PRIu64
+         " full invalidations", los.hits, los.misses, los.prefilled,
+         los.invalidated, los.full_invalidations);
+
+#ifdef TURN_PROFILER
+    if (!_running)
+    {
+        if (yesno("Start profiling turns?", true, 'n'))
+        {
+            turn_profiler_start();
+            mpr("Profiling turns.");
+        }
+        else
+            canned_msg(MSG_OK);
+        return;
+    }
+
+    for (const string &line : _summary(8, 3))
+        mprf(MSGCH_DIAGNOSTICS, "%s", line.c_str());
+
+    const string trace = catpath(Options.morgue_dir, "turn-profile.json");
+    if (turn_profiler_write_trace(trace))
+        mprf("Wrote a trace of the last %u events to %s.",
+             (unsigned int) min(_next_event, MAX_EVENTS), trace.c_str());
+    else
+        mprf(MSGCH_ERROR, "Couldn't write %s.", trace.c_str());
+
+    if (yesno("Stop profiling turns?", true, 'n'))
+    {
+        turn_profiler_stop();
+        mpr("Stopped profiling turns.");
+    }
+#else
+    mpr("This build has no turn profiler; build with TURN_PROFILER=y.");
+#endif
+}
+#endif
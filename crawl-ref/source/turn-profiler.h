@@ -0,0 +1,103 @@
+/**
+ * @file
+ * @brief Timing of the phases of world_reacts(), for finding slow turns.
+ *
+ * The ring buffer is only compiled in with TURN_PROFILER (make
+ * TURN_PROFILER=y); otherwise TURN_PROFILE does nothing. While profiling,
+ * every TURN_PROFILE scope adds an event with its phase and duration to a
+ * ring buffer of recent events, and monster moves are recorded under their monster type. The buffer can
+ * be summarised with the &N wizard command, or written out in the Chrome
+ * trace event format for chrome://tracing or Perfetto.
+**/
+
+#pragma once
+
+#include <algorithm>
+#include <map>
+#include <string>
+
+#include "monster-type.h"
+#include "spell-type.h"
+#include "unwind.h"
+
+using std::map;
+using std::string;
+
+// Times its scope as the given phase, or as a move by the given monster or a
+// cast of the given spell. This part is in every build, since -arena-bench
+// reports totals from it; it does nothing unless something is recording.
+class turn_profile_scope
+{
+public:
+    turn_profile_scope(const char *phase, monster_type mon = MONS_NO_MONSTER,
+                       spell_type spell = SPELL_NO_SPELL);
+    ~turn_profile_scope();
+
+private:
+    const char *phase;
+    monster_type mon;
+    spell_type spell;
+    int64_t start;  // -1 if nothing is recording
+};
+
+struct turn_profile_total
+{
+    int calls = 0;
+    int64_t nsecs = 0;
+    int64_t max_nsecs = 0;
+
+    void add(int64_t ns)
+    {
+        calls++;
+        nsecs += ns;
+        max_nsecs = std::max(max_nsecs, ns);
+    }
+};
+
+// Start adding up the time spent in each phase and spell, clearing the
+// previous totals. Times are inclusive, so nested scopes count in both.
+void turn_profiler_start_totals();
+void turn_profiler_stop_totals();
+const map<string, turn_profile_total> &turn_profile_phase_totals();
+const map<spell_type, turn_profile_total> &turn_profile_spell_totals();
+
+// Time the rest of the enclosing scope as the given phase, in every build.
+// For the phases -arena-bench reports.
+#define TURN_PROFILE_ALWAYS(phase) \
+    turn_profile_scope CONCAT_TOK(_turn_profile_, __LINE__)(phase)
+// Time the rest of the enclosing scope as a cast of the given spell, in
+// every build.
+#define TURN_PROFILE_SPELL(spell) \
+    turn_profile_scope CONCAT_TOK(_turn_profile_, __LINE__)("mons_cast", \
+                                                            MONS_NO_MONSTER, \
+                                                            (spell))
+
+#ifdef TURN_PROFILER
+
+// Time the rest of the enclosing scope as the given phase.
+# define TURN_PROFILE(phase) TURN_PROFILE_ALWAYS(phase)
+// Time the rest of the enclosing scope as a move by the given monster.
+# define TURN_PROFILE_MONSTER(mons) \
+    turn_profile_scope CONCAT_TOK(_turn_profile_, __LINE__)("monster", \
+                                                            (mons)->type)
+
+// Called by end(): writes what -profile-turns asked for.
+void turn_profiler_exit();
+
+#else
+
+# define TURN_PROFILE(phase) do { } while (false)
+# define TURN_PROFILE_MONSTER(mons) do { } while (false)
+
+#endif
+
+// Whether this build has the profiler.
+bool turn_profiler_available();
+bool turn_profiler_running();
+// Start recording, clearing anything recorded before. If trace_file isn't
+// empty, a trace is written to it and a summary to stderr when crawl exits.
+void turn_profiler_start(const string &trace_file = "");
+void turn_profiler_stop();
+bool turn_profiler_write_trace(const string &filename);
+
+void wizard_turn_profile();
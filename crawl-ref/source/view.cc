@@ -942,6 +942,22 @@ int viewmap_flash_colour()
     return BLACK;
 }
 
+/**
+ * Note that something has changed at a cell, so that the view can't reuse
+ * what it drew there last time.
+ */
+void view_mark_dirty(const coord_def &gc)
+{
+    if (in_bounds(gc))
+        env.map_dirty.set(gc);
+}
+
+/// Note that something may have changed the look of the whole view.
+void view_mark_all_dirty()
+{
+    env.map_all_dirty = true;
+}
+
 // Updates one square of the view area. Should only be called for square
 // in LOS.
 void view_update_at(const coord_def &pos)
@@ -950,6 +966,7 @@ void view_update_at(const coord_def &pos)
         return;
 
     show_update_at(pos);
+    view_mark_dirty(pos);
 #ifdef USE_TILE
     tile_draw_map_cell(pos, true);
 #endif
@@ -1380,7 +1397,8 @@ void run_animation(animation_type anim, use_animation_type type, bool cleanup)
 
 static bool _view_is_updating = false;
 
-crawl_view_buffer view_dungeon(animation *a, bool anim_updates, view_renderer *renderer);
+crawl_view_buffer view_dungeon(animation *a, bool anim_updates,
+                               bool show_updates, view_renderer *renderer);
 
 static bool _viewwindow_should_render()
 {
@@ -1478,7 +1496,8 @@ void viewwindow(bool show_updates, bool tiles_only, animation *a, view_renderer
 
         if (_viewwindow_should_render())
         {
-            const auto vbuf = view_dungeon(a, anim_updates, renderer);
+            const auto vbuf = view_dungeon(a, anim_updates, show_updates,
+                                           renderer);
 
             you.last_view_update = you.num_turns;
 #ifndef USE_TILE_LOCAL
@@ -1654,13 +1673,104 @@ static void add_overlays(const coord_def& gc, screen_cell_t* cell)
     }
 }
 
+// What view_dungeon() drew last time, so that cells which can't have changed
+// since don't have to be drawn again.
+struct view_cache
+{
+    bool valid = false;
+    coord_def size;
+    coord_def origin;
+    coord_def vgrdc;
+    coord_def player;
+    level_id level;
+    layers_type layers = LAYERS_ALL;
+    bool on_level = false;
+    bool weapons = false;
+    bool monster_hp = false;
+    bool blind = false;
+
+    vector<screen_cell_t> cells;
+    // The map knowledge each cell was drawn from.
+    vector<map_cell> knowledge;
+    // Cells that might look different even if nothing has changed: the
+    // player, monsters, and anything with an element colour.
+    vector<bool> varies;
+};
+
+static view_cache _last_view;
+static bool _incremental_view = true;
+static uint64_t _cells_drawn = 0;
+static uint64_t _cells_reused = 0;
+
+/// For benchmarking: whether view_dungeon() may reuse unchanged cells.
+void set_incremental_view(bool incremental)
+{
+    _incremental_view = incremental;
+    _last_view.valid = false;
+}
+
+void view_redraw_stats(uint64_t &drawn, uint64_t &reused)
+{
+    drawn = _cells_drawn;
+    reused = _cells_reused;
+}
+
+static bool _view_cache_matches(const crawl_view_buffer &vbuf)
+{
+    return _last_view.size == vbuf.size()
+           && _last_view.origin == view2grid(coord_def(1, 1))
+           && _last_view.vgrdc == crawl_view.vgrdc
+           && _last_view.player == you.pos()
+           && _last_view.level == level_id::current()
+           && _last_view.layers == _layers
+           && _last_view.on_level == you.on_current_level
+           && _last_view.weapons == crawl_state.viewport_weapons
+           && _last_view.monster_hp == crawl_state.viewport_monster_hp
+           && _last_view.blind == (you.duration[DUR_BLIND] > 0);
+}
+
+static void _reset_view_cache(const crawl_view_buffer &vbuf)
+{
+    const int n = vbuf.size().x * vbuf.size().y;
+    _last_view.size = vbuf.size();
+    _last_view.origin = view2grid(coord_def(1, 1));
+    _last_view.vgrdc = crawl_view.vgrdc;
+    _last_view.player = you.pos();
+    _last_view.level = level_id::current();
+    _last_view.layers = _layers;
+    _last_view.on_level = you.on_current_level;
+    _last_view.weapons = crawl_state.viewport_weapons;
+    _last_view.monster_hp = crawl_state.viewport_monster_hp;
+    _last_view.blind = you.duration[DUR_BLIND] > 0;
+    _last_view.cells.resize(n);
+    _last_view.knowledge.assign(n, map_cell());
+    _last_view.varies.assign(n, true);
+}
+
+// Can the cell at index i of the view be copied from last time?
+static bool _view_cell_unchanged(int i, const coord_def &gc)
+{
+    if (_last_view.varies[i])
+        return false;
+    if (!map_bounds(gc))
+        return true;
+    return !env.map_dirty(gc)
+           && env.map_knowledge(gc) == _last_view.knowledge[i];
+}
+
 /**
  * Constructs the main dungeon view, rendering it into a new crawl_view_buffer.
  *
+ * Cells are only drawn again if they've been marked dirty, their map
+ * knowledge has changed, or they may look different each time; the rest
+ * are copied from the previous view. Anything that changes the whole view
+ * (animations, flashes, overlays, moving the view) draws everything.
+ *
  * @param a[in] the animation to be showing, if any.
  * @return A new view buffer with the rendered content.
  */
-crawl_view_buffer view_dungeon(animation *a, bool anim_updates, view_renderer *renderer)
+crawl_view_buffer view_dungeon(animation *a, bool anim_updates,
+                               bool show_updates, view_renderer *renderer)
 {
     crawl_view_buffer vbuf(crawl_view.viewsz);
 
@@ -1674,23 +1784,72 @@ crawl_view_buffer view_dungeon(animation *a, bool anim_updates, view_renderer *r
     if (flash_colour == BLACK)
         flash_colour = viewmap_flash_colour();
 
+    // These all change cells without marking them, and so must be drawn
+    // over completely, both now and when they're gone.
+    const bool decorated = a || renderer || flash_colour || you.flash_where
+                           || crawl_state.darken_range
+                           || crawl_state.flash_monsters
+#ifdef USE_TILE
+                           || !tile_overlays.empty()
+#endif
+                           || !glyph_overlays.empty();
+#ifdef USE_TILE
+    // Tiles also draw from tile_env, which changes with every show update,
+    // and animate once a turn.
+    const bool tiles_changed = show_updates || anim_updates;
+#else
+    UNUSED(show_updates);
+    const bool tiles_changed = false;
+#endif
+    const bool reuse = _incremental_view && _last_view.valid
+                       && !decorated && !tiles_changed
+                       && !env.map_all_dirty
+                       && _view_cache_matches(vbuf);
+    if (!reuse)
+        _reset_view_cache(vbuf);
+
     const coord_def tl = coord_def(1, 1);
     const coord_def br = vbuf.size();
-    for (rectangle_iterator ri(tl, br); ri; ++ri)
+    int i = 0;
+    for (rectangle_iterator ri(tl, br); ri; ++ri, ++cell, ++i)
     {
         // in grid coords
         const coord_def gc = a
             ? a->cell_cb(view2grid(*ri), flash_colour)
             : view2grid(*ri);
 
+        if (reuse && _view_cell_unchanged(i, gc))
+        {
+            *cell = _last_view.cells[i];
+            _cells_reused++;
+            continue;
+        }
+
+        const unsigned int elements = element_colours_evaluated();
         if (you.flash_where && you.flash_where->is_affected(gc) <= 0)
             draw_cell(cell, gc, anim_updates, 0);
         else
             draw_cell(cell, gc, anim_updates, flash_colour);
+        _cells_drawn++;
 
-        cell++;
+        _last_view.cells[i] = *cell;
+        if (map_bounds(gc))
+        {
+            const map_cell &mc = env.map_knowledge(gc);
+            _last_view.knowledge[i] = mc;
+            _last_view.varies[i] = element_colours_evaluated() != elements
+                                   || gc == you.pos()
+                                   || mc.monsterinfo()
+                                   || mc.flags & MAP_SANCTUARY_2;
+        }
+        else
+            _last_view.varies[i] = element_colours_evaluated() != elements;
     }
 
+    _last_view.valid = !decorated;
+    env.map_dirty.reset();
+    env.map_all_dirty = false;
+
     if (renderer)
         renderer->render(vbuf);
 
@@ -29,6 +29,10 @@ string screenshot();
 int viewmap_flash_colour();
 bool view_update();
 void view_update_at(const coord_def &pos);
+void view_mark_dirty(const coord_def &gc);
+void view_mark_all_dirty();
+void set_incremental_view(bool incremental);
+void view_redraw_stats(uint64_t &drawn, uint64_t &reused);
 class targeter;
 
 static inline void scaled_delay(unsigned int ms)
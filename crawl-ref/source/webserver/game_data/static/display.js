@@ -1,7 +1,7 @@
 define(["jquery", "comm", "./map_knowledge", "./view_data", "./monster_list",
-        "./minimap", "./dungeon_renderer"],
+        "./minimap", "./dungeon_renderer", "./options"],
 function ($, comm, map_knowledge, view_data, monster_list, minimap,
-          dungeon_renderer) {
+          dungeon_renderer, options) {
     "use strict";
 
     function invalidate(minimap_too)
@@ -81,7 +81,10 @@ function ($, comm, map_knowledge, view_data, monster_list, minimap,
             minimap.do_view_center_update(data.vgrdc.x, data.vgrdc.y);
 
         if (data.cells)
-            map_knowledge.merge(data.cells);
+        {
+            map_knowledge.merge(data.cells,
+                                options.get("tile_web_compact_map"));
+        }
 
         // Mark cells overlapped by dirty cells as dirty
         $.each(map_knowledge.dirty().slice(), function (i, loc) {
@@ -197,11 +197,86 @@ define(["jquery", "./enums", "./util"], function ($, enums, util) {
 
     }
 
-    function merge_diff(vals)
+    // Field bits of the compact map format, see _send_cell in tileweb.cc
+    var CCF_FEAT = 1 << 0,
+        CCF_MAP_FEAT = 1 << 1,
+        CCF_GLYPH = 1 << 2,
+        CCF_COLOUR = 1 << 3,
+        CCF_FG = 1 << 4,
+        CCF_BG = 1 << 5,
+        CCF_FLV_FLOOR = 1 << 6,
+        CCF_FLV_SPECIAL = 1 << 7;
+
+    // Turn a compact cell array back into the usual cell object
+    function decode_compact(cell)
+    {
+        var fields = cell[0];
+        var i = 1;
+        var val = {};
+        var t = {};
+        var has_t = false;
+
+        if (fields & CCF_FEAT)
+            val.f = cell[i++];
+        if (fields & CCF_MAP_FEAT)
+            val.mf = cell[i++];
+        if (fields & CCF_GLYPH)
+            val.g = cell[i++];
+        if (fields & CCF_COLOUR)
+            val.col = cell[i++];
+        if (fields & CCF_FG)
+        {
+            t.fg = cell[i++];
+            has_t = true;
+        }
+        if (fields & CCF_BG)
+        {
+            t.bg = cell[i++];
+            has_t = true;
+        }
+        if (fields & CCF_FLV_FLOOR)
+        {
+            t.flv = {f: cell[i++]};
+            if (fields & CCF_FLV_SPECIAL)
+                t.flv.s = cell[i++];
+            has_t = true;
+        }
+
+        if (i < cell.length)
+        {
+            var rest = cell[i];
+            for (var prop in rest)
+            {
+                if (prop == "t")
+                {
+                    for (var tprop in rest.t)
+                        t[tprop] = rest.t[tprop];
+                    has_t = true;
+                }
+                else
+                    val[prop] = rest[prop];
+            }
+        }
+
+        if (has_t)
+            val.t = t;
+        return val;
+    }
+
+    function merge_diff(vals, compact)
     {
         $.each(vals, function (i, val)
                {
-                   merge(val);
+                   if (!compact)
+                       merge(val);
+                   else if (Array.isArray(val))
+                       merge(decode_compact(val));
+                   else
+                   {
+                       // A position for the next cell
+                       merge_last_x = val.x - 1;
+                       merge_last_y = val.y;
+                   }
                });
 
         clean_monster_table();
@@ -35,6 +35,7 @@
 #include "stairs.h" // down_stairs
 #include "state.h"
 #include "traps.h" // do_trap_effects
+#include "turn-profiler.h"
 #include "wizard-option-type.h"
 #include "wiz-dgn.h"
 #include "wiz-dump.h"
@@ -123,7 +124,7 @@ static void _do_wizard_command(int wiz_command)
     // case CONTROL('M'): break; // XXX do not use, menu command
 
     case 'n': wizard_set_zot_clock(); break;
-    // case 'N': break;
+    case 'N': wizard_turn_profile(); break;
     // case CONTROL('N'): break;
 
     case 'o': wizard_create_spec_object(); break;
@@ -519,6 +520,7 @@ int list_wizard_commands(bool do_redraw_screen)
                        "<w>Ctrl-F</w> double scale fsim\n"
                        "<w>Ctrl-I</w> item generation stats\n"
                        "<w>O</w>      measure exploration time\n"
+                       "<w>N</w>      profile turns, LOS cache stats\n"
                        "<w>Ctrl-T</w> dungeon (D)Lua interpreter\n"
                        "<w>Ctrl-U</w> client (C)Lua interpreter\n"
                        "<w>Ctrl-X</w> Xom effect stats\n"